@@ -4,8 +4,10 @@
 #include <list>
 #include <random>
 #include <algorithm>
+#include <array>
 
 #include <leviathan/collections/buffer.hpp>
+#include <leviathan/allocators/realloc_allocator.hpp>
 #include <catch2/catch_all.hpp>
 // #include <catch2/catch_test_macros.hpp>
 
@@ -84,3 +86,132 @@ TEST_CASE("benchmark emplace_back")
         });
     };
 }
+
+struct large_element
+{
+    std::array<int, 64> m_data;
+
+    large_element(int x) { m_data.fill(x); }
+};
+
+TEST_CASE("benchmark emplace_back large element")
+{
+    constexpr int N = 1024 * 16;
+
+    BENCHMARK_ADVANCED("std::vector")(Catch::Benchmark::Chronometer meter) {
+        meter.measure([]{
+            std::vector<large_element> vec;
+            for (int i = 0; i < N; ++i) 
+                vec.emplace_back(i);
+            auto s = vec.size();
+            return s;
+        });
+    };
+
+    BENCHMARK_ADVANCED("buffer")(Catch::Benchmark::Chronometer meter) {
+        meter.measure([]{
+            cpp::collections::buffer<large_element> buffer;
+            std::allocator<large_element> alloc;
+            RAII guard([&](){ buffer.dispose(alloc); });
+            for (int i = 0; i < N; ++i) 
+                buffer.emplace_back(alloc, i);
+            auto s = buffer.size();
+            return s;
+        });
+    };
+
+    BENCHMARK_ADVANCED("buffer with realloc_allocator")(Catch::Benchmark::Chronometer meter) {
+        meter.measure([]{
+            cpp::collections::buffer<large_element> buffer;
+            cpp::alloc::realloc_allocator<large_element> alloc;
+            RAII guard([&](){ buffer.dispose(alloc); });
+            for (int i = 0; i < N; ++i) 
+                buffer.emplace_back(alloc, i);
+            auto s = buffer.size();
+            return s;
+        });
+    };
+}
+
+TEST_CASE("benchmark emplace_back huge buffer")
+{
+    constexpr int N = 1024 * 1024 * 16;
+
+    BENCHMARK_ADVANCED("std::vector")(Catch::Benchmark::Chronometer meter) {
+        meter.measure([]{
+            std::vector<int> vec;
+            for (int i = 0; i < N; ++i) 
+                vec.emplace_back(i);
+            auto s = vec.size();
+            return s;
+        });
+    };
+
+    BENCHMARK_ADVANCED("buffer")(Catch::Benchmark::Chronometer meter) {
+        meter.measure([]{
+            cpp::collections::buffer<int> buffer;
+            AllocatorT alloc;
+            RAII guard([&](){ buffer.dispose(alloc); });
+            for (int i = 0; i < N; ++i) 
+                buffer.emplace_back(alloc, i);
+            auto s = buffer.size();
+            return s;
+        });
+    };
+
+    BENCHMARK_ADVANCED("buffer with realloc_allocator")(Catch::Benchmark::Chronometer meter) {
+        meter.measure([]{
+            cpp::collections::buffer<int> buffer;
+            cpp::alloc::realloc_allocator<int> alloc;
+            RAII guard([&](){ buffer.dispose(alloc); });
+            for (int i = 0; i < N; ++i) 
+                buffer.emplace_back(alloc, i);
+            auto s = buffer.size();
+            return s;
+        });
+    };
+}
+
+template <typename T, typename Fn>
+void insert_and_erase_at_first(const char* name, Fn make)
+{
+    constexpr int N = 1024 * 2;
+
+    BENCHMARK_ADVANCED(std::string("std::vector<") + name + ">")(Catch::Benchmark::Chronometer meter) {
+        meter.measure([&]{
+            std::vector<T> vec;
+            for (int i = 0; i < N; ++i) 
+                vec.emplace(vec.begin(), make(i));
+            for (int i = 0; i < N / 2; ++i) 
+                vec.erase(vec.begin());
+            auto s = vec.size();
+            return s;
+        });
+    };
+
+    BENCHMARK_ADVANCED(std::string("buffer<") + name + ">")(Catch::Benchmark::Chronometer meter) {
+        meter.measure([&]{
+            cpp::collections::buffer<T> buffer;
+            std::allocator<T> alloc;
+            RAII guard([&](){ buffer.dispose(alloc); });
+            for (int i = 0; i < N; ++i) 
+                buffer.emplace(alloc, buffer.begin(), make(i));
+            for (int i = 0; i < N / 2; ++i) 
+                buffer.erase(alloc, buffer.begin());
+            auto s = buffer.size();
+            return s;
+        });
+    };
+}
+
+TEST_CASE("benchmark insert and erase string at first")
+{
+    // std::string is not trivially relocatable, std::unique_ptr is.
+    insert_and_erase_at_first<std::string>("std::string", [](int i) {
+        return std::to_string(i) + std::string(32, 'x');
+    });
+
+    insert_and_erase_at_first<std::unique_ptr<std::string>>("std::unique_ptr<std::string>", [](int i) {
+        return std::make_unique<std::string>(std::to_string(i) + std::string(32, 'x'));
+    });
+}
@@ -291,4 +291,4 @@ TEST_CASE("duplicate_collections_random_insert_string")
     };
 
 }
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
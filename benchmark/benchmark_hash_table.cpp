@@ -0,0 +1,223 @@
+#include "random_range.hpp"
+
+#include <leviathan/collections/hashtable/dictionary.hpp>
+#include <leviathan/collections/hashtable/pyhash.hpp>
+#include <leviathan/extc++/seeded_hash.hpp>
+
+#include <catch2/catch_all.hpp>
+
+#include <unordered_map>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using FlatHashMap = cpp::collections::dictionary<int, int>;
+using PyHashMap = cpp::collections::py_hashtable<
+    cpp::collections::select1st<int, int>, 
+    std::hash<int>, 
+    std::equal_to<int>, 
+    std::allocator<std::pair<const int, int>>>;
+using STLHashMap = std::unordered_map<int, int>;
+
+TEST_CASE("hash_map_random_insert")
+{
+    BENCHMARK("flat hash_table random_insert")
+    {
+        return cpp::random_insert_test2<FlatHashMap>();
+    };
+
+    BENCHMARK("py_hashtable random_insert")
+    {
+        return cpp::random_insert_test2<PyHashMap>();
+    };
+
+    BENCHMARK("std::unordered_map random_insert")
+    {
+        return cpp::random_insert_test2<STLHashMap>();
+    };
+}
+
+TEST_CASE("hash_map_ascend_insert")
+{
+    BENCHMARK("flat hash_table ascend_insert")
+    {
+        return cpp::ascending_insert_test2<FlatHashMap>();
+    };
+
+    BENCHMARK("py_hashtable ascend_insert")
+    {
+        return cpp::ascending_insert_test2<PyHashMap>();
+    };
+
+    BENCHMARK("std::unordered_map ascend_insert")
+    {
+        return cpp::ascending_insert_test2<STLHashMap>();
+    };
+}
+
+TEST_CASE("hash_map_random_search")
+{
+    FlatHashMap flat;
+    PyHashMap py;
+    STLHashMap stl;
+
+    for (auto val : cpp::insertion::random_int)
+    {
+        flat.insert({ val, val });
+        py.insert({ val, val });
+        stl.insert({ val, val });
+    }
+
+    BENCHMARK("flat hash_table search")
+    {
+        return cpp::search_test(flat);
+    };
+
+    BENCHMARK("py_hashtable search")
+    {
+        return cpp::search_test(py);
+    };
+
+    BENCHMARK("std::unordered_map search")
+    {
+        return cpp::search_test(stl);
+    };
+}
+
+TEST_CASE("hash_map_random_remove")
+{
+    FlatHashMap flat;
+    PyHashMap py;
+    STLHashMap stl;
+
+    for (auto val : cpp::insertion::random_int)
+    {
+        flat.insert({ val, val });
+        py.insert({ val, val });
+        stl.insert({ val, val });
+    }
+
+    BENCHMARK("flat hash_table remove")
+    {
+        return cpp::remove_test(flat);
+    };
+
+    BENCHMARK("py_hashtable remove")
+    {
+        return cpp::remove_test(py);
+    };
+
+    BENCHMARK("std::unordered_map remove")
+    {
+        return cpp::remove_test(stl);
+    };
+}
+
+template <typename T, bool CacheHashCode>
+using PyHashSet = cpp::collections::py_hashtable<
+    cpp::collections::identity<T>,
+    std::hash<T>,
+    std::equal_to<T>,
+    std::allocator<T>,
+    cpp::collections::detail::py_hash_generator<>,
+    CacheHashCode>;
+
+// Bytes used by indices and slots, the control bytes are not used by py_hash_generator.
+template <typename T, bool CacheHashCode>
+std::size_t py_hashtable_memory(const PyHashSet<T, CacheHashCode>& s)
+{
+    using slot_type = cpp::collections::hash_cell<T, CacheHashCode>;
+    return s.capacity() * (s.index_width() + sizeof(slot_type));
+}
+
+TEST_CASE("py_hashtable_hash_code_caching")
+{
+    PyHashSet<int, true> cached;
+    PyHashSet<int, false> uncached;
+    cpp::random_insert(cached, uncached);
+
+    std::cout << "int with cached hash code: " << py_hashtable_memory(cached) << " bytes\n"
+              << "int without cached hash code: " << py_hashtable_memory(uncached) << " bytes\n";
+
+    BENCHMARK("int cached search")
+    {
+        return cpp::search_test(cached);
+    };
+
+    BENCHMARK("int uncached search")
+    {
+        return cpp::search_test(uncached);
+    };
+
+    BENCHMARK("string cached random_insert")
+    {
+        return cpp::random_insert_string_test<PyHashSet<std::string, true>>();
+    };
+
+    BENCHMARK("string uncached random_insert")
+    {
+        return cpp::random_insert_string_test<PyHashSet<std::string, false>>();
+    };
+}
+
+TEST_CASE("py_hashtable_batched_search")
+{
+    PyHashMap py;
+
+    for (auto val : cpp::insertion::random_int)
+        py.insert({ val, val });
+
+    std::vector<bool> result;
+    result.reserve(cpp::search::searching.size());
+
+    BENCHMARK("py_hashtable contains")
+    {
+        result.clear();
+        for (auto val : cpp::search::searching) 
+            result.emplace_back(py.contains(val));
+        return result.size();
+    };
+
+    BENCHMARK("py_hashtable contains_many")
+    {
+        result.clear();
+        py.contains_many(cpp::search::searching, std::back_inserter(result));
+        return result.size();
+    };
+}
+
+template <typename Hasher>
+using PyStringSet = cpp::collections::py_hashtable<
+    cpp::collections::identity<std::string>,
+    Hasher,
+    std::equal_to<std::string>,
+    std::allocator<std::string>>;
+
+TEST_CASE("py_hashtable_long_string_hash")
+{
+    std::vector<std::string> keys;
+
+    for (int i = 0; i < 10'000; ++i)
+    {
+        auto key = std::string(1024, 'k');
+        auto suffix = std::to_string(i);
+        key.replace(key.size() - suffix.size(), suffix.size(), suffix);
+        keys.emplace_back(std::move(key));
+    }
+
+    auto insert = [&]<typename Set>(std::type_identity<Set>) {
+        Set s;
+        for (const auto& key : keys) s.insert(key);
+        return s.size();
+    };
+
+    BENCHMARK("std::hash 1KB random_insert")
+    {
+        return insert(std::type_identity<PyStringSet<std::hash<std::string>>>());
+    };
+
+    BENCHMARK("cpp::seeded_hash 1KB random_insert")
+    {
+        return insert(std::type_identity<PyStringSet<cpp::seeded_hash>>());
+    };
+}
@@ -0,0 +1,132 @@
+#include <set>
+#include <catch2/catch_all.hpp>
+#include <leviathan/collections/list/skip_list.hpp>
+#include <leviathan/collections/list/blocked_skip_list.hpp>
+#include "random_range.hpp"
+
+using SkipList = cpp::collections::skip_set<int>;
+using BlockedSkipList = cpp::collections::blocked_skip_set<int>;
+using STLRedBlackTree = std::set<int>;
+
+TEST_CASE("skip_list_random_insert")
+{
+    BENCHMARK("skip list random_insert")
+    {
+        return cpp::random_insert_test<SkipList>();
+    };
+
+    BENCHMARK("blocked skip list random_insert")
+    {
+        return cpp::random_insert_test<BlockedSkipList>();
+    };
+
+    BENCHMARK("stl set random_insert")
+    {
+        return cpp::random_insert_test<STLRedBlackTree>();
+    };
+}
+
+TEST_CASE("skip_list_ascend_insert")
+{
+    BENCHMARK("skip list ascend_insert")
+    {
+        return cpp::ascending_insert_test<SkipList>();
+    };
+
+    BENCHMARK("blocked skip list ascend_insert")
+    {
+        return cpp::ascending_insert_test<BlockedSkipList>();
+    };
+
+    BENCHMARK("stl set ascend_insert")
+    {
+        return cpp::ascending_insert_test<STLRedBlackTree>();
+    };
+}
+
+TEST_CASE("skip_list_random_search")
+{
+    SkipList sl;
+    BlockedSkipList bsl;
+    STLRedBlackTree stlrb;
+
+    cpp::random_insert(sl, bsl, stlrb);
+
+    BENCHMARK("skip list random_search")
+    {
+        return cpp::search_test<SkipList>(sl);
+    };
+
+    BENCHMARK("blocked skip list random_search")
+    {
+        return cpp::search_test<BlockedSkipList>(bsl);
+    };
+
+    BENCHMARK("stl set random_search")
+    {
+        return cpp::search_test<STLRedBlackTree>(stlrb);
+    };
+}
+
+TEST_CASE("skip_list_range_scan")
+{
+    SkipList sl;
+    BlockedSkipList bsl;
+    STLRedBlackTree stlrb;
+
+    cpp::random_insert(sl, bsl, stlrb);
+
+    BENCHMARK("skip list range_scan(10)")
+    {
+        return cpp::range_scan_test<SkipList>(sl, 10);
+    };
+
+    BENCHMARK("blocked skip list range_scan(10)")
+    {
+        return cpp::range_scan_test<BlockedSkipList>(bsl, 10);
+    };
+
+    BENCHMARK("stl set range_scan(10)")
+    {
+        return cpp::range_scan_test<STLRedBlackTree>(stlrb, 10);
+    };
+
+    BENCHMARK("skip list range_scan(100)")
+    {
+        return cpp::range_scan_test<SkipList>(sl, 100);
+    };
+
+    BENCHMARK("blocked skip list range_scan(100)")
+    {
+        return cpp::range_scan_test<BlockedSkipList>(bsl, 100);
+    };
+
+    BENCHMARK("stl set range_scan(100)")
+    {
+        return cpp::range_scan_test<STLRedBlackTree>(stlrb, 100);
+    };
+}
+
+TEST_CASE("skip_list_random_remove")
+{
+    SkipList sl;
+    BlockedSkipList bsl;
+    STLRedBlackTree stlrb;
+
+    cpp::random_insert(sl, bsl, stlrb);
+
+    BENCHMARK("skip list random_remove")
+    {
+        return cpp::remove_test<SkipList>(sl);
+    };
+
+    BENCHMARK("blocked skip list random_remove")
+    {
+        return cpp::remove_test<BlockedSkipList>(bsl);
+    };
+
+    BENCHMARK("stl set random_remove")
+    {
+        return cpp::remove_test<STLRedBlackTree>(stlrb);
+    };
+}
@@ -6,12 +6,17 @@
 #include <leviathan/collections/tree/red_black_tree.hpp>
 // #include <leviathan/collections/tree/red_black_node_from_stlibc++.hpp>
 #include <leviathan/collections/tree/treap.hpp>
+#include <leviathan/collections/tree/btree.hpp>
+#include <leviathan/allocators/node_pool_allocator.hpp>
 #include "random_range.hpp"
 
 using AVLTree = cpp::collections::avl_treeset<int>;
 using RedBlackTree = cpp::collections::red_black_treeset<int>;
 using STLRedBlackTree = std::set<int>;
 using TreapTree = cpp::collections::treap_set<int>;
+using BTree = cpp::collections::btree_set<int>;
+using PoolAVLTree = cpp::collections::avl_treeset<int, std::less<int>, cpp::alloc::node_pool_allocator<int>>;
+using PoolRedBlackTree = cpp::collections::red_black_treeset<int, std::less<int>, cpp::alloc::node_pool_allocator<int>>;
 
 TEST_CASE("duplicate_collections_random_insert")
 {
@@ -34,6 +39,21 @@ TEST_CASE("duplicate_collections_random_insert")
     {
         return cpp::random_insert_test<TreapTree>();
     };
+
+    BENCHMARK("btree random_insert")
+    {
+        return cpp::random_insert_test<BTree>();
+    };
+
+    BENCHMARK("avl(node pool) random_insert")
+    {
+        return cpp::random_insert_test<PoolAVLTree>();
+    };
+
+    BENCHMARK("red black(node pool) random_insert")
+    {
+        return cpp::random_insert_test<PoolRedBlackTree>();
+    };
 }
 
 TEST_CASE("duplicate_collections_ascend_insert")
@@ -57,6 +77,29 @@ TEST_CASE("duplicate_collections_ascend_insert")
     {
         return cpp::ascending_insert_test<TreapTree>();
     };
+
+    BENCHMARK("btree ascend_insert")
+    {
+        return cpp::ascending_insert_test<BTree>();
+    };
+}
+
+TEST_CASE("duplicate_collections_ascend_insert_with_hint")
+{
+    BENCHMARK("avl ascend_insert_with_hint")
+    {
+        return cpp::ascending_insert_with_hint_test<AVLTree>();
+    };
+
+    BENCHMARK("red black ascend_insert_with_hint")
+    {
+        return cpp::ascending_insert_with_hint_test<RedBlackTree>();
+    };
+
+    BENCHMARK("stl set ascend_insert_with_hint")
+    {
+        return cpp::ascending_insert_with_hint_test<STLRedBlackTree>();
+    };
 }
 
 TEST_CASE("duplicate_collections_descend_insert")
@@ -80,6 +123,11 @@ TEST_CASE("duplicate_collections_descend_insert")
     {
         return cpp::descending_insert_test<TreapTree>();
     };
+
+    BENCHMARK("btree descend_insert")
+    {
+        return cpp::descending_insert_test<BTree>();
+    };
 }
 
 TEST_CASE("duplicate_collections_random_insert_string")
@@ -88,6 +136,8 @@ TEST_CASE("duplicate_collections_random_insert_string")
     using RedBlackTree = cpp::collections::red_black_treeset<std::string>;
     using STLRedBlackTree = std::set<std::string>;
     using TreapTree = cpp::collections::treap_set<std::string>;
+    using BTree = cpp::collections::btree_set<std::string>;
+    using PoolRedBlackTree = cpp::collections::red_black_treeset<std::string, std::less<std::string>, cpp::alloc::node_pool_allocator<std::string>>;
 
     BENCHMARK("avl random_insert")
     {
@@ -108,6 +158,16 @@ TEST_CASE("duplicate_collections_random_insert_string")
     {
         return cpp::random_insert_string_test<TreapTree>();
     };
+
+    BENCHMARK("btree random_insert")
+    {
+        return cpp::random_insert_string_test<BTree>();
+    };
+
+    BENCHMARK("red black(node pool) random_insert")
+    {
+        return cpp::random_insert_string_test<PoolRedBlackTree>();
+    };
 }
 
 TEST_CASE("duplicate_collections_random_search")
@@ -116,8 +176,9 @@ TEST_CASE("duplicate_collections_random_search")
     RedBlackTree rb;
     STLRedBlackTree stlrb;
     TreapTree treap;
+    BTree btree;
 
-    cpp::random_insert(avl, rb, stlrb, treap);
+    cpp::random_insert(avl, rb, stlrb, treap, btree);
 
     BENCHMARK("avl random_search")
     {
@@ -138,6 +199,11 @@ TEST_CASE("duplicate_collections_random_search")
     {
         return cpp::search_test<TreapTree>(treap);
     };
+
+    BENCHMARK("btree random_search")
+    {
+        return cpp::search_test<BTree>(btree);
+    };
 }
 
 TEST_CASE("duplicate_collections_random_remove")
@@ -146,8 +212,11 @@ TEST_CASE("duplicate_collections_random_remove")
     RedBlackTree rb;
     STLRedBlackTree stlrb;
     TreapTree treap;
+    BTree btree;
+    PoolAVLTree pool_avl;
+    PoolRedBlackTree pool_rb;
 
-    cpp::random_insert(avl, rb, stlrb, treap);
+    cpp::random_insert(avl, rb, stlrb, treap, btree, pool_avl, pool_rb);
 
     BENCHMARK("avl random_remove")
     {
@@ -168,5 +237,20 @@ TEST_CASE("duplicate_collections_random_remove")
     {
         return cpp::remove_test<TreapTree>(treap);
     };
+
+    BENCHMARK("btree random_remove")
+    {
+        return cpp::remove_test<BTree>(btree);
+    };
+
+    BENCHMARK("avl(node pool) random_remove")
+    {
+        return cpp::remove_test<PoolAVLTree>(pool_avl);
+    };
+
+    BENCHMARK("red black(node pool) random_remove")
+    {
+        return cpp::remove_test<PoolRedBlackTree>(pool_rb);
+    };
 }
 
@@ -157,6 +157,15 @@ namespace cpp
         return s.size();
     }
 
+    template <typename Set>
+    auto ascending_insert_with_hint_test()
+    {
+        Set s;
+        for (auto val : insertion::ascending) s.insert(s.end(), val);
+        assert(s.size() <= default_num);
+        return s.size();
+    }
+
     template <typename Set>
     auto descending_insert_test()
     {
@@ -176,6 +185,21 @@ namespace cpp
         return cnt;
     }
 
+    // Visit length elements from each searched key.
+    template <typename Set>
+    auto range_scan_test(const Set& s, int length = 100)
+    {
+        assert(s.size() > 0);
+        long long sum = 0;
+        for (auto val : search::searching)
+        {
+            auto it = s.lower_bound(val);
+            for (int i = 0; i < length && it != s.end(); ++i, ++it)
+                sum += *it;
+        }
+        return sum;
+    }
+
     template <typename Set>
     auto remove_test(Set& s)
     {
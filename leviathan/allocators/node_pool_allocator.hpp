@@ -0,0 +1,423 @@
+/**
+ * A fixed-size, size-class pool allocator for node based containers.
+ *
+ * Containers such as tree and skip_list allocate and deallocate one node at
+ * a time, and each call goes to the general purpose allocator. The pool here
+ * rounds each request up to a size class, carves blocks of that size from
+ * large slab chunks and keeps the freed blocks in a free-list, so allocation
+ * and deallocation are only a few pointer operations.
+ *
+ * node_pool is the single-threaded pool. node_pool_allocator is a stateless
+ * allocator on top of a process-wide pool, it can be passed to the containers
+ * directly, e.g. avl_treeset<int, std::less<int>, node_pool_allocator<int>>.
+ * With ThreadLocalCache, each thread keeps a small cache of free blocks for
+ * each size class and only locks the shared pool when the cache is empty or
+ * full.
+ *
+ * The chunks of the process-wide pool are never returned to the system.
+*/
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace cpp::alloc
+{
+
+namespace detail
+{
+
+// The memory of a free block is reused as the link of free-list.
+struct free_block
+{
+    free_block* m_next;
+};
+
+/**
+ * @brief Blocks with the same size carved from slab chunks.
+ *
+ * The block size is passed by the owner so that the pool can be placed in an
+ * array without any extra field.
+*/
+class fixed_size_pool
+{
+    struct alignas(std::max_align_t) chunk
+    {
+        chunk* m_next;
+    };
+
+public:
+
+    static constexpr std::size_t chunk_size = 64 * 1024;
+
+    fixed_size_pool() = default;
+
+    fixed_size_pool(const fixed_size_pool&) = delete;
+    fixed_size_pool& operator=(const fixed_size_pool&) = delete;
+
+    ~fixed_size_pool()
+    {
+        release();
+    }
+
+    void* allocate(std::size_t block_size)
+    {
+        if (m_free)
+        {
+            return std::exchange(m_free, m_free->m_next);
+        }
+
+        if (m_end - m_cursor < static_cast<std::ptrdiff_t>(block_size))
+        {
+            add_chunk(block_size);
+        }
+
+        // The blocks of the newest chunk are handed out in order, so the untouched
+        // part of chunk will never be written.
+        return std::exchange(m_cursor, m_cursor + block_size);
+    }
+
+    void deallocate(void* p)
+    {
+        auto block = static_cast<free_block*>(p);
+        block->m_next = m_free;
+        m_free = block;
+    }
+
+    // Return all chunks to the system, all blocks allocated from the pool are invalid.
+    void release()
+    {
+        while (m_chunks)
+        {
+            auto next = m_chunks->m_next;
+            ::operator delete(m_chunks);
+            m_chunks = next;
+        }
+
+        m_free = nullptr;
+        m_cursor = m_end = nullptr;
+    }
+
+private:
+
+    void add_chunk(std::size_t block_size)
+    {
+        // Each chunk contains at least one block.
+        const auto size = std::max(chunk_size, sizeof(chunk) + block_size);
+        auto c = static_cast<chunk*>(::operator new(size));
+
+        c->m_next = m_chunks;
+        m_chunks = c;
+        m_cursor = reinterpret_cast<std::byte*>(c) + sizeof(chunk);
+        m_end = reinterpret_cast<std::byte*>(c) + size;
+    }
+
+    free_block* m_free = nullptr;
+    std::byte* m_cursor = nullptr;
+    std::byte* m_end = nullptr;
+    chunk* m_chunks = nullptr;
+};
+
+} // namespace detail
+
+/**
+ * @brief Single-threaded pool with size classes of multiple of alignment.
+ *
+ * The requests which are larger than max_block_size or over-aligned are
+ * forwarded to global operator new.
+*/
+class node_pool
+{
+public:
+
+    static constexpr std::size_t alignment = alignof(std::max_align_t);
+    static constexpr std::size_t max_block_size = 512;
+    static constexpr std::size_t class_count = max_block_size / alignment;
+
+    static constexpr bool is_pooled(std::size_t bytes, std::size_t align)
+    {
+        return bytes <= max_block_size && align <= alignment;
+    }
+
+    // The index of size class for bytes, bytes should not be greater than max_block_size.
+    static constexpr std::size_t size_class(std::size_t bytes)
+    {
+        return bytes == 0 ? 0 : (bytes - 1) / alignment;
+    }
+
+    static constexpr std::size_t block_size(std::size_t size_class)
+    {
+        return (size_class + 1) * alignment;
+    }
+
+    node_pool() = default;
+
+    node_pool(const node_pool&) = delete;
+    node_pool& operator=(const node_pool&) = delete;
+
+    [[nodiscard]] void* allocate(std::size_t bytes, std::size_t align = alignment)
+    {
+        if (!is_pooled(bytes, align))
+        {
+            return ::operator new(bytes, std::align_val_t(align));
+        }
+
+        const auto c = size_class(bytes);
+        return m_pools[c].allocate(block_size(c));
+    }
+
+    void deallocate(void* p, std::size_t bytes, std::size_t align = alignment)
+    {
+        if (!is_pooled(bytes, align))
+        {
+            ::operator delete(p, bytes, std::align_val_t(align));
+        }
+        else
+        {
+            m_pools[size_class(bytes)].deallocate(p);
+        }
+    }
+
+    // Allocate n blocks of size class c and link them as a list.
+    detail::free_block* allocate_list(std::size_t c, std::size_t n)
+    {
+        detail::free_block* list = nullptr;
+
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            auto block = static_cast<detail::free_block*>(m_pools[c].allocate(block_size(c)));
+            block->m_next = list;
+            list = block;
+        }
+
+        return list;
+    }
+
+    // Return a list of blocks of size class c.
+    void deallocate_list(std::size_t c, detail::free_block* list)
+    {
+        while (list)
+        {
+            m_pools[c].deallocate(std::exchange(list, list->m_next));
+        }
+    }
+
+    // Return all chunks to the system.
+    void release()
+    {
+        for (auto& pool : m_pools)
+        {
+            pool.release();
+        }
+    }
+
+private:
+
+    detail::fixed_size_pool m_pools[class_count];
+};
+
+namespace detail
+{
+
+// The pool shared by all threads.
+class synchronized_node_pool
+{
+public:
+
+    // The pool is never destroyed since the thread caches may return blocks
+    // to it after static objects are destroyed.
+    static synchronized_node_pool& instance()
+    {
+        static auto pool = new synchronized_node_pool();
+        return *pool;
+    }
+
+    void* allocate(std::size_t bytes, std::size_t align)
+    {
+        std::lock_guard lock(m_lock);
+        return m_pool.allocate(bytes, align);
+    }
+
+    void deallocate(void* p, std::size_t bytes, std::size_t align)
+    {
+        std::lock_guard lock(m_lock);
+        m_pool.deallocate(p, bytes, align);
+    }
+
+    free_block* allocate_list(std::size_t c, std::size_t n)
+    {
+        std::lock_guard lock(m_lock);
+        return m_pool.allocate_list(c, n);
+    }
+
+    void deallocate_list(std::size_t c, free_block* list)
+    {
+        std::lock_guard lock(m_lock);
+        m_pool.deallocate_list(c, list);
+    }
+
+private:
+
+    std::mutex m_lock;
+    node_pool m_pool;
+};
+
+// Free blocks cached by current thread, the blocks are fetched from and returned
+// to the shared pool in batches.
+class thread_node_cache
+{
+    struct bin
+    {
+        free_block* m_head = nullptr;
+        std::size_t m_count = 0;
+    };
+
+public:
+
+    static constexpr std::size_t batch_size = 32;
+
+    static thread_node_cache& instance()
+    {
+        thread_local thread_node_cache cache;
+        return cache;
+    }
+
+    ~thread_node_cache()
+    {
+        auto& pool = synchronized_node_pool::instance();
+
+        for (std::size_t c = 0; c < node_pool::class_count; ++c)
+        {
+            pool.deallocate_list(c, m_bins[c].m_head);
+        }
+    }
+
+    void* allocate(std::size_t bytes, std::size_t align)
+    {
+        if (!node_pool::is_pooled(bytes, align))
+        {
+            return ::operator new(bytes, std::align_val_t(align));
+        }
+
+        const auto c = node_pool::size_class(bytes);
+        auto& b = m_bins[c];
+
+        if (!b.m_head)
+        {
+            b.m_head = synchronized_node_pool::instance().allocate_list(c, batch_size);
+            b.m_count = batch_size;
+        }
+
+        --b.m_count;
+        return std::exchange(b.m_head, b.m_head->m_next);
+    }
+
+    void deallocate(void* p, std::size_t bytes, std::size_t align)
+    {
+        if (!node_pool::is_pooled(bytes, align))
+        {
+            ::operator delete(p, bytes, std::align_val_t(align));
+            return;
+        }
+
+        const auto c = node_pool::size_class(bytes);
+        auto& b = m_bins[c];
+        auto block = static_cast<free_block*>(p);
+
+        block->m_next = b.m_head;
+        b.m_head = block;
+
+        // Keep at most 2 * batch_size blocks, so a thread that only deallocates
+        // will not hold all the memory.
+        if (++b.m_count == 2 * batch_size)
+        {
+            auto last = b.m_head;
+
+            for (std::size_t i = 1; i < batch_size; ++i)
+            {
+                last = last->m_next;
+            }
+
+            auto rest = std::exchange(last->m_next, nullptr);
+            synchronized_node_pool::instance().deallocate_list(c, std::exchange(b.m_head, rest));
+            b.m_count -= batch_size;
+        }
+    }
+
+private:
+
+    bin m_bins[node_pool::class_count];
+};
+
+} // namespace detail
+
+/**
+ * @brief Stateless allocator backed by the process-wide node pool.
+ *
+ * It is rebind-aware, containers which allocate their nodes as variable
+ * size byte arrays(e.g. skip_list) are served by the size classes as well.
+ *
+ * @param T Value type.
+ * @param ThreadLocalCache If true, each thread caches some free blocks,
+ *  otherwise every allocation and deallocation locks the shared pool.
+*/
+template <typename T, bool ThreadLocalCache = true>
+class node_pool_allocator
+{
+    static auto& resource()
+    {
+        if constexpr (ThreadLocalCache)
+        {
+            return detail::thread_node_cache::instance();
+        }
+        else
+        {
+            return detail::synchronized_node_pool::instance();
+        }
+    }
+
+public:
+
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using is_always_equal = std::true_type;
+
+    template <typename U>
+    struct rebind { using other = node_pool_allocator<U, ThreadLocalCache>; };
+
+    constexpr node_pool_allocator() noexcept = default;
+
+    template <typename U>
+    constexpr node_pool_allocator(const node_pool_allocator<U, ThreadLocalCache>&) noexcept { }
+
+    [[nodiscard]] T* allocate(size_type n)
+    {
+        if (n > std::numeric_limits<size_type>::max() / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+
+        return static_cast<T*>(resource().allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_type n) noexcept
+    {
+        resource().deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    template <typename U>
+    constexpr bool operator==(const node_pool_allocator<U, ThreadLocalCache>&) const noexcept
+    {
+        return true;
+    }
+};
+
+} // namespace cpp::alloc
+
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace cpp::alloc
+{
+
+/**
+ * @brief An allocator which can resize the memory it allocated.
+ *
+ *  Small blocks come from std::malloc and are resized by std::realloc. On Linux,
+ *  blocks of at least LargeBlockSize bytes are mapped by mmap and resized by
+ *  mremap, which moves the pages instead of copying them, so doubling a huge
+ *  buffer does not copy its content.
+ *
+ *  Containers such as buffer use reallocate to grow when the elements are
+ *  trivially relocatable.
+ *
+ * @param T The type of element that will be allocated.
+ * @param LargeBlockSize Blocks of at least this size are mapped.
+*/
+template <typename T, std::size_t LargeBlockSize = 1024 * 1024>
+class realloc_allocator
+{
+    static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned type is not supported.");
+
+public:
+
+    using value_type = T;
+    using size_type = std::size_t;
+    using is_always_equal = std::true_type;
+
+    template <typename U>
+    struct rebind { using other = realloc_allocator<U, LargeBlockSize>; };
+
+    constexpr realloc_allocator() = default;
+
+    template <typename U>
+    constexpr realloc_allocator(const realloc_allocator<U, LargeBlockSize>&) noexcept { }
+
+    [[nodiscard]] T* allocate(size_type n)
+    {
+        const auto bytes = n * sizeof(T);
+        void* p = is_large(bytes) ? map(bytes) : std::malloc(std::max<size_type>(bytes, 1));
+
+        if (!p)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, size_type n)
+    {
+        const auto bytes = n * sizeof(T);
+
+        if (is_large(bytes))
+        {
+            unmap(p, bytes);
+        }
+        else
+        {
+            std::free(p);
+        }
+    }
+
+    /**
+     * @brief: Resize the memory allocated by allocate(n) to hold new_n elements.
+     *
+     *  The memory may be moved, the first min(n, new_n) elements are copied bytewise.
+     *
+     * @return: Pointer to the resized memory.
+     * @exception: std::bad_alloc and the memory pointed by p is unchanged.
+    */
+    [[nodiscard]] T* reallocate(T* p, size_type n, size_type new_n)
+    {
+        const auto bytes = n * sizeof(T);
+        const auto new_bytes = new_n * sizeof(T);
+
+        void* result = nullptr;
+
+        if (!is_large(bytes) && !is_large(new_bytes))
+        {
+            result = std::realloc(static_cast<void*>(p), std::max<size_type>(new_bytes, 1));
+        }
+#if defined(__linux__)
+        else if (is_large(bytes) && is_large(new_bytes))
+        {
+            result = ::mremap(static_cast<void*>(p), page_ceil(bytes), page_ceil(new_bytes), MREMAP_MAYMOVE);
+            result = result == MAP_FAILED ? nullptr : result;
+        }
+#endif
+        else
+        {
+            // The memory moves between malloc and mmap.
+            result = allocate(new_n);
+            std::memcpy(result, static_cast<void*>(p), std::min(bytes, new_bytes));
+            deallocate(p, n);
+        }
+
+        if (!result)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(result);
+    }
+
+    constexpr friend bool operator==(const realloc_allocator&, const realloc_allocator&)
+    { return true; }
+
+private:
+
+#if defined(__linux__)
+
+    static constexpr bool is_large(size_type bytes)
+    { return bytes >= LargeBlockSize; }
+
+    static size_type page_ceil(size_type bytes)
+    {
+        static const auto page = static_cast<size_type>(::sysconf(_SC_PAGESIZE));
+        return (bytes + page - 1) / page * page;
+    }
+
+    static void* map(size_type bytes)
+    {
+        auto p = ::mmap(nullptr, page_ceil(bytes), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return p == MAP_FAILED ? nullptr : p;
+    }
+
+    static void unmap(void* p, size_type bytes)
+    { ::munmap(p, page_ceil(bytes)); }
+
+#else
+
+    static constexpr bool is_large(size_type)
+    { return false; }
+
+    static void* map(size_type)
+    { return nullptr; }
+
+    static void unmap(void*, size_type) { }
+
+#endif
+
+};
+
+} // namespace cpp::alloc
+
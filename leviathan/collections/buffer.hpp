@@ -3,6 +3,7 @@
 #include "common.hpp"
 
 #include <memory>
+#include <cstring>
 #include <algorithm>
 #include <initializer_list>
 #include <assert.h>
@@ -31,6 +32,25 @@ struct buffer
     template <typename Allocator>
     using rebind_traits = typename std::allocator_traits<Allocator>::template rebind_traits<T>;
 
+    // Return true if elements can be moved by std::memmove, see is_trivially_relocatable.
+    template <typename Allocator>
+    static constexpr bool use_memmove()
+    {
+        if constexpr (detail::relocate_by_memcpy<T, Allocator>)
+        {
+            return !std::is_constant_evaluated();
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    static void move_bytes(pointer dest, const_pointer source, size_t n)
+    {
+        std::memmove(static_cast<void*>(dest), static_cast<const void*>(source), n * sizeof(T));
+    }
+
     pointer m_start = nullptr;
     pointer m_finish = nullptr;
     pointer m_end_of_storage = nullptr;
@@ -223,6 +243,35 @@ struct buffer
         {
             const auto dist = std::distance(first, last);
             try_expand(alloc, dist + size());
+
+            if (use_memmove<Allocator>())
+            {
+                // Open a gap at the position and construct elements in it.
+                auto dest = m_start + d1;
+                auto cur = dest;
+                move_bytes(dest + dist, dest, d2 - d1);
+
+                try
+                {
+                    for (; first != last; ++first, ++cur)
+                    {
+                        rebind_traits<Allocator>::construct(alloc, cur, *first);
+                    }
+                }
+                catch (...)
+                {
+                    for (; cur != dest;)
+                    {
+                        rebind_traits<Allocator>::destroy(alloc, --cur);
+                    }
+                    move_bytes(dest, dest + dist, d2 - d1);
+                    throw;
+                }
+
+                m_finish += dist;
+                return dest;
+            }
+
             for (; first != last; ++first)
             {
                 rebind_traits<Allocator>::construct(alloc, m_finish++, *first);
@@ -250,6 +299,15 @@ struct buffer
         auto alloc = detail::rebind_allocator<T>(allocator);
 
         iterator dest = const_cast<iterator>(pos);
+
+        if (use_memmove<Allocator>())
+        {
+            rebind_traits<Allocator>::destroy(alloc, dest);
+            move_bytes(dest, dest + 1, m_finish - dest - 1);
+            --m_finish;
+            return dest;
+        }
+
         std::move(dest + 1, m_finish, dest);
         // Remove last element
         rebind_traits<Allocator>::destroy(alloc, --m_finish);
@@ -276,6 +334,21 @@ struct buffer
             return dest;
         }
 
+        if (use_memmove<Allocator>())
+        {
+            iterator dest = const_cast<iterator>(first);
+            iterator tail = const_cast<iterator>(last);
+
+            for (auto ptr = dest; ptr != tail; ++ptr)
+            {
+                rebind_traits<Allocator>::destroy(alloc, ptr);
+            }
+
+            move_bytes(dest, tail, m_finish - tail);
+            m_finish -= tail - dest;
+            return dest;
+        }
+
         // Move [last, m_finish) to [first, first + (last - first)) and 
         // erase [first + (last - first), m_finish)
         std::move(const_cast<iterator>(last), end(), const_cast<iterator>(first));
@@ -322,6 +395,24 @@ struct buffer
         {
             auto dest = m_start + dist;
 
+            if (use_memmove<Allocator>())
+            {
+                move_bytes(dest + 1, dest, m_finish - dest);
+
+                try
+                {
+                    rebind_traits<Allocator>::construct(alloc, dest, *handle);
+                }
+                catch (...)
+                {
+                    move_bytes(dest, dest + 1, m_finish - dest);
+                    throw;
+                }
+
+                ++m_finish;
+                return dest;
+            }
+
             // What if an exception is thrown when moving?
             rebind_traits<Allocator>::construct(alloc, m_finish, std::move(*(m_finish - 1)));
             std::move_backward(dest, m_finish - 1, m_finish);
@@ -359,6 +450,12 @@ struct buffer
         assert(std::popcount(n) == 1);
         auto alloc = detail::rebind_allocator<T>(allocator);
 
+        if (use_memmove<Allocator>())
+        {
+            relocate_storage(alloc, n);
+            return;
+        }
+
         buffer new_buffer(alloc, n);
 
         // There are two situations:
@@ -387,6 +484,37 @@ struct buffer
         new_buffer.swap(*this);
     }
 
+    // Move elements to a storage of n elements bytewise. If the allocator supports
+    // reallocate, the memory can be resized in place without copying.
+    template <typename Allocator>
+    void relocate_storage(Allocator& allocator, size_t n)
+    {
+        auto alloc = detail::rebind_allocator<T>(allocator);
+        const auto sz = size();
+        pointer start;
+
+        if constexpr (detail::reallocatable_allocator<decltype(alloc)>)
+        {
+            start = m_start
+                  ? alloc.reallocate(m_start, capacity(), n)
+                  : rebind_traits<Allocator>::allocate(alloc, n);
+        }
+        else
+        {
+            start = rebind_traits<Allocator>::allocate(alloc, n);
+
+            if (m_start)
+            {
+                move_bytes(start, m_start, sz);
+                rebind_traits<Allocator>::deallocate(alloc, m_start, capacity());
+            }
+        }
+
+        m_start = start;
+        m_finish = start + sz;
+        m_end_of_storage = start + n;
+    }
+
     template <typename Allocator>
     constexpr void try_expand(Allocator& allocator, size_t n)
     {
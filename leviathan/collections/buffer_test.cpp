@@ -392,3 +392,75 @@ TEST_CASE("pmr::allocator")
 
 
 
+#include <leviathan/allocators/realloc_allocator.hpp>
+
+static_assert(cpp::collections::is_trivially_relocatable_v<std::unique_ptr<int>>);
+static_assert(cpp::collections::is_trivially_relocatable_v<std::pair<int, std::unique_ptr<int>>>);
+static_assert(!cpp::collections::detail::relocate_by_memcpy<int, std::pmr::polymorphic_allocator<int>>);
+
+template <typename Allocator>
+void relocatable_test()
+{
+    using T = std::unique_ptr<int>;
+    using Buffer = cpp::collections::buffer<T>;
+
+    Allocator alloc;
+    Buffer buffer;
+    std::vector<int> expected;
+
+    for (int i = 0; i < 5000; ++i)
+    {
+        buffer.emplace_back(alloc, std::make_unique<int>(i));
+        expected.emplace_back(i);
+    }
+
+    buffer.emplace(alloc, buffer.begin() + 10, std::make_unique<int>(-1));
+    expected.insert(expected.begin() + 10, -1);
+
+    buffer.erase(alloc, buffer.begin() + 3);
+    expected.erase(expected.begin() + 3);
+
+    buffer.erase(alloc, buffer.begin() + 100, buffer.begin() + 200);
+    expected.erase(expected.begin() + 100, expected.begin() + 200);
+
+    REQUIRE(buffer.size() == expected.size());
+
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        REQUIRE(*buffer[i] == expected[i]);
+    }
+
+    buffer.dispose(alloc);
+}
+
+TEST_CASE("trivially relocatable")
+{
+    relocatable_test<std::allocator<std::unique_ptr<int>>>();
+    relocatable_test<cpp::alloc::realloc_allocator<std::unique_ptr<int>, 4096>>();
+}
+
+TEST_CASE("realloc_allocator")
+{
+    using Allocator = cpp::alloc::realloc_allocator<int, 4096>;
+    using Buffer = cpp::collections::buffer<int>;
+
+    Allocator alloc;
+    Buffer buffer;
+    std::vector<int> expected;
+
+    for (int i = 0; i < 100000; ++i)
+    {
+        buffer.emplace_back(alloc, i);
+        expected.emplace_back(i);
+    }
+
+    int values[] = { -1, -2, -3 };
+    buffer.insert(alloc, buffer.begin() + 5, std::begin(values), std::end(values));
+    expected.insert(expected.begin() + 5, std::begin(values), std::end(values));
+
+    buffer.erase(alloc, buffer.begin() + 1000, buffer.begin() + 2000);
+    expected.erase(expected.begin() + 1000, expected.begin() + 2000);
+
+    REQUIRE(std::ranges::equal(buffer, expected));
+    buffer.dispose(alloc);
+}
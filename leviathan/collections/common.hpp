@@ -7,6 +7,7 @@
 #include <optional>
 #include <ranges>
 #include <concepts>
+#include <new>
 
 #include <assert.h>
 
@@ -157,6 +158,16 @@ struct emplace_helper
 
 namespace detail
 {
+/**
+ * @brief Size of cache line, used to avoid false sharing between objects
+ *  accessed by different threads.
+*/
+#if defined(__cpp_lib_hardware_interference_size)
+inline constexpr std::size_t cache_line_size = std::hardware_destructive_interference_size;
+#else
+inline constexpr std::size_t cache_line_size = 64;
+#endif
+
 /**
  * @brief Allocate memory using allocator.
  *
@@ -212,6 +223,61 @@ auto rebind_allocator(Alloc& alloc)
 
 }  // namespace detail
 
+/**
+ * @brief Whether moving an object to another address and destroying the source
+ *  is equivalent to copying its bytes, see P1144.
+ *
+ * Trivially copyable types are trivially relocatable. Many other types such as
+ * std::unique_ptr are relocatable as well but this cannot be detected, they can
+ * opt in by specializing this template:
+ *
+ *  template <>
+ *  struct cpp::collections::is_trivially_relocatable<my_type> : std::true_type { };
+ *
+ * Do not opt in types which store pointers to themselves, e.g. std::string
+ * with small string optimization in libstdc++.
+*/
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> { };
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+template <typename T1, typename T2>
+struct is_trivially_relocatable<std::pair<T1, T2>>
+    : std::bool_constant<is_trivially_relocatable_v<T1> && is_trivially_relocatable_v<T2>> { };
+
+template <typename T>
+struct is_trivially_relocatable<std::unique_ptr<T>> : std::true_type { };
+
+namespace detail
+{
+
+/**
+ * @brief Whether containers can relocate T allocated by Alloc with std::memcpy.
+ *
+ * Allocators which customize destroy, such as checked allocators and
+ * polymorphic_allocator, keep the element-wise path.
+*/
+template <typename T, typename Alloc>
+inline constexpr bool relocate_by_memcpy = is_trivially_relocatable_v<T>
+    && !requires (typename std::allocator_traits<Alloc>::template rebind_alloc<T>& alloc, T* p) { alloc.destroy(p); };
+
+/**
+ * @brief Whether Alloc can resize the memory it allocated.
+ *
+ * The allocator should provide T* reallocate(T* p, size_t n, size_t new_n), the
+ * first n elements are copied bytewise if the memory is moved. If an exception
+ * is thrown, the memory pointed by p is unchanged.
+*/
+template <typename Alloc, typename T = typename Alloc::value_type>
+concept reallocatable_allocator = requires (Alloc& alloc, T* p, std::size_t n)
+{
+    { alloc.reallocate(p, n, n) } -> std::same_as<T*>;
+};
+
+}  // namespace detail
+
 /**
  * @brief A helper class use allocator construct value in construction
  *  and destroy in destruction.
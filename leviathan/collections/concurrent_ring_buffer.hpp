@@ -0,0 +1,680 @@
+/**
+ * Bounded lock-free ring buffers for passing elements between threads.
+ *
+ * Like ring_buffer, the capacity is rounded up to a power of two, so a slot is
+ * located by masking a counter. The counters increase monotonically and never
+ * wrap back to zero, the distance of two counters is the number of elements
+ * between them.
+ *
+ * - spsc_ring_buffer: one producer and one consumer. The producer and consumer
+ *   only write their own counters, and each of them caches the counter of the
+ *   other side, so the shared cache lines are only touched when the cached
+ *   value says the buffer is full or empty.
+ * - mpmc_ring_buffer: any number of producers and consumers, see
+ *   https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+ *   Each cell has a sequence number which tells whether the cell is ready for
+ *   the producer or the consumer of current round, so a producer/consumer only
+ *   competes for the counter and never waits for other threads.
+ *
+ * The counters are placed in different cache lines to avoid false sharing.
+ *
+ * try_push/try_pop return immediately if the buffer is full/empty, and
+ * push/pop wait by WaitPolicy until the operation can complete. The batch
+ * versions try_push_n/try_pop_n claim several slots with one update of counter.
+*/
+#pragma once
+
+#include "common.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+namespace cpp::collections
+{
+
+namespace detail
+{
+
+// Hint the processor that we are in a spin loop.
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// The capacity of concurrent ring buffers, at least 2.
+inline std::size_t ring_buffer_capacity(std::size_t capacity)
+{
+    return std::bit_ceil(std::max<std::size_t>(capacity, 2));
+}
+
+} // namespace detail
+
+/**
+ * @brief Wait policy which keeps spinning and yields the thread after a few rounds.
+ *
+ * The latency is the lowest, but the waiting thread keeps a core busy.
+*/
+struct spin_wait
+{
+    static constexpr int spin_limit = 64;
+
+    // Called each time the operation fails, the waiter is waiting for the
+    // change of counter which was observed as old.
+    template <typename T>
+    static void wait(const std::atomic<T>&, T, int& spins)
+    {
+        if (++spins < spin_limit)
+        {
+            detail::cpu_relax();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    // Called each time the counter is changed.
+    template <typename T>
+    static void notify(std::atomic<T>&) { }
+};
+
+/**
+ * @brief Wait policy which spins for a while and then blocks the thread by
+ *  std::atomic::wait.
+ *
+ * Each successful operation notifies the waiters, which costs more than spin_wait
+ * when nobody is waiting.
+*/
+struct blocking_wait
+{
+    static constexpr int spin_limit = 64;
+
+    template <typename T>
+    static void wait(const std::atomic<T>& counter, T old, int& spins)
+    {
+        if (++spins < spin_limit)
+        {
+            detail::cpu_relax();
+        }
+        else
+        {
+            counter.wait(old, std::memory_order_acquire);
+        }
+    }
+
+    template <typename T>
+    static void notify(std::atomic<T>& counter)
+    {
+        counter.notify_all();
+    }
+};
+
+/**
+ * @brief Bounded single producer single consumer ring buffer.
+ *
+ * push/try_push* should only be called by one thread and pop/try_pop* should
+ * only be called by one thread at the same time.
+*/
+template <typename T, typename WaitPolicy = spin_wait, typename Allocator = std::allocator<T>>
+class spsc_ring_buffer
+{
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+public:
+
+    using value_type = T;
+    using size_type = std::size_t;
+    using allocator_type = Allocator;
+
+    explicit spsc_ring_buffer(size_type capacity, const Allocator& allocator = Allocator())
+        : m_alloc(allocator), m_mask(detail::ring_buffer_capacity(capacity) - 1)
+    {
+        m_buffer = alloc_traits::allocate(m_alloc, m_mask + 1);
+    }
+
+    spsc_ring_buffer(const spsc_ring_buffer&) = delete;
+    spsc_ring_buffer& operator=(const spsc_ring_buffer&) = delete;
+
+    ~spsc_ring_buffer()
+    {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+
+        for (auto head = m_head.load(std::memory_order_relaxed); head != tail; ++head)
+        {
+            alloc_traits::destroy(m_alloc, slot(head));
+        }
+
+        alloc_traits::deallocate(m_alloc, m_buffer, m_mask + 1);
+    }
+
+    size_type capacity() const
+    {
+        return m_mask + 1;
+    }
+
+    // The result may be outdated when it is returned.
+    size_type size() const
+    {
+        const auto head = m_head.load(std::memory_order_acquire);
+        return m_tail.load(std::memory_order_acquire) - head;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    // Producer
+    template <typename... Args>
+    bool try_emplace(Args&&... args)
+    {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+
+        if (tail - m_cached_head == capacity())
+        {
+            m_cached_head = m_head.load(std::memory_order_acquire);
+
+            if (tail - m_cached_head == capacity())
+            {
+                return false;
+            }
+        }
+
+        alloc_traits::construct(m_alloc, slot(tail), (Args&&)args...);
+        publish(m_tail, tail + 1);
+        return true;
+    }
+
+    bool try_push(const T& value)
+    {
+        return try_emplace(value);
+    }
+
+    bool try_push(T&& value)
+    {
+        return try_emplace(std::move(value));
+    }
+
+    template <typename... Args>
+    void emplace(Args&&... args)
+    {
+        for (int spins = 0; !try_emplace((Args&&)args...); )
+        {
+            WaitPolicy::wait(m_head, m_cached_head, spins);
+        }
+    }
+
+    void push(const T& value)
+    {
+        emplace(value);
+    }
+
+    void push(T&& value)
+    {
+        emplace(std::move(value));
+    }
+
+    /**
+     * @brief: Push at most n elements from first.
+     *
+     * @return: Number of elements pushed, the elements are published together.
+    */
+    template <std::input_iterator I>
+    size_type try_push_n(I first, size_type n)
+    {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+
+        if (capacity() - (tail - m_cached_head) < n)
+        {
+            m_cached_head = m_head.load(std::memory_order_acquire);
+        }
+
+        n = std::min(n, capacity() - (tail - m_cached_head));
+
+        for (size_type i = 0; i < n; ++i, ++first)
+        {
+            try
+            {
+                alloc_traits::construct(m_alloc, slot(tail + i), *first);
+            }
+            catch (...)
+            {
+                // The constructed elements are still pushed.
+                publish(m_tail, tail + i);
+                throw;
+            }
+        }
+
+        if (n)
+        {
+            publish(m_tail, tail + n);
+        }
+
+        return n;
+    }
+
+    // Consumer
+    bool try_pop(T& value)
+    {
+        const auto head = m_head.load(std::memory_order_relaxed);
+
+        if (head == m_cached_tail)
+        {
+            m_cached_tail = m_tail.load(std::memory_order_acquire);
+
+            if (head == m_cached_tail)
+            {
+                return false;
+            }
+        }
+
+        value = std::move(*slot(head));
+        alloc_traits::destroy(m_alloc, slot(head));
+        publish(m_head, head + 1);
+        return true;
+    }
+
+    void pop(T& value)
+    {
+        for (int spins = 0; !try_pop(value); )
+        {
+            WaitPolicy::wait(m_tail, m_cached_tail, spins);
+        }
+    }
+
+    /**
+     * @brief: Pop at most n elements to out.
+     *
+     * @return: Number of elements popped.
+    */
+    template <std::output_iterator<T&&> O>
+    size_type try_pop_n(O out, size_type n)
+    {
+        const auto head = m_head.load(std::memory_order_relaxed);
+
+        if (m_cached_tail - head < n)
+        {
+            m_cached_tail = m_tail.load(std::memory_order_acquire);
+        }
+
+        n = std::min(n, m_cached_tail - head);
+
+        for (size_type i = 0; i < n; ++i, ++out)
+        {
+            try
+            {
+                *out = std::move(*slot(head + i));
+            }
+            catch (...)
+            {
+                // The moved elements are still popped.
+                publish(m_head, head + i);
+                throw;
+            }
+
+            alloc_traits::destroy(m_alloc, slot(head + i));
+        }
+
+        if (n)
+        {
+            publish(m_head, head + n);
+        }
+
+        return n;
+    }
+
+private:
+
+    T* slot(size_type counter)
+    {
+        return m_buffer + (counter & m_mask);
+    }
+
+    static void publish(std::atomic<size_type>& counter, size_type value)
+    {
+        counter.store(value, std::memory_order_release);
+        WaitPolicy::notify(counter);
+    }
+
+    // Written by consumer.
+    alignas(detail::cache_line_size) std::atomic<size_type> m_head = 0;
+    size_type m_cached_tail = 0;
+
+    // Written by producer.
+    alignas(detail::cache_line_size) std::atomic<size_type> m_tail = 0;
+    size_type m_cached_head = 0;
+
+    // Read only.
+    alignas(detail::cache_line_size) T* m_buffer;
+    size_type m_mask;
+    [[no_unique_address]] Allocator m_alloc;
+};
+
+/**
+ * @brief Bounded multiple producer multiple consumer ring buffer.
+*/
+template <typename T, typename WaitPolicy = spin_wait, typename Allocator = std::allocator<T>>
+class mpmc_ring_buffer
+{
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+    // The sequence is the counter of producer which can write the cell, and
+    // becomes counter + 1 after writing, which is the counter of consumer
+    // which can read it. After reading, it becomes counter + capacity for the
+    // producer of next round.
+    struct cell
+    {
+        std::atomic<std::size_t> m_sequence;
+        alignas(T) unsigned char m_raw[sizeof(T)];
+
+        T* value_ptr()
+        {
+            return std::launder(reinterpret_cast<T*>(m_raw));
+        }
+    };
+
+    static_assert(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>,
+        "The elements are moved after the cells are claimed.");
+
+    using cell_allocator = typename alloc_traits::template rebind_alloc<cell>;
+    using cell_alloc_traits = std::allocator_traits<cell_allocator>;
+
+public:
+
+    using value_type = T;
+    using size_type = std::size_t;
+    using allocator_type = Allocator;
+
+    explicit mpmc_ring_buffer(size_type capacity, const Allocator& allocator = Allocator())
+        : m_alloc(allocator), m_mask(detail::ring_buffer_capacity(capacity) - 1)
+    {
+        cell_allocator alloc(m_alloc);
+        m_cells = cell_alloc_traits::allocate(alloc, m_mask + 1);
+
+        for (size_type i = 0; i <= m_mask; ++i)
+        {
+            std::construct_at(&m_cells[i].m_sequence, i);
+        }
+    }
+
+    mpmc_ring_buffer(const mpmc_ring_buffer&) = delete;
+    mpmc_ring_buffer& operator=(const mpmc_ring_buffer&) = delete;
+
+    ~mpmc_ring_buffer()
+    {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+
+        for (auto head = m_head.load(std::memory_order_relaxed); head != tail; ++head)
+        {
+            alloc_traits::destroy(m_alloc, cell_of(head).value_ptr());
+        }
+
+        cell_allocator alloc(m_alloc);
+        cell_alloc_traits::deallocate(alloc, m_cells, m_mask + 1);
+    }
+
+    size_type capacity() const
+    {
+        return m_mask + 1;
+    }
+
+    // The result may be outdated when it is returned. The elements which are
+    // being written or read are also counted.
+    size_type size() const
+    {
+        const auto head = m_head.load(std::memory_order_acquire);
+        const auto tail = m_tail.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    template <typename... Args>
+    bool try_emplace(Args&&... args)
+    {
+        if constexpr (std::is_nothrow_constructible_v<T, Args...>)
+        {
+            return try_emplace_unchecked((Args&&)args...);
+        }
+        else
+        {
+            value_handle<value_type, allocator_type> handle(m_alloc, (Args&&)args...);
+            return try_emplace_unchecked(*handle);
+        }
+    }
+
+    bool try_push(const T& value)
+    {
+        return try_emplace(value);
+    }
+
+    bool try_push(T&& value)
+    {
+        return try_emplace(std::move(value));
+    }
+
+    template <typename... Args>
+    void emplace(Args&&... args)
+    {
+        if constexpr (std::is_nothrow_constructible_v<T, Args...>)
+        {
+            for (int spins = 0; !try_emplace_unchecked((Args&&)args...); )
+            {
+                wait_for(m_tail, 0, spins);
+            }
+        }
+        else
+        {
+            value_handle<value_type, allocator_type> handle(m_alloc, (Args&&)args...);
+            emplace(*handle);
+        }
+    }
+
+    void push(const T& value)
+    {
+        emplace(value);
+    }
+
+    void push(T&& value)
+    {
+        emplace(std::move(value));
+    }
+
+    /**
+     * @brief: Push at most n elements from first.
+     *
+     * The ready cells after the counter are claimed together, and the elements
+     * are constructed after claiming, so constructing from *first should not
+     * throw. Use std::move_iterator for the types whose copy may throw.
+     *
+     * @return: Number of elements pushed.
+    */
+    template <std::input_iterator I>
+        requires std::is_nothrow_constructible_v<T, std::iter_reference_t<I>>
+    size_type try_push_n(I first, size_type n)
+    {
+        auto [tail, count] = claim(m_tail, n, 0);
+
+        for (size_type i = 0; i < count; ++i, ++first)
+        {
+            auto& c = cell_of(tail + i);
+            alloc_traits::construct(m_alloc, c.value_ptr(), *first);
+            publish(c.m_sequence, tail + i + 1);
+        }
+
+        return count;
+    }
+
+    bool try_pop(T& value)
+    {
+        return try_pop_n(std::addressof(value), 1) == 1;
+    }
+
+    void pop(T& value)
+    {
+        for (int spins = 0; !try_pop(value); )
+        {
+            wait_for(m_head, 1, spins);
+        }
+    }
+
+    /**
+     * @brief: Pop at most n elements to out.
+     *
+     * The claimed cells cannot be given back since other consumers may have 
+     * claimed the cells after them. If writing to out throws, the element and 
+     * the remaining claimed elements are destroyed, so the cells can be reused.
+     *
+     * @return: Number of elements popped.
+    */
+    template <std::output_iterator<T&&> O>
+    size_type try_pop_n(O out, size_type n)
+    {
+        auto [head, count] = claim(m_head, n, 1);
+
+        for (size_type i = 0; i < count; ++i, ++out)
+        {
+            try
+            {
+                *out = std::move(*cell_of(head + i).value_ptr());
+            }
+            catch (...)
+            {
+                for (; i < count; ++i)
+                {
+                    release_cell(head + i);
+                }
+                throw;
+            }
+
+            release_cell(head + i);
+        }
+
+        return count;
+    }
+
+private:
+
+    // Destroy the element of a claimed cell and make the cell ready for the producer of next round.
+    void release_cell(size_type counter)
+    {
+        auto& c = cell_of(counter);
+        alloc_traits::destroy(m_alloc, c.value_ptr());
+        publish(c.m_sequence, counter + capacity());
+    }
+
+    cell& cell_of(size_type counter)
+    {
+        return m_cells[counter & m_mask];
+    }
+
+    static void publish(std::atomic<size_type>& sequence, size_type value)
+    {
+        sequence.store(value, std::memory_order_release);
+        WaitPolicy::notify(sequence);
+    }
+
+    // The sequence of cell when it is ready for counter, lag is 0 for producer
+    // and 1 for consumer.
+    static std::ptrdiff_t distance(size_type sequence, size_type counter, size_type lag)
+    {
+        return static_cast<std::ptrdiff_t>(sequence - (counter + lag));
+    }
+
+    /**
+     * @brief: Claim at most n consecutive ready cells from counter.
+     *
+     * @return: The first claimed counter and the number of claimed cells.
+    */
+    std::pair<size_type, size_type> claim(std::atomic<size_type>& counter, size_type n, size_type lag)
+    {
+        auto pos = counter.load(std::memory_order_relaxed);
+
+        while (n > 0)
+        {
+            size_type count = 0;
+
+            for (; count < n && distance(cell_of(pos + count).m_sequence.load(std::memory_order_acquire), pos + count, lag) == 0; ++count);
+
+            if (count == 0)
+            {
+                // Return if the first cell is not ready for this round, otherwise
+                // another thread has claimed it.
+                if (distance(cell_of(pos).m_sequence.load(std::memory_order_acquire), pos, lag) < 0)
+                {
+                    break;
+                }
+
+                pos = counter.load(std::memory_order_relaxed);
+            }
+            else if (counter.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed))
+            {
+                return { pos, count };
+            }
+        }
+
+        return { pos, 0 };
+    }
+
+    // The cell is claimed before constructing, so constructing should not throw.
+    template <typename... Args>
+    bool try_emplace_unchecked(Args&&... args) noexcept
+    {
+        auto [pos, count] = claim(m_tail, 1, 0);
+
+        if (count == 0)
+        {
+            return false;
+        }
+
+        auto& c = cell_of(pos);
+        alloc_traits::construct(m_alloc, c.value_ptr(), (Args&&)args...);
+        publish(c.m_sequence, pos + 1);
+        return true;
+    }
+
+    // Wait until the cell of counter is ready for this round.
+    void wait_for(std::atomic<size_type>& counter, size_type lag, int& spins)
+    {
+        const auto pos = counter.load(std::memory_order_relaxed);
+        auto& c = cell_of(pos);
+        const auto sequence = c.m_sequence.load(std::memory_order_acquire);
+
+        if (distance(sequence, pos, lag) < 0)
+        {
+            WaitPolicy::wait(c.m_sequence, sequence, spins);
+        }
+    }
+
+    // Written by consumers.
+    alignas(detail::cache_line_size) std::atomic<size_type> m_head = 0;
+
+    // Written by producers.
+    alignas(detail::cache_line_size) std::atomic<size_type> m_tail = 0;
+
+    // Read only.
+    alignas(detail::cache_line_size) cell* m_cells;
+    size_type m_mask;
+    [[no_unique_address]] Allocator m_alloc;
+};
+
+} // namespace cpp::collections
+
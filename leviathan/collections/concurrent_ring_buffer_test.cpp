@@ -0,0 +1,260 @@
+#include "concurrent_ring_buffer.hpp"
+#include <catch2/catch_all.hpp>
+
+#include <atomic>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cpp::collections;
+
+TEST_CASE("spsc ring buffer single thread")
+{
+    spsc_ring_buffer<std::string> buffer(3);
+
+    REQUIRE(buffer.capacity() == 4);
+    REQUIRE(buffer.empty());
+
+    CHECK(buffer.try_push("a"));
+    CHECK(buffer.try_emplace(3, 'b'));
+    CHECK(buffer.try_push("c"));
+    CHECK(buffer.try_push("d"));
+    CHECK(!buffer.try_push("e"));
+    CHECK(buffer.size() == 4);
+
+    std::string value;
+    CHECK(buffer.try_pop(value));
+    CHECK(value == "a");
+    CHECK(buffer.try_pop(value));
+    CHECK(value == "bbb");
+
+    std::vector<std::string> values = { "e", "f", "g" };
+    CHECK(buffer.try_push_n(values.begin(), values.size()) == 2);
+
+    std::vector<std::string> out;
+    CHECK(buffer.try_pop_n(std::back_inserter(out), 10) == 4);
+    CHECK(out == std::vector<std::string>{ "c", "d", "e", "f" });
+    CHECK(!buffer.try_pop(value));
+
+    // The remaining elements are destroyed by destructor.
+    CHECK(buffer.try_push("h"));
+}
+
+TEST_CASE("mpmc ring buffer single thread")
+{
+    mpmc_ring_buffer<std::string> buffer(4);
+
+    CHECK(buffer.try_push("a"));
+    CHECK(buffer.try_emplace(2, 'b'));
+
+    std::vector<std::string> values = { "c", "d", "e" };
+    CHECK(buffer.try_push_n(std::make_move_iterator(values.begin()), values.size()) == 2);
+    CHECK(!buffer.try_push("f"));
+    CHECK(buffer.size() == 4);
+
+    std::string value;
+    CHECK(buffer.try_pop(value));
+    CHECK(value == "a");
+
+    std::vector<std::string> out;
+    CHECK(buffer.try_pop_n(std::back_inserter(out), 2) == 2);
+    CHECK(out == std::vector<std::string>{ "bb", "c" });
+
+    CHECK(buffer.try_push("g"));
+}
+
+// Output iterator which throws when the limit-th element is written.
+struct throwing_output
+{
+    using difference_type = std::ptrdiff_t;
+
+    std::vector<std::string>* out;
+    std::size_t limit;
+
+    throwing_output& operator*() { return *this; }
+    throwing_output& operator++() { return *this; }
+    throwing_output operator++(int) { return *this; }
+
+    throwing_output& operator=(std::string&& value)
+    {
+        if (out->size() == limit)
+        {
+            throw std::runtime_error("write");
+        }
+
+        out->emplace_back(std::move(value));
+        return *this;
+    }
+};
+
+TEST_CASE("concurrent ring buffer pop throws")
+{
+    std::vector<std::string> values = { "a", "b", "c", "d" };
+    std::vector<std::string> out;
+    std::string value;
+
+    spsc_ring_buffer<std::string> spsc(4);
+    CHECK(spsc.try_push_n(values.begin(), values.size()) == 4);
+    CHECK_THROWS_AS(spsc.try_pop_n(throwing_output{ &out, 2 }, 4), std::runtime_error);
+    CHECK(out == std::vector<std::string>{ "a", "b" });
+
+    // The element failed to write is still in the buffer.
+    CHECK(spsc.size() == 2);
+    CHECK(spsc.try_pop(value));
+    CHECK(value == "c");
+
+    out.clear();
+    mpmc_ring_buffer<std::string> mpmc(4);
+    CHECK(mpmc.try_push_n(std::make_move_iterator(values.begin()), values.size()) == 4);
+    CHECK_THROWS_AS(mpmc.try_pop_n(throwing_output{ &out, 2 }, 4), std::runtime_error);
+    CHECK(out == std::vector<std::string>{ "a", "b" });
+
+    // The remaining claimed elements are dropped and the cells can be reused.
+    CHECK(mpmc.empty());
+    CHECK(mpmc.try_push_n(std::make_move_iterator(values.begin()), values.size()) == 4);
+    CHECK(mpmc.size() == 4);
+}
+
+template <typename Buffer>
+void spsc_test()
+{
+    constexpr int N = 100000;
+    Buffer buffer(64);
+    std::vector<int> received;
+
+    std::jthread consumer([&] {
+        int value;
+        int batch[16];
+
+        while (received.size() < N)
+        {
+            if (received.size() % 3 == 0)
+            {
+                buffer.pop(value);
+                received.push_back(value);
+            }
+            else
+            {
+                auto n = buffer.try_pop_n(batch, 16);
+                received.insert(received.end(), batch, batch + n);
+
+                if (n == 0)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    });
+
+    std::vector<int> values(N);
+    std::iota(values.begin(), values.end(), 0);
+
+    for (int i = 0; i < N; )
+    {
+        if (i % 2)
+        {
+            buffer.push(values[i++]);
+        }
+        else
+        {
+            auto n = buffer.try_push_n(values.begin() + i, std::min(8, N - i));
+            i += n;
+
+            if (n == 0)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    consumer.join();
+    CHECK(received == values);
+}
+
+TEST_CASE("spsc ring buffer multi-thread")
+{
+    spsc_test<spsc_ring_buffer<int>>();
+    spsc_test<spsc_ring_buffer<int, blocking_wait>>();
+}
+
+template <typename Buffer>
+void mpmc_test()
+{
+    constexpr int ThreadCount = 4;
+    constexpr int N = 20000;
+
+    Buffer buffer(128);
+    std::atomic<long long> sum = 0;
+    std::atomic<int> count = 0;
+
+    {
+        std::vector<std::jthread> threads;
+
+        for (int t = 0; t < ThreadCount; ++t)
+        {
+            threads.emplace_back([&, t] {
+                for (int i = 0; i < N; )
+                {
+                    if (t % 2)
+                    {
+                        buffer.push(i++);
+                    }
+                    else
+                    {
+                        int batch[4] = { i, i + 1, i + 2, i + 3 };
+                        auto n = buffer.try_push_n(batch, std::min(4, N - i));
+                        i += n;
+
+                        if (n == 0)
+                        {
+                            std::this_thread::yield();
+                        }
+                    }
+                }
+            });
+
+            threads.emplace_back([&, t] {
+                for (int i = 0; i < N; )
+                {
+                    int value;
+
+                    if (t % 2)
+                    {
+                        buffer.pop(value);
+                        sum += value;
+                        ++i;
+                    }
+                    else
+                    {
+                        int batch[4];
+                        auto n = buffer.try_pop_n(batch, std::min(4, N - i));
+                        for (size_t j = 0; j < n; ++j)
+                        {
+                            sum += batch[j];
+                        }
+                        i += n;
+
+                        if (n == 0)
+                        {
+                            std::this_thread::yield();
+                        }
+                    }
+                }
+                count += N;
+            });
+        }
+    }
+
+    CHECK(count == ThreadCount * N);
+    CHECK(sum == static_cast<long long>(N) * (N - 1) / 2 * ThreadCount);
+    CHECK(buffer.empty());
+}
+
+TEST_CASE("mpmc ring buffer multi-thread")
+{
+    mpmc_test<mpmc_ring_buffer<int>>();
+    mpmc_test<mpmc_ring_buffer<int, blocking_wait>>();
+}
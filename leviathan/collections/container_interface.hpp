@@ -205,12 +205,25 @@ struct insert_interface
         self.insert(ilist.begin(), ilist.end());
     }
 
+    // The position of last inserted element is the hint of next insertion, so the 
+    // containers which use the hint can insert a sorted range faster. Equivalent
+    // keys are inserted before the hint, so the containers which allow them use
+    // end() to keep the order of the range.
     template <typename Self, typename InputIt>
     void insert(this Self&& self, InputIt first, InputIt last)
     {
+        auto hint = self.end();
+
         for (; first != last; ++first)
         {
-            self.insert(*first);
+            if constexpr (std::same_as<decltype(self.emplace(*first)), self_iterator_t<Self>>)
+            {
+                self.emplace_hint(self.end(), *first);
+            }
+            else
+            {
+                hint = self.emplace_hint(hint, *first);
+            }
         }
     }
 
@@ -0,0 +1,270 @@
+/**
+ * Epoch based reclamation for lock-free containers.
+ *
+ * A node unlinked from a lock-free container may still be read by threads
+ * which loaded a pointer to it before the unlink, so it cannot be freed
+ * immediately. Each thread pins the domain for the duration of an operation
+ * and announces the global epoch it observed. A retired node is tagged with
+ * the global epoch, and the global epoch is only advanced when all pinned
+ * threads have announced the current one. Once the global epoch is two ahead
+ * of the tag, no thread can still hold a reference to the node.
+ *
+ * The nodes are linked into the limbo lists intrusively through epoch_node,
+ * so retiring never allocates. Each pinned thread owns an epoch_record
+ * exclusively, the records are reused by later threads and are only freed
+ * with the domain.
+*/
+#pragma once
+
+#include "common.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace cpp::collections
+{
+
+/**
+ * @brief Base of nodes which can be retired to an epoch_domain.
+*/
+struct epoch_node
+{
+    epoch_node* m_retired_next = nullptr;
+    std::uint64_t m_retired_epoch = 0;
+};
+
+class epoch_domain
+{
+    // The lowest bit of m_state is set while the record is pinned, the
+    // other bits are the announced epoch.
+    struct alignas(detail::cache_line_size) epoch_record
+    {
+        std::atomic<std::uint64_t> m_state = 0;
+        std::atomic<bool> m_owned = true;
+        epoch_record* m_next = nullptr;
+
+        // Only accessed by the owner, newest first.
+        epoch_node* m_limbo = nullptr;
+        std::size_t m_limbo_count = 0;
+    };
+
+    // The record used by current thread last time. Domains are identified by
+    // a serial number instead of the address, so a hint of destroyed domain
+    // will never be matched.
+    struct record_hint
+    {
+        std::uint64_t m_domain = 0;
+        epoch_record* m_record = nullptr;
+    };
+
+    static record_hint& thread_hint()
+    {
+        thread_local record_hint hint;
+        return hint;
+    }
+
+    static std::uint64_t next_domain_id()
+    {
+        static std::atomic<std::uint64_t> id = 0;
+        return id.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+public:
+
+    // Retired nodes are reclaimed every time the limbo list of a record reaches it.
+    static constexpr std::size_t reclaim_threshold = 64;
+
+    /**
+     * @brief RAII pin of domain. Pointers loaded from the container are valid
+     *  until the guard is destroyed.
+    */
+    class guard
+    {
+        friend class epoch_domain;
+
+        guard(epoch_domain* domain, epoch_record* record)
+            : m_domain(domain), m_record(record) { }
+
+    public:
+
+        guard(const guard&) = delete;
+        guard& operator=(const guard&) = delete;
+
+        ~guard()
+        {
+            m_record->m_state.store(0, std::memory_order_release);
+            m_record->m_owned.store(false, std::memory_order_release);
+        }
+
+    private:
+
+        epoch_domain* m_domain;
+        epoch_record* m_record;
+    };
+
+    epoch_domain() : m_id(next_domain_id()) { }
+
+    epoch_domain(const epoch_domain&) = delete;
+    epoch_domain& operator=(const epoch_domain&) = delete;
+
+    // All retired nodes should be drained before the domain is destroyed.
+    ~epoch_domain()
+    {
+        for (auto r = m_records.load(std::memory_order_acquire); r; )
+        {
+            assert(r->m_limbo == nullptr && "The retired nodes are leaked.");
+            delete std::exchange(r, r->m_next);
+        }
+    }
+
+    [[nodiscard]] guard pin()
+    {
+        auto record = acquire_record();
+        const auto epoch = m_epoch.load(std::memory_order_relaxed);
+        record->m_state.store((epoch << 1) | 1, std::memory_order_relaxed);
+
+        // The announcement must be visible before any pointer of the container
+        // is loaded, otherwise the epoch may be advanced twice and the node
+        // we are reading is reclaimed.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return guard(this, record);
+    }
+
+    /**
+     * @brief Retire a node which is unlinked from the container and is not
+     *  reachable by the threads which pin the domain later.
+     *
+     * @param g The guard of current thread.
+     * @param reclaim Invoked with each node which is safe to reclaim.
+    */
+    template <typename Reclaim>
+    void retire(guard& g, epoch_node* node, Reclaim&& reclaim)
+    {
+        assert(g.m_domain == this);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        node->m_retired_epoch = m_epoch.load(std::memory_order_seq_cst);
+
+        auto record = g.m_record;
+        node->m_retired_next = record->m_limbo;
+        record->m_limbo = node;
+
+        if (++record->m_limbo_count >= reclaim_threshold)
+        {
+            collect(record, reclaim);
+        }
+    }
+
+    /**
+     * @brief Reclaim all retired nodes.
+     *
+     * No thread should pin the domain concurrently, it is used by the
+     * destructor of container.
+    */
+    template <typename Reclaim>
+    void drain(Reclaim&& reclaim)
+    {
+        for (auto r = m_records.load(std::memory_order_acquire); r; r = r->m_next)
+        {
+            assert(!(r->m_state.load(std::memory_order_relaxed) & 1) && "The domain is still pinned.");
+
+            for (auto p = std::exchange(r->m_limbo, nullptr); p; )
+            {
+                reclaim(std::exchange(p, p->m_retired_next));
+            }
+
+            r->m_limbo_count = 0;
+        }
+    }
+
+    std::uint64_t epoch() const
+    {
+        return m_epoch.load(std::memory_order_relaxed);
+    }
+
+private:
+
+    static bool try_own(epoch_record* record)
+    {
+        return !record->m_owned.load(std::memory_order_relaxed)
+            && !record->m_owned.exchange(true, std::memory_order_acquire);
+    }
+
+    epoch_record* acquire_record()
+    {
+        auto& hint = thread_hint();
+
+        if (hint.m_domain == m_id && try_own(hint.m_record))
+        {
+            return hint.m_record;
+        }
+
+        auto head = m_records.load(std::memory_order_acquire);
+
+        for (auto r = head; r; r = r->m_next)
+        {
+            if (try_own(r))
+            {
+                hint = { m_id, r };
+                return r;
+            }
+        }
+
+        // All records are in use, the new record is owned since it is created.
+        auto record = new epoch_record();
+
+        do
+        {
+            record->m_next = head;
+        } while (!m_records.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_acquire));
+
+        hint = { m_id, record };
+        return record;
+    }
+
+    // The epoch can be advanced if all pinned records have observed it.
+    void try_advance(std::uint64_t epoch)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        for (auto r = m_records.load(std::memory_order_acquire); r; r = r->m_next)
+        {
+            const auto state = r->m_state.load(std::memory_order_acquire);
+
+            if ((state & 1) && (state >> 1) != epoch)
+            {
+                return;
+            }
+        }
+
+        m_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+    }
+
+    template <typename Reclaim>
+    void collect(epoch_record* record, Reclaim& reclaim)
+    {
+        try_advance(m_epoch.load(std::memory_order_seq_cst));
+
+        const auto epoch = m_epoch.load(std::memory_order_acquire);
+
+        // The tags in limbo list are non-increasing, so the nodes which can be
+        // reclaimed form a suffix.
+        auto link = &record->m_limbo;
+
+        for (; *link && (*link)->m_retired_epoch + 2 > epoch; link = &(*link)->m_retired_next);
+
+        for (auto p = std::exchange(*link, nullptr); p; --record->m_limbo_count)
+        {
+            reclaim(std::exchange(p, p->m_retired_next));
+        }
+    }
+
+    std::atomic<std::uint64_t> m_epoch = 0;
+    std::atomic<epoch_record*> m_records = nullptr;
+    const std::uint64_t m_id;
+};
+
+} // namespace cpp::collections
+
@@ -0,0 +1,329 @@
+/**
+ * A thread-safe hash map which shards keys across several py_hashtable.
+ *
+ * Each shard owns a py_hashtable and a std::shared_mutex in its own cache line,
+ * so threads working on different shards never contend with each other. The 
+ * shard is selected by the high bits of the mixed hash code, the low bits are 
+ * still used by the py_hashtable inside the shard.
+ *
+ * There is no iterator or reference escaping from the container. All accesses
+ * to elements are done by visitors which are invoked while the lock of shard is 
+ * held, so the visitor should be short and must not access the map again.
+ *
+ * Readers share the lock of shard. A seqlock is not used since the py_hashtable 
+ * may be rebuilt by a writer and an optimistic reader would touch freed memory.
+*/
+#pragma once
+
+#include "pyhash.hpp"
+
+#include <mutex>
+#include <shared_mutex>
+#include <bit>
+#include <array>
+
+namespace cpp::collections
+{
+
+/**
+ * @param ShardCount Number of shards, must be power of two.
+*/
+template <typename K, 
+    typename V,
+    typename Hasher = std::hash<K>,
+    typename KeyEqual = std::equal_to<K>,
+    typename Allocator = std::allocator<std::pair<const K, V>>,
+    std::size_t ShardCount = 64>
+class concurrent_hash_map
+{
+    static_assert(std::popcount(ShardCount) == 1, "ShardCount must be power of two.");
+
+    using table_type = py_hashtable<select1st<K, V>, Hasher, KeyEqual, Allocator>;
+
+    struct alignas(detail::cache_line_size) shard
+    {
+        mutable std::shared_mutex m_mutex;
+        table_type m_table;
+
+        shard(const Hasher& hash, const KeyEqual& ke, const Allocator& alloc)
+            : m_table(hash, ke, alloc) { }
+    };
+
+    static constexpr std::size_t ShardBits = std::countr_zero(ShardCount);
+
+public:
+
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<const K, V>;
+    using hasher = Hasher;
+    using key_equal = KeyEqual;
+    using allocator_type = Allocator;
+    using size_type = std::size_t;
+
+    static constexpr size_type shard_count = ShardCount;
+
+    concurrent_hash_map() 
+        : concurrent_hash_map(Hasher(), KeyEqual(), Allocator()) { }
+
+    concurrent_hash_map(const hasher& hash, const key_equal& ke, const allocator_type& alloc)
+        : m_shards(make_shards(hash, ke, alloc, std::make_index_sequence<ShardCount>())), m_hash(hash) { }
+
+    concurrent_hash_map(const concurrent_hash_map&) = delete;
+    concurrent_hash_map& operator=(const concurrent_hash_map&) = delete;
+
+    /**
+     * @brief: Number of elements. 
+     * 
+     * Shards are locked one by one, so the result may be stale if other threads 
+     * are modifying the map.
+    */
+    size_type size() const
+    {
+        size_type n = 0;
+
+        for (const auto& s : m_shards)
+        {
+            std::shared_lock lock(s.m_mutex);
+            n += s.m_table.size();
+        }
+
+        return n;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    bool contains(const key_type& key) const
+    {
+        return visit(key, [](const value_type&) { });
+    }
+
+    size_type count(const key_type& key) const
+    {
+        return contains(key);
+    }
+
+    /**
+     * @brief: Invoke fn with the element whose key is equal to key.
+     * @return: True if the element is found.
+    */
+    template <typename Fn>
+    bool visit(const key_type& key, Fn fn) const
+    {
+        const auto& s = shard_of(key);
+        std::shared_lock lock(s.m_mutex);
+
+        if (auto it = s.m_table.find(key); it != s.m_table.end())
+        {
+            fn(std::as_const(*it));
+            return true;
+        }
+
+        return false;
+    }
+
+    // The visitor may modify the mapped value, so the shard is locked exclusively.
+    template <typename Fn>
+    bool visit(const key_type& key, Fn fn)
+    {
+        auto& s = shard_of(key);
+        std::unique_lock lock(s.m_mutex);
+
+        if (auto it = s.m_table.find(key); it != s.m_table.end())
+        {
+            fn(*it);
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief: Invoke fn with each element. Each shard is locked while visiting.
+    */
+    template <typename Fn>
+    void visit_all(Fn fn) const
+    {
+        for (const auto& s : m_shards)
+        {
+            std::shared_lock lock(s.m_mutex);
+
+            for (const auto& x : s.m_table)
+            {
+                fn(x);
+            }
+        }
+    }
+
+    template <typename Fn>
+    void visit_all(Fn fn)
+    {
+        for (auto& s : m_shards)
+        {
+            std::unique_lock lock(s.m_mutex);
+
+            for (auto& x : s.m_table)
+            {
+                fn(x);
+            }
+        }
+    }
+
+    /**
+     * @brief: Insert an element constructed by args if the key does not exist.
+     * @return: True if the element is inserted.
+    */
+    template <typename... Args>
+    bool emplace(Args&&... args)
+    {
+        value_type value((Args&&) args...);
+        auto& s = shard_of(value.first);
+        std::unique_lock lock(s.m_mutex);
+        return s.m_table.emplace(std::move(value)).second;
+    }
+
+    bool insert(const value_type& value)
+    {
+        return emplace(value);
+    }
+
+    bool insert(value_type&& value)
+    {
+        return emplace(std::move(value));
+    }
+
+    /**
+     * @brief: Insert value if the key does not exist, otherwise invoke fn 
+     *  with the existing element. Both are done under the same lock.
+     * @return: True if the element is inserted.
+    */
+    template <typename Fn>
+    bool insert_or_visit(const value_type& value, Fn fn)
+    {
+        return insert_or_visit_impl(value, fn);
+    }
+
+    template <typename Fn>
+    bool insert_or_visit(value_type&& value, Fn fn)
+    {
+        return insert_or_visit_impl(std::move(value), fn);
+    }
+
+    /**
+     * @brief: Insert value or assign the mapped value of existing element.
+     * @return: True if the element is inserted.
+    */
+    template <typename M>
+    bool insert_or_assign(const key_type& key, M&& obj)
+    {
+        auto& s = shard_of(key);
+        std::unique_lock lock(s.m_mutex);
+
+        if (auto it = s.m_table.find(key); it != s.m_table.end())
+        {
+            (*it).second = (M&&) obj;
+            return false;
+        }
+
+        s.m_table.emplace(key, (M&&) obj);
+        return true;
+    }
+
+    size_type erase(const key_type& key)
+    {
+        auto& s = shard_of(key);
+        std::unique_lock lock(s.m_mutex);
+        return s.m_table.erase(key);
+    }
+
+    /**
+     * @brief: Erase the element if pred returns true for it.
+     * @return: Number of elements erased.
+    */
+    template <typename Pred>
+    size_type erase_if(const key_type& key, Pred pred)
+    {
+        auto& s = shard_of(key);
+        std::unique_lock lock(s.m_mutex);
+
+        if (auto it = s.m_table.find(key); it != s.m_table.end() && pred(std::as_const(*it)))
+        {
+            s.m_table.erase(it);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    void clear()
+    {
+        for (auto& s : m_shards)
+        {
+            std::unique_lock lock(s.m_mutex);
+            s.m_table.clear();
+        }
+    }
+
+    hasher hash_function() const
+    {
+        return m_hash;
+    }
+
+private:
+
+    template <typename U, typename Fn>
+    bool insert_or_visit_impl(U&& value, Fn& fn)
+    {
+        auto& s = shard_of(value.first);
+        std::unique_lock lock(s.m_mutex);
+
+        if (auto it = s.m_table.find(value.first); it != s.m_table.end())
+        {
+            fn(*it);
+            return false;
+        }
+
+        s.m_table.emplace((U&&) value);
+        return true;
+    }
+
+    template <std::size_t... Idx>
+    static std::array<shard, ShardCount> make_shards(const hasher& hash, const key_equal& ke, const allocator_type& alloc, std::index_sequence<Idx...>)
+    {
+        return { ((void)Idx, shard(hash, ke, alloc))... };
+    }
+
+    size_type shard_index(const key_type& key) const
+    {
+        // Fibonacci hashing, so the high bits depend on all bits of hash code
+        // even if the hasher is identity for integers.
+        const auto h = static_cast<std::uint64_t>(m_hash(key)) * 0x9E3779B97F4A7C15ull;
+
+        if constexpr (ShardBits == 0)
+        {
+            return 0;
+        }
+        else
+        {
+            return static_cast<size_type>(h >> (64 - ShardBits));
+        }
+    }
+
+    shard& shard_of(const key_type& key)
+    {
+        return m_shards[shard_index(key)];
+    }
+
+    const shard& shard_of(const key_type& key) const
+    {
+        return m_shards[shard_index(key)];
+    }
+
+    std::array<shard, ShardCount> m_shards;
+    [[no_unique_address]] hasher m_hash;
+};
+
+} // namespace cpp::collections
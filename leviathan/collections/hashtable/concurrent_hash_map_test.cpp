@@ -0,0 +1,69 @@
+#include "concurrent_hash_map.hpp"
+#include <catch2/catch_all.hpp>
+
+#include <thread>
+#include <vector>
+#include <string>
+
+using map_type = cpp::collections::concurrent_hash_map<int, int>;
+
+TEST_CASE("concurrent_hash_map basic operations")
+{
+    map_type m;
+
+    CHECK(m.insert({ 1, 1 }));
+    CHECK(m.emplace(2, 2));
+    CHECK(!m.insert({ 1, 3 }));
+    CHECK(m.size() == 2);
+
+    int value = 0;
+    CHECK(m.visit(1, [&](const auto& x) { value = x.second; }));
+    CHECK(value == 1);
+    CHECK(!m.visit(3, [&](const auto& x) { value = x.second; }));
+
+    CHECK(!m.insert_or_visit({ 1, 0 }, [](auto& x) { x.second += 10; }));
+    CHECK(m.visit(1, [&](const auto& x) { value = x.second; }));
+    CHECK(value == 11);
+
+    CHECK(!m.insert_or_assign(2, 20));
+    CHECK(m.insert_or_assign(3, 30));
+    CHECK(m.size() == 3);
+
+    CHECK(m.erase_if(3, [](const auto& x) { return x.second == 0; }) == 0);
+    CHECK(m.erase_if(3, [](const auto& x) { return x.second == 30; }) == 1);
+    CHECK(m.erase(2) == 1);
+    CHECK(m.erase(2) == 0);
+    CHECK(m.contains(1));
+    CHECK(m.size() == 1);
+
+    m.clear();
+    CHECK(m.empty());
+}
+
+TEST_CASE("concurrent_hash_map multi-thread insert_or_visit")
+{
+    map_type m;
+
+    constexpr int ThreadCount = 8;
+    constexpr int N = 10000;
+
+    std::vector<std::jthread> threads;
+
+    for (int t = 0; t < ThreadCount; ++t)
+    {
+        threads.emplace_back([&] {
+            for (int i = 0; i < N; ++i)
+            {
+                m.insert_or_visit({ i, 1 }, [](auto& x) { x.second++; });
+            }
+        });
+    }
+
+    threads.clear();
+
+    CHECK(m.size() == N);
+
+    int total = 0;
+    m.visit_all([&](const auto& x) { total += x.second; });
+    CHECK(total == N * ThreadCount);
+}
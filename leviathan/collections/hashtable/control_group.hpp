@@ -0,0 +1,169 @@
+/**
+ * Control bytes for group probing, inspired by abseil's SwissTable.
+ *
+ * Each slot of the table owns one byte of metadata:
+ *  - full:    0b0xxxxxxx, the low 7 bits of hash code(H2)
+ *  - empty:   0b10000000
+ *  - deleted: 0b11111110
+ *
+ * A group loads `width` consecutive control bytes and compares them at once.
+ * The result of each comparison is a bitmask, the i-th bit is set if the
+ * i-th byte in the group matches.
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <bit>
+
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace cpp::collections::detail
+{
+
+using control_byte = std::int8_t;
+
+inline constexpr control_byte control_empty = -128;   // 0b10000000
+inline constexpr control_byte control_deleted = -2;   // 0b11111110
+
+// Full control byte, the highest bit is always zero.
+constexpr control_byte control_h2(std::size_t hash_code)
+{
+    return static_cast<control_byte>(hash_code & 0x7F);
+}
+
+// Portable fallback, compare each byte one by one.
+template <std::size_t Width = 8>
+struct generic_group
+{
+    static constexpr std::size_t width = Width;
+
+    using mask_type = std::uint32_t;
+
+    static_assert(Width <= 32, "The bitmask only has 32 bits.");
+
+    explicit generic_group(const control_byte* ctrl)
+    {
+        std::memcpy(m_ctrl, ctrl, width);
+    }
+
+    mask_type match(control_byte h2) const
+    {
+        return match_if([=](control_byte c) { return c == h2; });
+    }
+
+    mask_type match_empty() const
+    {
+        return match_if([](control_byte c) { return c == control_empty; });
+    }
+
+    mask_type match_empty_or_deleted() const
+    {
+        return match_if([](control_byte c) { return c < 0; });
+    }
+
+private:
+
+    template <typename Pred>
+    mask_type match_if(Pred pred) const
+    {
+        mask_type mask = 0;
+        for (std::size_t i = 0; i < width; ++i)
+        {
+            mask |= static_cast<mask_type>(pred(m_ctrl[i])) << i;
+        }
+        return mask;
+    }
+
+    control_byte m_ctrl[width];
+};
+
+#if defined(__SSE2__)
+
+struct sse2_group
+{
+    static constexpr std::size_t width = 16;
+
+    using mask_type = std::uint32_t;
+
+    explicit sse2_group(const control_byte* ctrl)
+        : m_ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))) { }
+
+    mask_type match(control_byte h2) const
+    {
+        return movemask(_mm_cmpeq_epi8(_mm_set1_epi8(h2), m_ctrl));
+    }
+
+    mask_type match_empty() const
+    {
+        return match(control_empty);
+    }
+
+    // Both empty and deleted have the highest bit set.
+    mask_type match_empty_or_deleted() const
+    {
+        return movemask(m_ctrl);
+    }
+
+private:
+
+    static mask_type movemask(__m128i x)
+    {
+        return static_cast<mask_type>(_mm_movemask_epi8(x));
+    }
+
+    __m128i m_ctrl;
+};
+
+#endif
+
+#if defined(__AVX2__)
+
+struct avx2_group
+{
+    static constexpr std::size_t width = 32;
+
+    using mask_type = std::uint32_t;
+
+    explicit avx2_group(const control_byte* ctrl)
+        : m_ctrl(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ctrl))) { }
+
+    mask_type match(control_byte h2) const
+    {
+        return movemask(_mm256_cmpeq_epi8(_mm256_set1_epi8(h2), m_ctrl));
+    }
+
+    mask_type match_empty() const
+    {
+        return match(control_empty);
+    }
+
+    mask_type match_empty_or_deleted() const
+    {
+        return movemask(m_ctrl);
+    }
+
+private:
+
+    static mask_type movemask(__m256i x)
+    {
+        return static_cast<mask_type>(_mm256_movemask_epi8(x));
+    }
+
+    __m256i m_ctrl;
+};
+
+#endif
+
+#if defined(__AVX2__)
+using default_group = avx2_group;
+#elif defined(__SSE2__)
+using default_group = sse2_group;
+#else
+using default_group = generic_group<>;
+#endif
+
+} // namespace cpp::collections::detail
+
@@ -1,23 +1,24 @@
 #pragma once
 
 #include <leviathan/collections/common.hpp>
-#include <leviathan/collections/hashtable/entry.hpp>
+#include <leviathan/collections/hashtable/hash_table.hpp>
+
+#include <functional>
 
 namespace cpp::collections
-{
-    
-template <typename KeyValue, 
-    typename Hasher, 
-    typename KeyEqual,
-    typename Allocator,
-    bool Unique = true>
-class dictionary
 {
 
-    std::vector<size_t> m_indices;
-    
+template <typename K, 
+    typename V,
+    typename Hasher = std::hash<K>, 
+    typename KeyEqual = std::equal_to<K>,
+    typename Allocator = std::allocator<std::pair<const K, V>>>
+using dictionary = hash_table<select1st<K, V>, Hasher, KeyEqual, Allocator>;
 
-};
+template <typename T, 
+    typename Hasher = std::hash<T>, 
+    typename KeyEqual = std::equal_to<T>,
+    typename Allocator = std::allocator<T>>
+using flat_hash_set = hash_table<identity<T>, Hasher, KeyEqual, Allocator>;
 
 } // namespace cpp::collections
-
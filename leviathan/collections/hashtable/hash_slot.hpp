@@ -1,6 +1,9 @@
 #pragma once
 
 #include "../common.hpp"
+#include "control_group.hpp"
+
+#include <limits>
 
 namespace cpp::collections
 {
@@ -44,8 +47,32 @@ struct hash_cell<Slot, true> : hash_cell<Slot, false>
 namespace detail
 {
     
-template <typename T> 
-struct cache_hash_code : std::true_type { };
+/**
+ * @brief Whether the hashtable should store the hash code of each element.
+ * 
+ * Caching hash code saves rehashing when the table grows and makes comparing
+ * unequal keys cheaper, but it costs 8 bytes per element. For arithmetic, enum
+ * and pointer keys, hashing is trivial and comparing keys directly is as cheap
+ * as comparing hash codes, so the hash code is not cached by default.
+ * 
+ * Specialize this meta for user-defined key types, or pass the CacheHashCode 
+ * template argument to the hashtable to override it for one instantiation.
+ * 
+ * @param Key key_type of hashtable.
+*/
+template <typename Key> 
+struct cache_hash_code : std::bool_constant<
+    !(std::is_arithmetic_v<Key> || std::is_enum_v<Key> || std::is_pointer_v<Key>)> { };
+
+// Hint the processor that the memory will be read soon.
+inline void prefetch(const void* p)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p, 0, 3);
+#else
+    (void)p;
+#endif
+}
 
 template <std::size_t PerturbShift = 5>
 struct py_hash_generator
@@ -99,6 +126,71 @@ struct linear_hash_generator
     std::size_t m_mask;
 };
 
+/**
+ * @brief Probe the table group by group instead of slot by slot.
+ *
+ * The table keeps an extra control byte for each slot and compares a whole
+ * group of control bytes at once. The hash code is mixed first, then the high
+ * bits(H1) select the first group and the low 7 bits(H2) are stored in the 
+ * control byte. Groups are visited with triangular numbers which will cover 
+ * all groups since the number of groups is power of two.
+ *
+ * Since iterating the table still walks the indices, the order of elements is
+ * the same as py_hash_generator, only the cost of probing is changed.
+ *
+ * @param Group generic_group, sse2_group or avx2_group.
+*/
+template <typename Group = default_group>
+struct group_hash_generator
+{
+    using group_type = Group;
+
+    static constexpr std::size_t group_width = Group::width;
+
+    constexpr group_hash_generator(std::size_t hash_init, std::size_t table_size)  
+    {
+        assert(std::popcount(table_size) == 1 && table_size >= group_width);
+        m_mask = table_size / group_width - 1;
+        m_value = (mix(hash_init) >> 7) & m_mask;
+        m_step = 0;
+    }
+
+    // std::hash of integers is identity for most implementations, so without
+    // mixing, every 128 consecutive integers start from the same group. 
+    // Multiply by 2^64 / phi and fold the high bits into the low bits.
+    static constexpr std::size_t mix(std::size_t hash_code)
+    {
+        constexpr auto half = std::numeric_limits<std::size_t>::digits / 2;
+        hash_code *= static_cast<std::size_t>(0x9E3779B97F4A7C15ull);
+        return hash_code ^ (hash_code >> half);
+    }
+
+    // Return the offset of the first slot in next group.
+    constexpr std::size_t operator()() 
+    {
+        m_value = (m_value + ++m_step) & m_mask;
+        return m_value * group_width;
+    }
+
+    // Return the offset of the first slot in current group.
+    constexpr std::size_t operator*() const 
+    { return m_value * group_width; }
+
+    static constexpr control_byte h2(std::size_t hash_code) 
+    { return control_h2(mix(hash_code)); }
+
+    std::size_t m_value;
+    std::size_t m_step;
+    std::size_t m_mask;
+};
+
+template <typename HashGenerator>
+concept group_probing = requires 
+{ 
+    typename HashGenerator::group_type; 
+    HashGenerator::group_width;
+};
+
 // struct quadratic_policy
 // {
 //     quadratic_policy(std::size_t hash_init, std::size_t mask) noexcept 
@@ -1,16 +1,43 @@
+/**
+ * A flat open-addressing hashtable inspired by abseil's SwissTable.
+ *
+ * Different from py_hashtable which stores indices and elements in two arrays,
+ * this table stores elements inline in slots and each slot owns one control
+ * byte(see control_group.hpp). A lookup compares a whole group of control bytes
+ * first and only touches the slots whose H2 matches. The probing sequence is
+ * group_hash_generator, the same as py_hashtable with group probing, which
+ * mixes the hash code so that dense integer keys do not cluster.
+ *
+ * The order of elements is unspecified. Any insertion may rehash the table and
+ * invalidate all iterators, erasing only invalidates the iterators to the erased
+ * elements.
+*/
 #pragma once
 
+#include "hash_slot.hpp"
 #include "../common.hpp"
+#include "../node_handle.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <initializer_list>
+#include <stdexcept>
 
 namespace cpp::collections
 {
-    
-template <typename KeyValue, typename Hasher, typename KeyEqual, typename Allocator, typename Slot>
+
+/**
+ * @param KeyValue identity<T> for set and select1st<K, V> for map.
+ * @param Group generic_group, sse2_group or avx2_group.
+*/
+template <typename KeyValue,
+    typename Hasher,
+    typename KeyEqual,
+    typename Allocator,
+    typename Group = detail::default_group>
 class hash_table
 {
-    static constexpr bool IsTransparent = detail::transparent<hasher, key_equal>;
-    using slot_index_type = std::size_t;
-
 public:
 
     using key_type = typename KeyValue::key_type;
@@ -18,14 +45,922 @@ public:
     using hasher = Hasher;
     using key_equal = KeyEqual;
     using allocator_type = Allocator;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = typename std::allocator_traits<Allocator>::pointer;
+    using const_pointer = typename std::allocator_traits<Allocator>::const_pointer;
+
+protected:
+
+    static constexpr bool IsTransparent = detail::transparent<hasher, key_equal>;
+
+    template <typename U>
+    using key_arg_t = detail::key_arg<IsTransparent, U, key_type>;
+
+    using slot_type = hash_cell<value_type, false>;
+    using hash_generator_type = detail::group_hash_generator<Group>;
+
+    using alloc_traits = std::allocator_traits<allocator_type>;
+    using slot_allocator = typename alloc_traits::template rebind_alloc<slot_type>;
+    using slot_alloc_traits = std::allocator_traits<slot_allocator>;
+
+    // Extracted elements are moved into a slot allocated alone.
+    using node_allocator = slot_allocator;
+
+    static constexpr std::size_t GroupWidth = Group::width;
+    static constexpr std::size_t default_hash_size = std::max<std::size_t>(8, GroupWidth);
+
+    static constexpr bool IsNothrowMoveConstruct = nothrow_move_constructible<allocator_type, hasher, key_equal>;
+    static constexpr bool IsNothrowSwap = nothrow_swappable<allocator_type, hasher, key_equal>;
+
+    struct hash_iterator
+    {
+        using link_type = hash_table*;
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = hash_table::value_type;
+        using reference = std::conditional_t<std::is_same_v<key_type, value_type>, const value_type&, value_type&>;
+        using difference_type = std::ptrdiff_t;
+
+        link_type m_link = nullptr;
+        size_type m_idx = 0;
+
+        constexpr hash_iterator() = default;
+
+        constexpr hash_iterator(link_type link, size_type idx)
+            : m_link(link), m_idx(idx) { }
+
+        // The const_iterator and iterator may model same type, so we offer
+        // a base method to avoid if-constexpr.
+        constexpr hash_iterator base() const
+        {
+            return *this;
+        }
+
+        constexpr reference operator*() const
+        {
+            return m_link->m_slots[m_idx].value();
+        }
+
+        constexpr auto operator->() const
+        {
+            return std::addressof(operator*());
+        }
 
-    
+        constexpr hash_iterator& operator++()
+        {
+            m_idx = m_link->skip_empty_slots(m_idx + 1);
+            return *this;
+        }
+
+        constexpr hash_iterator operator++(int)
+        {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
+
+        friend constexpr bool operator==(hash_iterator, hash_iterator) = default;
+    };
+
+public:
+
+    using iterator = hash_iterator;
+    using const_iterator = std::const_iterator<iterator>;
+    using node_type = node_handle<KeyValue, node_allocator>;
+    using insert_return_type = node_insert_return<iterator, node_type>;
 
 protected:
 
-    hash_key_equal<hasher, key_equal> m_hk;
-    Slot m_slots;
-    [[no_unique_address]] Allocator m_alloc;
+    // Return the first full slot in [idx, capacity).
+    size_type skip_empty_slots(size_type idx) const
+    {
+        for (; idx < m_capacity && m_ctrl[idx] < 0; ++idx);
+        return idx;
+    }
+
+    // The maximum load factor is 7/8.
+    static constexpr size_type max_load_of(size_type capacity)
+    {
+        return capacity - capacity / 8;
+    }
+
+    // The minimum capacity that can hold n elements without growing.
+    static constexpr size_type capacity_for(size_type n)
+    {
+        return std::max(default_hash_size, std::bit_ceil(n + n / 7 + 1));
+    }
+
+    /**
+     * @brief: Find the slot of x.
+     * @return: The index of slot or capacity if x is not found.
+    */
+    template <typename K>
+    size_type find_slot(const K& x, size_type hash_code) const
+    {
+        if (m_capacity == 0)
+        {
+            return m_capacity;
+        }
+
+        hash_generator_type g { hash_code, m_capacity };
+        const auto h2 = hash_generator_type::h2(hash_code);
+
+        while (1)
+        {
+            const auto base = *g;
+            const Group group { m_ctrl + base };
+
+            for (auto mask = group.match(h2); mask; mask &= mask - 1)
+            {
+                const auto idx = base + std::countr_zero(mask);
+
+                if (m_hk(x, KeyValue()(m_slots[idx].value())))
+                {
+                    return idx;
+                }
+            }
+
+            if (group.match_empty())
+            {
+                return m_capacity;
+            }
+
+            g();
+        }
+        std::unreachable();
+    }
+
+    // Find the first empty or deleted slot in the probe sequence of hash_code.
+    size_type find_first_non_full(size_type hash_code) const
+    {
+        hash_generator_type g { hash_code, m_capacity };
+
+        while (1)
+        {
+            const auto base = *g;
+
+            if (const auto mask = Group(m_ctrl + base).match_empty_or_deleted(); mask)
+            {
+                return base + std::countr_zero(mask);
+            }
+
+            g();
+        }
+        std::unreachable();
+    }
+
+    void set_ctrl(size_type idx, detail::control_byte c)
+    {
+        m_ctrl[idx] = c;
+    }
+
+    /**
+     * @brief: Choose a slot for a new element with hash_code which does not exist
+     *  in table. The table may be rehashed.
+    */
+    size_type prepare_insert(size_type hash_code)
+    {
+        if (m_capacity == 0)
+        {
+            resize(default_hash_size);
+        }
+
+        auto idx = find_first_non_full(hash_code);
+
+        // Reusing a deleted slot does not consume growth_left.
+        if (m_growth_left == 0 && m_ctrl[idx] == detail::control_empty)
+        {
+            rehash_and_growth();
+            idx = find_first_non_full(hash_code);
+        }
+
+        return idx;
+    }
+
+    template <typename... Args>
+    void construct_at(size_type idx, size_type hash_code, Args&&... args)
+    {
+        slot_allocator alloc { m_alloc };
+        slot_alloc_traits::construct(alloc, m_slots[idx].value_ptr(), (Args&&) args...);
+
+        m_growth_left -= (m_ctrl[idx] == detail::control_empty);
+        set_ctrl(idx, hash_generator_type::h2(hash_code));
+        m_size++;
+    }
+
+    template <typename U>
+    std::pair<iterator, bool> insert_unique(U&& u)
+    {
+        const auto hash_code = m_hk(KeyValue()(u));
+
+        if (auto idx = find_slot(KeyValue()(u), hash_code); idx != m_capacity)
+        {
+            return { iterator(this, idx), false };
+        }
+
+        const auto idx = prepare_insert(hash_code);
+        construct_at(idx, hash_code, (U&&) u);
+        return { iterator(this, idx), true };
+    }
+
+    void erase_at(size_type idx)
+    {
+        slot_allocator alloc { m_alloc };
+        slot_alloc_traits::destroy(alloc, m_slots[idx].value_ptr());
+        m_size--;
+
+        // Since probing stops at a group with empty slots, if the group of idx has an
+        // empty slot, no probe sequence has ever passed through it, so this slot can
+        // be marked as empty instead of deleted.
+        const auto base = idx & ~(GroupWidth - 1);
+
+        if (Group(m_ctrl + base).match_empty())
+        {
+            set_ctrl(idx, detail::control_empty);
+            m_growth_left++;
+        }
+        else
+        {
+            set_ctrl(idx, detail::control_deleted);
+        }
+    }
+
+    void rehash_and_growth()
+    {
+        // If more than half of the used slots are deleted, rehash with
+        // same capacity, otherwise double the capacity.
+        const auto new_capacity = m_size * 2 <= max_load_of(m_capacity) ? m_capacity : m_capacity * 2;
+        resize(new_capacity);
+    }
+
+    void initialize(size_type new_capacity)
+    {
+        auto new_ctrl = detail::allocate<detail::control_byte>(m_alloc, new_capacity);
+
+        try
+        {
+            m_slots = detail::allocate<slot_type>(m_alloc, new_capacity);
+        }
+        catch (...)
+        {
+            detail::deallocate(m_alloc, new_ctrl, new_capacity);
+            throw;
+        }
+
+        std::uninitialized_fill_n(new_ctrl, new_capacity, detail::control_empty);
+        m_ctrl = new_ctrl;
+        m_capacity = new_capacity;
+        m_growth_left = max_load_of(new_capacity);
+    }
+
+    void deallocate_storage()
+    {
+        if (m_capacity)
+        {
+            detail::deallocate(m_alloc, m_ctrl, m_capacity);
+            detail::deallocate(m_alloc, m_slots, m_capacity);
+        }
+
+        m_ctrl = nullptr;
+        m_slots = nullptr;
+        m_capacity = 0;
+        m_growth_left = 0;
+    }
+
+    void destroy_elements()
+    {
+        slot_allocator alloc { m_alloc };
+
+        for (size_type i = 0; i < m_capacity; ++i)
+        {
+            if (m_ctrl[i] >= 0)
+            {
+                slot_alloc_traits::destroy(alloc, m_slots[i].value_ptr());
+            }
+        }
+
+        m_size = 0;
+    }
+
+    void resize(size_type new_capacity)
+    {
+        auto old_ctrl = m_ctrl;
+        auto old_slots = m_slots;
+        auto old_capacity = m_capacity;
+        auto old_size = m_size;
+        auto old_growth_left = m_growth_left;
+
+        initialize(new_capacity);
+        m_size = 0;
+
+        slot_allocator alloc { m_alloc };
+
+        try
+        {
+            for (size_type i = 0; i < old_capacity; ++i)
+            {
+                if (old_ctrl[i] >= 0)
+                {
+                    auto& value = old_slots[i].value();
+                    const auto hash_code = m_hk(KeyValue()(value));
+                    construct_at(find_first_non_full(hash_code), hash_code, std::move_if_noexcept(value));
+                }
+            }
+        }
+        catch (...)
+        {
+            // Recover the old table, the elements in old table are not moved
+            // since std::move_if_noexcept only moves for nothrow types.
+            destroy_elements();
+            deallocate_storage();
+            m_ctrl = old_ctrl;
+            m_slots = old_slots;
+            m_capacity = old_capacity;
+            m_size = old_size;
+            // The old table may contain tombstones, so the growth left cannot be
+            // computed from the size.
+            m_growth_left = old_growth_left;
+            throw;
+        }
+
+        if (old_capacity)
+        {
+            for (size_type i = 0; i < old_capacity; ++i)
+            {
+                if (old_ctrl[i] >= 0)
+                {
+                    slot_alloc_traits::destroy(alloc, old_slots[i].value_ptr());
+                }
+            }
+
+            detail::deallocate(m_alloc, old_ctrl, old_capacity);
+            detail::deallocate(m_alloc, old_slots, old_capacity);
+        }
+    }
+
+    // Copy elements of rhs which has same capacity, each element is kept in the same slot.
+    void copy_from(const hash_table& rhs)
+    {
+        if (rhs.m_capacity == 0)
+        {
+            return;
+        }
+
+        initialize(rhs.m_capacity);
+
+        slot_allocator alloc { m_alloc };
+
+        try
+        {
+            for (size_type i = 0; i < rhs.m_capacity; ++i)
+            {
+                if (rhs.m_ctrl[i] >= 0)
+                {
+                    slot_alloc_traits::construct(alloc, m_slots[i].value_ptr(), rhs.m_slots[i].value());
+                    m_ctrl[i] = rhs.m_ctrl[i];
+                    m_size++;
+                }
+            }
+        }
+        catch (...)
+        {
+            // The storage must be released here, the destructor will not run
+            // if this is called by the copy constructor.
+            destroy_elements();
+            deallocate_storage();
+            throw;
+        }
+
+        m_growth_left = rhs.m_growth_left;
+        std::copy_n(rhs.m_ctrl, m_capacity, m_ctrl);
+    }
+
+    void steal(hash_table& rhs) noexcept
+    {
+        m_ctrl = std::exchange(rhs.m_ctrl, nullptr);
+        m_slots = std::exchange(rhs.m_slots, nullptr);
+        m_size = std::exchange(rhs.m_size, 0);
+        m_capacity = std::exchange(rhs.m_capacity, 0);
+        m_growth_left = std::exchange(rhs.m_growth_left, 0);
+    }
+
+public:
+
+    hash_table()
+        : hash_table(Hasher(), KeyEqual(), Allocator()) { }
+
+    explicit hash_table(const hasher& hash, const key_equal& ke = KeyEqual(), const allocator_type& alloc = Allocator())
+        : m_hk(hash, ke), m_alloc(alloc) { }
+
+    explicit hash_table(const allocator_type& alloc)
+        : hash_table(Hasher(), KeyEqual(), alloc) { }
+
+    template <std::input_iterator InputIt>
+    hash_table(InputIt first, InputIt last, const hasher& hash = Hasher(), const key_equal& ke = KeyEqual(), const allocator_type& alloc = Allocator())
+        : hash_table(hash, ke, alloc)
+    {
+        insert(first, last);
+    }
+
+    hash_table(std::initializer_list<value_type> ilist, const hasher& hash = Hasher(), const key_equal& ke = KeyEqual(), const allocator_type& alloc = Allocator())
+        : hash_table(ilist.begin(), ilist.end(), hash, ke, alloc) { }
+
+    template <container_compatible_range<value_type> R>
+    hash_table(std::from_range_t, R&& rg, const hasher& hash = Hasher(), const key_equal& ke = KeyEqual(), const allocator_type& alloc = Allocator())
+        : hash_table(hash, ke, alloc)
+    {
+        insert_range((R&&) rg);
+    }
+
+    hash_table(const hash_table& rhs)
+        : hash_table(rhs, alloc_traits::select_on_container_copy_construction(rhs.m_alloc)) { }
+
+    hash_table(const hash_table& rhs, const allocator_type& alloc)
+        : m_hk(rhs.m_hk), m_alloc(alloc)
+    {
+        copy_from(rhs);
+    }
+
+    hash_table(hash_table&& rhs) noexcept(IsNothrowMoveConstruct)
+        : m_hk(std::move(rhs.m_hk)), m_alloc(std::move(rhs.m_alloc))
+    {
+        steal(rhs);
+    }
+
+    hash_table(hash_table&& rhs, const allocator_type& alloc)
+        : m_hk(std::move(rhs.m_hk)), m_alloc(alloc)
+    {
+        if (alloc == rhs.m_alloc)
+        {
+            steal(rhs);
+        }
+        else
+        {
+            reserve(rhs.size());
+
+            for (auto& x : rhs)
+            {
+                insert_unique(std::move(x));
+            }
+
+            rhs.clear();
+        }
+    }
+
+    hash_table& operator=(const hash_table& rhs)
+    {
+        if (this != std::addressof(rhs))
+        {
+            clear();
+            deallocate_storage();
+            m_hk = rhs.m_hk;
+
+            if constexpr (typename alloc_traits::propagate_on_container_copy_assignment())
+            {
+                m_alloc = rhs.m_alloc;
+            }
+
+            copy_from(rhs);
+        }
+        return *this;
+    }
+
+    hash_table& operator=(hash_table&& rhs) noexcept(IsNothrowMoveConstruct)
+    {
+        if (this != std::addressof(rhs))
+        {
+            clear();
+            deallocate_storage();
+            m_hk = std::move(rhs.m_hk);
+
+            if constexpr (typename alloc_traits::propagate_on_container_move_assignment())
+            {
+                m_alloc = std::move(rhs.m_alloc);
+                steal(rhs);
+            }
+            else if (m_alloc == rhs.m_alloc)
+            {
+                steal(rhs);
+            }
+            else
+            {
+                reserve(rhs.size());
+
+                for (auto& x : rhs)
+                {
+                    insert_unique(std::move(x));
+                }
+
+                rhs.clear();
+            }
+        }
+        return *this;
+    }
+
+    ~hash_table()
+    {
+        clear();
+        deallocate_storage();
+    }
+
+    void swap(hash_table& rhs) noexcept(IsNothrowSwap)
+    {
+        using std::swap;
+        swap(m_hk, rhs.m_hk);
+        swap(m_ctrl, rhs.m_ctrl);
+        swap(m_slots, rhs.m_slots);
+        swap(m_size, rhs.m_size);
+        swap(m_capacity, rhs.m_capacity);
+        swap(m_growth_left, rhs.m_growth_left);
+
+        if constexpr (typename alloc_traits::propagate_on_container_swap())
+        {
+            swap(m_alloc, rhs.m_alloc);
+        }
+    }
+
+    friend void swap(hash_table& lhs, hash_table& rhs) noexcept(noexcept(lhs.swap(rhs)))
+    {
+        lhs.swap(rhs);
+    }
+
+    iterator begin()
+    {
+        return { this, skip_empty_slots(0) };
+    }
+
+    iterator end()
+    {
+        return { this, m_capacity };
+    }
+
+    const_iterator begin() const
+    {
+        return const_cast<hash_table&>(*this).begin();
+    }
+
+    const_iterator end() const
+    {
+        return const_cast<hash_table&>(*this).end();
+    }
+
+    const_iterator cbegin() const
+    {
+        return begin();
+    }
+
+    const_iterator cend() const
+    {
+        return end();
+    }
+
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    size_type capacity() const
+    {
+        return m_capacity;
+    }
+
+    size_type max_size() const
+    {
+        return alloc_traits::max_size(m_alloc);
+    }
+
+    float load_factor() const
+    {
+        return m_capacity == 0 ? 0.0f : static_cast<float>(m_size) / m_capacity;
+    }
+
+    hasher hash_function() const
+    {
+        return static_cast<hasher>(m_hk);
+    }
+
+    key_equal key_eq() const
+    {
+        return static_cast<key_equal>(m_hk);
+    }
+
+    allocator_type get_allocator() const
+    {
+        return m_alloc;
+    }
+
+    /**
+     * @brief: Make sure the table can hold n elements without growing.
+    */
+    void reserve(size_type n)
+    {
+        if (n > m_size + m_growth_left)
+        {
+            resize(std::max(capacity_for(n), m_capacity));
+        }
+    }
+
+    /**
+     * @brief: Rehash the table with at least n slots. The deleted slots are dropped.
+    */
+    void rehash(size_type n)
+    {
+        if (m_size == 0 && n == 0)
+        {
+            deallocate_storage();
+            return;
+        }
+
+        resize(std::max(capacity_for(m_size), std::bit_ceil(std::max(n, default_hash_size))));
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args)
+    {
+        if constexpr (detail::emplace_helper<value_type, Args...>::value)
+        {
+            return insert_unique((Args&&) args...);
+        }
+        else
+        {
+            value_handle<value_type, allocator_type> handle(m_alloc, (Args&&) args...);
+            return insert_unique(*handle);
+        }
+    }
+
+    template <typename... Args>
+    iterator emplace_hint(const_iterator, Args&&... args)
+    {
+        return emplace((Args&&) args...).first;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& x)
+    {
+        return insert_unique(x);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& x)
+    {
+        return insert_unique(std::move(x));
+    }
+
+    iterator insert(const_iterator, const value_type& x)
+    {
+        return insert_unique(x).first;
+    }
+
+    iterator insert(const_iterator, value_type&& x)
+    {
+        return insert_unique(std::move(x)).first;
+    }
+
+    template <std::input_iterator InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        insert_range(std::ranges::subrange(first, last));
+    }
+
+    void insert(std::initializer_list<value_type> ilist)
+    {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    insert_return_type insert(node_type&& nh)
+    {
+        if (nh.empty())
+        {
+            return { end(), false, node_type() };
+        }
+
+        auto& value = *nh.m_ptr->value_ptr();
+        const auto hash_code = m_hk(KeyValue()(value));
+
+        if (auto idx = find_slot(KeyValue()(value), hash_code); idx != m_capacity)
+        {
+            return { iterator(this, idx), false, std::move(nh) };
+        }
+
+        const auto idx = prepare_insert(hash_code);
+        construct_at(idx, hash_code, std::move(value));
+        nh.reset();
+        return { iterator(this, idx), true, node_type() };
+    }
+
+    iterator insert(const_iterator, node_type&& nh)
+    {
+        return insert(std::move(nh)).position;
+    }
+
+    template <container_compatible_range<value_type> R>
+    void insert_range(R&& rg)
+    {
+        if constexpr (std::ranges::sized_range<R>)
+        {
+            reserve(m_size + std::ranges::size(rg));
+        }
+
+        for (auto&& x : rg)
+        {
+            emplace((decltype(x)&&) x);
+        }
+    }
+
+    /**
+     * @brief: Insert a new element constructed by args if key does not exist.
+     *  Only available for map.
+    */
+    template <typename... Args>
+        requires (!std::is_same_v<key_type, value_type>)
+    std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args)
+    {
+        return try_emplace_impl(key, (Args&&) args...);
+    }
+
+    template <typename... Args>
+        requires (!std::is_same_v<key_type, value_type>)
+    std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args)
+    {
+        return try_emplace_impl(std::move(key), (Args&&) args...);
+    }
+
+    auto& operator[](const key_type& key)
+        requires (!std::is_same_v<key_type, value_type>)
+    {
+        return (*try_emplace_impl(key).first).second;
+    }
+
+    auto& operator[](key_type&& key)
+        requires (!std::is_same_v<key_type, value_type>)
+    {
+        return (*try_emplace_impl(std::move(key)).first).second;
+    }
+
+    template <typename K = key_type>
+        requires (!std::is_same_v<key_type, value_type>)
+    auto& at(const key_arg_t<K>& key)
+    {
+        auto it = find(key);
+
+        if (it == end())
+        {
+            throw std::out_of_range("Key not found.");
+        }
+
+        return (*it).second;
+    }
+
+    template <typename K = key_type>
+        requires (!std::is_same_v<key_type, value_type>)
+    const auto& at(const key_arg_t<K>& key) const
+    {
+        return const_cast<hash_table&>(*this).at(key);
+    }
+
+    template <typename K = key_type>
+    iterator find(const key_arg_t<K>& x)
+    {
+        return { this, find_slot(x, m_hk(x)) };
+    }
+
+    template <typename K = key_type>
+    const_iterator find(const key_arg_t<K>& x) const
+    {
+        return const_cast<hash_table&>(*this).find(x);
+    }
+
+    template <typename K = key_type>
+    bool contains(const key_arg_t<K>& x) const
+    {
+        return find(x) != end();
+    }
+
+    template <typename K = key_type>
+    size_type count(const key_arg_t<K>& x) const
+    {
+        return contains(x);
+    }
+
+    iterator erase(iterator pos)
+    {
+        erase_at(pos.m_idx);
+        return { this, skip_empty_slots(pos.m_idx + 1) };
+    }
+
+    iterator erase(const_iterator pos)
+        requires (!std::same_as<iterator, const_iterator>)
+    {
+        return erase(pos.base());
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        auto i = first.base(), j = last.base();
+
+        for (; i != j; i = erase(i));
+        return i;
+    }
+
+    size_type erase(const key_type& x)
+    {
+        return erase_key(x);
+    }
+
+    template <typename K>
+        requires (IsTransparent &&
+            !std::is_convertible_v<K, iterator> &&
+            !std::is_convertible_v<K, const_iterator>)
+    size_type erase(K&& x)
+    {
+        return erase_key(x);
+    }
+
+    node_type extract(const_iterator pos)
+    {
+        const auto idx = pos.base().m_idx;
+        node_allocator alloc { m_alloc };
+
+        auto node = slot_alloc_traits::allocate(alloc, 1);
+
+        try
+        {
+            slot_alloc_traits::construct(alloc, node, std::move(m_slots[idx].value()));
+        }
+        catch (...)
+        {
+            slot_alloc_traits::deallocate(alloc, node, 1);
+            throw;
+        }
+
+        erase_at(idx);
+        return node_type(node, alloc);
+    }
+
+    template <typename K = key_type>
+    node_type extract(const key_arg_t<K>& x)
+    {
+        auto pos = find(x);
+        return pos == end() ? node_type() : extract(pos);
+    }
+
+    void clear()
+    {
+        if (m_capacity == 0)
+        {
+            return;
+        }
+
+        destroy_elements();
+        std::fill_n(m_ctrl, m_capacity, detail::control_empty);
+        m_growth_left = max_load_of(m_capacity);
+    }
+
+private:
+
+    template <typename K>
+    size_type erase_key(const K& x)
+    {
+        const auto idx = find_slot(x, m_hk(x));
+
+        if (idx == m_capacity)
+        {
+            return 0;
+        }
+
+        erase_at(idx);
+        return 1;
+    }
+
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> try_emplace_impl(K&& key, Args&&... args)
+    {
+        const auto hash_code = m_hk(key);
+
+        if (auto idx = find_slot(key, hash_code); idx != m_capacity)
+        {
+            return { iterator(this, idx), false };
+        }
+
+        const auto idx = prepare_insert(hash_code);
+        construct_at(idx, hash_code, std::piecewise_construct,
+            std::forward_as_tuple((K&&) key), std::forward_as_tuple((Args&&) args...));
+        return { iterator(this, idx), true };
+    }
+
+    [[no_unique_address]] hash_key_equal<Hasher, KeyEqual> m_hk;
+    [[no_unique_address]] allocator_type m_alloc;
+
+    detail::control_byte* m_ctrl = nullptr;   // store H2 or state of each slot
+    slot_type* m_slots = nullptr;              // store elements inline
+    size_type m_size = 0;                      // number of elements
+    size_type m_capacity = 0;                  // number of slots
+    size_type m_growth_left = 0;               // number of empty slots can be used before rehashing
 };
 
 } // namespace cpp::collections
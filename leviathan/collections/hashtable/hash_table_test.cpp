@@ -0,0 +1,122 @@
+#include "dictionary.hpp"
+#include <catch2/catch_all.hpp>
+
+#include <unordered_map>
+#include <string>
+#include <random>
+
+using dict = cpp::collections::dictionary<std::string, int>;
+using hashset = cpp::collections::flat_hash_set<int>;
+
+TEST_CASE("flat hash_table insert and lookup")
+{
+    hashset s = { 1, 2, 3, 3 };
+
+    CHECK(s.size() == 3);
+    CHECK(s.contains(1));
+    CHECK(!s.contains(4));
+
+    auto [it, succeed] = s.insert(4);
+    CHECK(succeed);
+    CHECK(*it == 4);
+    CHECK(!s.insert(4).second);
+
+    CHECK(s.erase(1) == 1);
+    CHECK(s.erase(1) == 0);
+    CHECK(s.size() == 3);
+}
+
+TEST_CASE("flat hash_table random test")
+{
+    dict d;
+    std::unordered_map<std::string, int> m;
+
+    constexpr auto N = 100000;
+    std::mt19937 gen(42);
+
+    for (int i = 0; i < N; ++i)
+    {
+        auto key = std::to_string(gen() % N);
+        auto value = static_cast<int>(gen());
+        CHECK(d.try_emplace(key, value).second == m.try_emplace(key, value).second);
+    }
+
+    for (int i = 0; i < N; ++i)
+    {
+        auto key = std::to_string(gen() % N);
+        CHECK(d.erase(key) == m.erase(key));
+        d[key] += 1;
+        m[key] += 1;
+    }
+
+    CHECK(d.size() == m.size());
+
+    for (const auto& [k, v] : d)
+    {
+        CHECK(m.at(k) == v);
+    }
+}
+
+TEST_CASE("flat hash_table dense integer keys")
+{
+    hashset s;
+
+    for (int i = 0; i < 200000; ++i)
+    {
+        CHECK(s.insert(i).second);
+    }
+
+    for (int i = 0; i < 200000; i += 2)
+    {
+        CHECK(s.erase(i) == 1);
+    }
+
+    CHECK(s.size() == 100000);
+
+    for (int i = 0; i < 200000; ++i)
+    {
+        CHECK(s.contains(i) == (i % 2 == 1));
+    }
+}
+
+TEST_CASE("flat hash_table copy and move")
+{
+    dict d;
+
+    for (int i = 0; i < 100; ++i)
+        d[std::to_string(i)] = i;
+
+    dict d2 = d;
+    CHECK(d2.size() == 100);
+    CHECK(d2.at("42") == 42);
+
+    dict d3 = std::move(d2);
+    CHECK(d3.size() == 100);
+    CHECK(d2.empty());
+
+    d2 = d3;
+    CHECK(d2.size() == 100);
+}
+
+TEST_CASE("flat hash_table node handle")
+{
+    dict d1, d2;
+
+    d1["a"] = 1;
+    d2["a"] = 2;
+
+    auto nh = d1.extract("a");
+    CHECK(!nh.empty());
+    CHECK(nh.key() == "a");
+    CHECK(d1.empty());
+
+    auto ret = d2.insert(std::move(nh));
+    CHECK(!ret.inserted);
+    CHECK(ret.position->second == 2);
+
+    nh = d2.extract(ret.position);
+    nh.mapped() = 3;
+    ret = d1.insert(std::move(nh));
+    CHECK(ret.inserted);
+    CHECK(d1.at("a") == 3);
+}
@@ -4,27 +4,48 @@
  * 2. Python dict use two array to save elements. One for indices(arr1) and another for elements(arr2). 
  * When removing an element, set value of arr1 to -2 and arr2 to nullptr(each element in Python is a PyObject*) is OK. 
  * But the element type in C++ does not require for pointer type. In such way, the iterator is not as efficient as Python.
+ * 3. The removed elements are kept in slots until the table is rebuilt. The table will be rebuilt with same 
+ * capacity when the ratio of removed elements exceeds max_tombstone_factor, or explicitly by compact/shrink_to_fit.
+ * Rebuilding keeps the relative order of elements in slots.
+ *
+ * Iterator invalidation:
+ * - insert/emplace: all iterators if the table is rebuilt(grows or compacts), otherwise none.
+ * - erase: only the iterators to the erased elements.
+ * - compact/shrink_to_fit/clear: all iterators.
 */
 #pragma once
 
 #include "hash_slot.hpp"
 #include "../common.hpp"
-#include "../associative_container_interface.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <span>
+#include <vector>
+#include "../container_interface.hpp"
 
 namespace cpp::collections
 {
+
+template <typename Table>
+class py_hashtable_snapshot;
     
 template <typename KeyValue, 
     typename Hasher, 
     typename KeyEqual,
     typename Allocator,
     typename HashGenerator = detail::py_hash_generator<>,
+    bool CacheHashCode = detail::cache_hash_code<typename KeyValue::key_type>::value,
     bool Unique = true>
-class py_hashtable : public reversible_container_interface,
-                     public unordered_associative_container_insertion_interface
+class py_hashtable : public iterable_interface,
+                     public insert_interface
 {
     static_assert(Unique, "Only support unique-key now.");
 
+    // The snapshot reads indices and slots of the table directly.
+    template <typename Table>
+    friend class py_hashtable_snapshot;
+
 public:
 
     using hasher = Hasher;
@@ -46,21 +67,37 @@ protected:
     template <typename U>
     using key_arg_t = detail::key_arg<IsTransparent, U, key_type>;
 
-    static constexpr bool CacheHashCode = detail::cache_hash_code<value_type>::value;
-
+    // Like Python, the width of each index in indices is decided by capacity,
+    // int8/int16/int32/int64 are used for tables with capacity up to 
+    // 2^7/2^15/2^31/2^63 and the width will be re-evaluated in each resize.
+    // The indices are stored in an array of std::uint64_t to keep alignment 
+    // and loaded as std::size_t, so SlotUnused/SlotDeleted are sign-extended.
     using index_type = std::size_t;
+    using index_storage_type = std::uint64_t;
     using slot_type = hash_cell<value_type, CacheHashCode>;
     using hash_generator_type = HashGenerator;
+    using key_value = KeyValue;
+
+    static constexpr bool IsCacheHashCode = CacheHashCode;
+
+    // With group probing, each slot has an extra control byte and 
+    // the table will compare a group of control bytes at once.
+    static constexpr bool GroupProbing = detail::group_probing<HashGenerator>;
 
     using slot_allocator = typename std::allocator_traits<allocator_type>::template rebind_alloc<slot_type>;
     using slot_alloc_traits = std::allocator_traits<slot_allocator>;
-    using indices_allocator = typename std::allocator_traits<allocator_type>::template rebind_alloc<index_type>;
+    using indices_allocator = typename std::allocator_traits<allocator_type>::template rebind_alloc<index_storage_type>;
     using indices_alloc_traits = std::allocator_traits<indices_allocator>;
     using alloc_traits = std::allocator_traits<allocator_type>;
 
     static constexpr index_type SlotUnused = static_cast<index_type>(-1);
     static constexpr index_type SlotDeleted = static_cast<index_type>(-2);
-    static constexpr std::size_t default_hash_size = 8;
+    static constexpr std::size_t default_hash_size = []{
+        if constexpr (GroupProbing)
+            return std::max<std::size_t>(8, HashGenerator::group_width);
+        else
+            return 8;
+    }();
 
     static constexpr bool IsNothrowMoveConstruct = 
                 std::is_nothrow_move_constructible_v<hasher> 
@@ -80,7 +117,7 @@ protected:
                 && typename slot_alloc_traits::is_always_equal()
                 && typename indices_alloc_traits::is_always_equal();
 
-    struct hash_iterator : bidirectional_iterator_interface
+    struct hash_iterator
     {
         using link_type = py_hashtable*;
         using iterator_category = std::bidirectional_iterator_tag;
@@ -105,27 +142,42 @@ protected:
 
         constexpr reference operator*() const
         {
-            auto pos = m_link->m_indices[m_idx];
+            auto pos = m_link->index_at(m_idx);
             return m_link->m_slots[pos].value();
         }
 
+        constexpr auto operator->() const
+        {
+            return std::addressof(operator*());
+        }
+
         constexpr hash_iterator& operator++()
         {
             m_idx++;
-            for (; m_idx < m_link->m_capacity && m_link->m_indices[m_idx] >= SlotDeleted; m_idx++);
+            for (; m_idx < m_link->m_capacity && m_link->index_at(m_idx) >= SlotDeleted; m_idx++);
             return *this;
         }
 
-        using bidirectional_iterator_interface::operator++;
+        constexpr hash_iterator operator++(int)
+        {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
 
         constexpr hash_iterator& operator--()
         {
             m_idx--;
-            for (; m_idx != static_cast<std::size_t>(-1) && m_link->m_indices[m_idx] >= SlotDeleted; m_idx--);
+            for (; m_idx != static_cast<std::size_t>(-1) && m_link->index_at(m_idx) >= SlotDeleted; m_idx--);
             return *this;   
         }
 
-        using bidirectional_iterator_interface::operator--;
+        constexpr hash_iterator operator--(int)
+        {
+            auto old = *this;
+            --*this;
+            return old;
+        }
     };
 
 public:
@@ -153,88 +205,225 @@ protected:
         }
     }
 
+    // The minimum capacity that can hold n elements without growing.
+    static constexpr std::size_t capacity_for(std::size_t n)
+    {
+        // Keep the load factor under 2/3.
+        return std::max(default_hash_size, std::bit_ceil(n + n / 2 + 1));
+    }
+
+    static constexpr std::size_t index_width_of(std::size_t capacity)
+    {
+        if (capacity <= (std::size_t(1) << 7))
+            return sizeof(std::int8_t);
+        else if (capacity <= (std::size_t(1) << 15))
+            return sizeof(std::int16_t);
+        else if (capacity <= (std::size_t(1) << 31))
+            return sizeof(std::int32_t);
+        else
+            return sizeof(std::int64_t);
+    }
+
+    // Number of index_storage_type needed for a table with capacity.
+    static constexpr std::size_t index_storage_size(std::size_t capacity)
+    {
+        const auto bytes = index_width_of(capacity) * capacity;
+        return (bytes + sizeof(index_storage_type) - 1) / sizeof(index_storage_type);
+    }
+
+    static index_type load_index(const index_storage_type* indices, std::size_t capacity, std::size_t offset)
+    {
+        auto load = [=]<typename Int>(std::type_identity<Int>) {
+            // Use memcpy to avoid breaking strict aliasing.
+            Int index;
+            std::memcpy(&index, reinterpret_cast<const unsigned char*>(indices) + offset * sizeof(Int), sizeof(Int));
+
+            // Sign extension makes -1 and -2 become SlotUnused and SlotDeleted.
+            return static_cast<index_type>(static_cast<std::int64_t>(index));
+        };
+
+        switch (index_width_of(capacity))
+        {
+            case 1: return load(std::type_identity<std::int8_t>());
+            case 2: return load(std::type_identity<std::int16_t>());
+            case 4: return load(std::type_identity<std::int32_t>());
+            default: return load(std::type_identity<std::int64_t>());
+        }
+    }
+
+    index_type index_at(std::size_t offset) const
+    {
+        return load_index(m_indices, m_capacity, offset);
+    }
+
+    void store_index(std::size_t offset, index_type value)
+    {
+        auto store = [=, this]<typename Int>(std::type_identity<Int>) {
+            const auto index = static_cast<Int>(value);
+            std::memcpy(reinterpret_cast<unsigned char*>(m_indices) + offset * sizeof(Int), &index, sizeof(Int));
+        };
+
+        switch (index_width_of(m_capacity))
+        {
+            case 1: store(std::type_identity<std::int8_t>()); break;
+            case 2: store(std::type_identity<std::int16_t>()); break;
+            case 4: store(std::type_identity<std::int32_t>()); break;
+            default: store(std::type_identity<std::int64_t>()); break;
+        }
+    }
+
     /**
-     * @brief: Try insert element and return the position of index that the element inserted.
-     * @return: (index, exits)
+     * @brief: Construct element at the end of slots and record its position.
     */
     template <typename U>
-    std::pair<std::size_t, bool> insert_with_hash_code(U&& u, std::size_t hash_code)
+    void construct_slot_at(std::size_t offset, std::size_t hash_code, U&& u)
     {
-        HashGenerator g { hash_code, m_capacity };
-        auto offset = *g;
-
         slot_allocator alloc { m_alloc };
 
-        while (1)
+        if constexpr (CacheHashCode)
+        {
+            slot_alloc_traits::construct(alloc, m_slots + m_used, hash_code, (U&&) u); 
+        }
+        else
+        {
+            slot_alloc_traits::construct(alloc, m_slots + m_used, (U&&) u); 
+        }
+
+        occupy(offset, hash_code);
+    }
+
+    /**
+     * @brief: Record that the element in m_slots[m_used] belongs to offset.
+    */
+    void occupy(std::size_t offset, std::size_t hash_code)
+    {
+        if constexpr (GroupProbing)
+        {
+            m_ctrl[offset] = HashGenerator::h2(hash_code);
+        }
+
+        store_index(offset, m_used);
+        m_used++;
+        m_size++;
+    }
+
+    void mark_deleted(std::size_t offset)
+    {
+        store_index(offset, SlotDeleted);
+
+        if constexpr (GroupProbing)
         {
-            auto& state = m_indices[offset];
+            m_ctrl[offset] = detail::control_deleted;
+        }
+    }
+
+    /**
+     * @brief: Find the first unused slot in the probe sequence of hash_code.
+    */
+    std::size_t find_first_unused(std::size_t hash_code) const
+    {
+        HashGenerator g { hash_code, m_capacity };
 
-            if (state == SlotUnused)
+        if constexpr (GroupProbing)
+        {
+            while (1)
             {
-                // Insert element here
-                if constexpr (CacheHashCode)
-                {
-                    slot_alloc_traits::construct(alloc, m_slots + m_used, hash_code, (U&&) u); 
-                }
-                else
+                const auto base = *g;
+                const auto empty = typename HashGenerator::group_type(m_ctrl + base).match_empty();
+
+                if (empty)
                 {
-                    slot_alloc_traits::construct(alloc, m_slots + m_used, (U&&) u); 
+                    return base + std::countr_zero(empty);
                 }
-                state = m_used;
-                m_used++;
-                m_size++;
-                return { offset, false };
-            }
 
-            // If the slot is deleted, we just skip it. 
-            // If the slot is active, we try to compare it with element
+                g();
+            }
+        }
+        else
+        {
+            auto offset = *g;
 
-            if (state != SlotDeleted && check_equal(hash_code, m_indices[offset], KeyValue()(u)))
+            while (index_at(offset) != SlotUnused)
             {
-                // The element is exist.
-                return { offset, true };
+                offset = g();
             }
 
-            offset = g();
-
+            return offset;
         }
         std::unreachable();
     }
 
+    std::size_t hash_code_of(const slot_type& slot) const
+    {
+        if constexpr (CacheHashCode)
+        {
+            return slot.m_hash_code;
+        }
+        else
+        {
+            return m_hk(KeyValue()(slot.value()));
+        }
+    }
+
+    /**
+     * @brief: Try insert element and return the position of index that the element inserted.
+     * @return: (index, exits)
+    */
     template <typename U>
-    void rehash_insert_with_hash_code(U&& u, std::size_t hash_code)
+    std::pair<std::size_t, bool> insert_with_hash_code(U&& u, std::size_t hash_code)
     {
-        HashGenerator g { hash_code, m_capacity };
-        auto offset = *g;
+        if constexpr (GroupProbing)
+        {
+            // The probe sequence always stops at an empty slot, so 
+            // if the element does not exist, we just insert it there.
+            const auto offset = find_slot_by_key_aux(KeyValue()(u), hash_code);
 
-        slot_allocator alloc { m_alloc };
+            if (index_at(offset) != SlotUnused)
+            {
+                return { offset, true };
+            }
 
-        while (1)
+            construct_slot_at(offset, hash_code, (U&&) u);
+            return { offset, false };
+        }
+        else
         {
-            auto& state = m_indices[offset];
+            HashGenerator g { hash_code, m_capacity };
+            auto offset = *g;
 
-            // We move the elements from old table to new table.
-            // Each slot in new table only has two state: active or unused.
-            if (state == SlotUnused)
+            while (1)
             {
-                if constexpr (CacheHashCode)
+                auto state = index_at(offset);
+
+                if (state == SlotUnused)
                 {
-                    slot_alloc_traits::construct(alloc, m_slots + m_used, hash_code, (U&&) u); 
+                    // Insert element here
+                    construct_slot_at(offset, hash_code, (U&&) u);
+                    return { offset, false };
                 }
-                else
+
+                // If the slot is deleted, we just skip it. 
+                // If the slot is active, we try to compare it with element
+
+                if (state != SlotDeleted && check_equal(hash_code, state, KeyValue()(u)))
                 {
-                    slot_alloc_traits::construct(alloc, m_slots + m_used, (U&&) u); 
+                    // The element is exist.
+                    return { offset, true };
                 }
-                state = m_used;
-                m_used++;
-                m_size++;
-                return;
-            }
 
-            offset = g();
+                offset = g();
 
+            }
+            std::unreachable();
         }
-        std::unreachable();
+    }
+
+    template <typename U>
+    void rehash_insert_with_hash_code(U&& u, std::size_t hash_code)
+    {
+        // We move the elements from old table to new table.
+        // Each slot in new table only has two state: active or unused.
+        construct_slot_at(find_first_unused(hash_code), hash_code, (U&&) u);
     } 
 
     template <typename U>
@@ -247,9 +436,20 @@ protected:
 
     void initialize(std::size_t new_capacity)
     {
-        auto new_indices = detail::allocate<index_type>(m_alloc, new_capacity);
+        const auto index_blocks = index_storage_size(new_capacity);
+        auto new_indices = detail::allocate<index_storage_type>(m_alloc, index_blocks);
         auto new_slot = detail::allocate<slot_type>(m_alloc, new_capacity);
-        std::uninitialized_fill_n(new_indices, new_capacity, SlotUnused);
+
+        // All bits of SlotUnused are one for each index width.
+        std::uninitialized_fill_n(new_indices, index_blocks, static_cast<index_storage_type>(-1));
+
+        if constexpr (GroupProbing)
+        {
+            auto new_ctrl = detail::allocate<detail::control_byte>(m_alloc, new_capacity);
+            std::uninitialized_fill_n(new_ctrl, new_capacity, detail::control_empty);
+            m_ctrl = new_ctrl;
+        }
+
         m_indices = new_indices;
         m_slots = new_slot;
         m_capacity = new_capacity;
@@ -263,6 +463,12 @@ protected:
             return;
         }
 
+        // Too many removed elements, rebuild the table with same capacity.
+        if (tombstone_factor() > m_max_tombstone_factor)
+        {
+            compact();
+        }
+
         constexpr double threshold = 2.0 / 3;
 
         const double factor = (double) m_used / m_capacity;
@@ -276,6 +482,7 @@ protected:
     void resize(std::size_t new_capacity)
     {
         auto old_indices = m_indices;
+        auto old_ctrl = m_ctrl;
         auto old_slots = m_slots;
         auto old_capacity = m_capacity;
         auto old_size = m_size;
@@ -287,7 +494,8 @@ protected:
         {
             py_hashtable* t;
 
-            index_type* indices;      
+            index_storage_type* indices;      
+            detail::control_byte* ctrl;
             slot_type* slots;         
             std::size_t size;         
             std::size_t capacity;     
@@ -303,6 +511,7 @@ protected:
                 {
                     t->clear();
                     t->m_indices = indices;
+                    t->m_ctrl = ctrl;
                     t->m_slots = slots;
                     t->m_size = size;
                     t->m_capacity = capacity;
@@ -311,81 +520,286 @@ protected:
             }
         };
 
-        exception_helper helper { this, old_indices, old_slots, old_size, old_capacity, old_mused };
+        exception_helper helper { this, old_indices, old_ctrl, old_slots, old_size, old_capacity, old_mused };
 
         // If std::is_nothrow_move_construable_v<T> is false, the `resize` will copy each 
         // element from old table to new table such as std::vector. To keep the state of 
         // container not be changed. We use exception_helper.
+        //
+        // The elements are moved in the order of old slots, so the relative order of
+        // elements in slots will not be changed. The removed elements are still alive
+        // in old slots, so we mark which slots are active first.
         m_size = 0;
         m_used = 0;
+        const auto alive = active_slots(old_indices, old_capacity, old_mused);
+
+        for (std::size_t pos = 0; pos < old_mused; ++pos)
+        {
+            if (alive[pos])
+            {
+                rehash_insert_with_hash_code(std::move_if_noexcept(old_slots[pos].value()), hash_code_of(old_slots[pos]));
+            }
+        }
+
+        // If no exception is thrown, we stop helper and free the old memory.
+        // Otherwise, helper's destructor will recover the state of container
+        helper.stop();
+
         slot_allocator alloc { m_alloc };
-        for (std::size_t i = 0; i < old_capacity; ++i)
+        for (std::size_t pos = 0; pos < old_mused; ++pos)
         {
-            auto state = old_indices[i];
-            if (state == SlotUnused)
+            slot_alloc_traits::destroy(alloc, old_slots + pos);
+        }
+
+        if (old_capacity)
+        {
+            assert(old_indices && old_slots && "these pointers should never be nullptr");
+            detail::deallocate(m_alloc, old_indices, index_storage_size(old_capacity));
+            detail::deallocate(m_alloc, old_slots, old_capacity);
+
+            if constexpr (GroupProbing)
             {
-                continue;
+                detail::deallocate(m_alloc, old_ctrl, old_capacity);
             }
-            else if (state == SlotDeleted)
+        }   
+    }
+
+    // Hint the processor to load the first probe position of hash_code.
+    void prefetch_probe(std::size_t hash_code) const
+    {
+        const auto offset = *HashGenerator(hash_code, m_capacity);
+
+        if constexpr (GroupProbing)
+        {
+            detail::prefetch(m_ctrl + offset);
+        }
+        
+        detail::prefetch(reinterpret_cast<const unsigned char*>(m_indices) + offset * index_width());
+    }
+
+    /**
+     * @brief: Insert elements in [first, first + n) and the capacity must be 
+     *  enough for all of them.
+     * 
+     * The hash codes of a batch of elements are computed first and the first
+     * probe positions are prefetched, so the memory accesses of different
+     * elements can overlap with each other.
+     * 
+     * @param MoveElements Move the elements by std::ranges::iter_move.
+    */
+    template <bool MoveElements, typename I>
+    I insert_batch(I first, std::size_t n)
+    {
+        constexpr std::size_t BatchSize = 16;
+
+        std::size_t hash_codes[BatchSize];
+
+        while (n)
+        {
+            const auto count = std::min(n, BatchSize);
+
+            auto it = first;
+            for (std::size_t i = 0; i < count; ++i, ++it)
             {
-                slot_alloc_traits::destroy(alloc, old_slots + state);
+                hash_codes[i] = m_hk(KeyValue()(*it));
+                prefetch_probe(hash_codes[i]);
             }
-            else
+
+            for (std::size_t i = 0; i < count; ++i, ++first)
             {
-                std::size_t hash_code;
-                auto pos = state;
-                if constexpr (CacheHashCode)
+                if constexpr (MoveElements)
                 {
-                    hash_code = old_slots[pos].m_hash_code;
+                    insert_with_hash_code(std::ranges::iter_move(first), hash_codes[i]);
                 }
                 else
                 {
-                    hash_code = m_hk(KeyValue()(old_slots[pos].value()));
+                    insert_with_hash_code(*first, hash_codes[i]);
                 }
+            }
+
+            n -= count;
+        }
 
-                rehash_insert_with_hash_code(std::move_if_noexcept(old_slots[pos].value()), hash_code);
-                slot_alloc_traits::destroy(alloc, old_slots + pos);
+        return first;
+    }
+
+    /**
+     * @brief: Mark the slots referenced by indices.
+     * @return: A bitmap, the i-th bit is set if m_slots[i] is not removed.
+    */
+    auto active_slots(const index_storage_type* indices, std::size_t capacity, std::size_t used) const
+    {
+        using bitmap_allocator = typename alloc_traits::template rebind_alloc<bool>;
+        std::vector<bool, bitmap_allocator> alive(used, false, bitmap_allocator(m_alloc));
+
+        for (std::size_t i = 0; i < capacity; ++i)
+        {
+            if (auto pos = load_index(indices, capacity, i); pos < SlotDeleted)
+            {
+                alive[pos] = true;
             }
         }
 
-        // If no exception is thrown, we stop helper and free the old memory.
-        // Otherwise, helper's destructor will recover the state of container
-        helper.stop();
+        return alive;
+    }
 
-        if (old_capacity)
+    /**
+     * @brief: Remove the dead elements and rebuild indices without allocating new slots.
+     * 
+     * The active elements are moved to the front of slots one by one, so this
+     * is only used when neither moving element nor computing hash code throws.
+    */
+    void compact_in_place()
+    {
+        const auto alive = active_slots(m_indices, m_capacity, m_used);
+        const auto old_used = m_used;
+
+        std::uninitialized_fill_n(m_indices, index_storage_size(m_capacity), static_cast<index_storage_type>(-1));
+
+        if constexpr (GroupProbing)
         {
-            assert(old_indices && old_slots && "these pointers should never be nullptr");
-            detail::deallocate(m_alloc, old_indices, old_capacity);
-            detail::deallocate(m_alloc, old_slots, old_capacity);
-        }   
+            std::fill_n(m_ctrl, m_capacity, detail::control_empty);
+        }
+
+        m_size = 0;
+        m_used = 0;
+        slot_allocator alloc { m_alloc };
+
+        for (std::size_t pos = 0; pos < old_used; ++pos)
+        {
+            if (!alive[pos])
+            {
+                slot_alloc_traits::destroy(alloc, m_slots + pos);
+                continue;
+            }
+
+            const auto hash_code = hash_code_of(m_slots[pos]);
+            const auto offset = find_first_unused(hash_code);
+
+            if (pos == m_used)
+            {
+                // No element removed before, keep it in place.
+                occupy(offset, hash_code);
+            }
+            else
+            {
+                // m_slots[m_used] is destroyed, move element here.
+                construct_slot_at(offset, hash_code, std::move(m_slots[pos].value()));
+                slot_alloc_traits::destroy(alloc, m_slots + pos);
+            }
+        }
     }
 
     template <typename K>
     std::size_t find_slot_by_key(const K& x) const 
     {
-        
-        auto hash_code = m_hk(x);
+        return find_slot_with_hash_code(x, m_hk(x));
+    }
 
+    template <typename K>
+    std::size_t find_slot_with_hash_code(const K& x, std::size_t hash_code) const 
+    {
         auto offset = find_slot_by_key_aux(x, hash_code);
         
         if (offset == m_capacity)
             return m_capacity;
 
-        
-        auto pos = m_indices[offset];
+        auto pos = index_at(offset);
         if (pos == SlotUnused)
             return m_capacity;
 
         return offset;
     }
 
+    // Hint the processor to load the slot which is most likely to be compared
+    // first. The indices(and control bytes) of hash_code should be prefetched before.
+    void prefetch_slot(std::size_t hash_code) const
+    {
+        const auto offset = *HashGenerator(hash_code, m_capacity);
+
+        if constexpr (GroupProbing)
+        {
+            const auto mask = typename HashGenerator::group_type(m_ctrl + offset).match(HashGenerator::h2(hash_code));
+
+            if (mask)
+            {
+                detail::prefetch(m_slots + index_at(offset + std::countr_zero(mask)));
+            }
+        }
+        else
+        {
+            if (const auto pos = index_at(offset); pos < SlotDeleted)
+            {
+                detail::prefetch(m_slots + pos);
+            }
+        }
+    }
+
+    /**
+     * @brief: Find each key in keys and call f(offset) in order, offset is
+     *  capacity if the key is not found.
+     * 
+     * The hash codes of a batch of keys are computed first. While resolving the
+     * i-th key, the indices of the (i + Distance)-th key and the slot of the
+     * (i + Distance / 2)-th key are prefetched. The indices of the latter are
+     * expected to be in cache by then, so the two dependent loads of each key
+     * are issued ahead of time and overlap with other keys.
+    */
+    template <typename K, typename F>
+    void find_batch(std::span<const K> keys, F f) const
+    {
+        constexpr std::size_t BatchSize = 64;
+        constexpr std::size_t Distance = 8;
+
+        if (m_capacity == 0)
+        {
+            for (std::size_t i = 0; i < keys.size(); ++i)
+            {
+                f(m_capacity);
+            }
+            return;
+        }
+
+        std::size_t hash_codes[BatchSize];
+
+        for (std::size_t first = 0; first < keys.size(); first += BatchSize)
+        {
+            const auto batch = keys.subspan(first, std::min(BatchSize, keys.size() - first));
+
+            for (std::size_t i = 0; i < batch.size(); ++i)
+            {
+                hash_codes[i] = m_hk(batch[i]);
+            }
+
+            for (std::size_t i = 0; i < std::min(Distance, batch.size()); ++i)
+            {
+                prefetch_probe(hash_codes[i]);
+            }
+
+            for (std::size_t i = 0; i < batch.size(); ++i)
+            {
+                if (i + Distance < batch.size())
+                {
+                    prefetch_probe(hash_codes[i + Distance]);
+                }
+
+                if (i + Distance / 2 < batch.size())
+                {
+                    prefetch_slot(hash_codes[i + Distance / 2]);
+                }
+
+                f(find_slot_with_hash_code(batch[i], hash_codes[i]));
+            }
+        }
+    }
+
     template <typename K>
     size_type remove_by_key(const K& x)
     {
         auto idx = find_slot_by_key(x);
         if (idx == m_capacity)
             return 0;
-        m_indices[idx] = SlotDeleted;
+        mark_deleted(idx);
         m_size--;
         return 1;
     }
@@ -394,7 +808,7 @@ protected:
     iterator remove_by_iterator(I iter)
     {
         auto idx = iter.m_idx;
-        m_indices[idx] = SlotDeleted;
+        mark_deleted(idx);
         m_size--;
         return std::next(iterator(this, idx));
     }
@@ -413,19 +827,48 @@ protected:
         
         HashGenerator g { hash_code, m_capacity };
 
-        auto offset = *g;
-
-        while (1)
+        if constexpr (GroupProbing)
         {
-            auto pos = m_indices[offset];
+            using group_type = typename HashGenerator::group_type;
+            const auto h2 = HashGenerator::h2(hash_code);
 
-            if (pos != SlotDeleted)
+            while (1)
             {
-                if (pos == SlotUnused || check_equal(hash_code, pos, x))
-                    return offset;
+                const auto base = *g;
+                const group_type group { m_ctrl + base };
+
+                // Only the slots with same H2 need to be compared.
+                for (auto mask = group.match(h2); mask; mask &= mask - 1)
+                {
+                    const auto offset = base + std::countr_zero(mask);
+
+                    if (check_equal(hash_code, index_at(offset), x))
+                        return offset;
+                }
+
+                // An empty slot means the probe sequence is over.
+                if (const auto empty = group.match_empty(); empty)
+                    return base + std::countr_zero(empty);
+
+                g();
             }
+        }
+        else
+        {
+            auto offset = *g;
+
+            while (1)
+            {
+                auto pos = index_at(offset);
 
-            offset = g();
+                if (pos != SlotDeleted)
+                {
+                    if (pos == SlotUnused || check_equal(hash_code, pos, x))
+                        return offset;
+                }
+
+                offset = g();
+            }
         }
         std::unreachable();
     }
@@ -441,6 +884,27 @@ public:
 
     py_hashtable(const allocator_type& alloc) : py_hashtable(Hasher(), KeyEqual(), alloc) { }
 
+    template <std::input_iterator InputIt>
+    py_hashtable(InputIt first, InputIt last, const hasher& hash = Hasher(), const key_equal& ke = KeyEqual(), const allocator_type& alloc = Allocator())
+        : py_hashtable(hash, ke, alloc)
+    {
+        insert_range(std::ranges::subrange(first, last));
+    }
+
+    py_hashtable(std::initializer_list<value_type> ilist, const hasher& hash = Hasher(), const key_equal& ke = KeyEqual(), const allocator_type& alloc = Allocator())
+        : py_hashtable(ilist.begin(), ilist.end(), hash, ke, alloc) { }
+
+    template <container_compatible_range<value_type> R>
+    py_hashtable(std::from_range_t, R&& rg, const hasher& hash = Hasher(), const key_equal& ke = KeyEqual(), const allocator_type& alloc = Allocator())
+        : py_hashtable(hash, ke, alloc)
+    {
+        insert_range((R&&) rg);
+    }
+
+    template <container_compatible_range<value_type> R>
+    py_hashtable(std::from_range_t, R&& rg, const allocator_type& alloc)
+        : py_hashtable(std::from_range, (R&&) rg, Hasher(), KeyEqual(), alloc) { }
+
     py_hashtable(const py_hashtable& rhs) 
         : py_hashtable(rhs, alloc_traits::select_on_container_copy_construction(rhs.m_alloc)) 
     { } 
@@ -463,9 +927,11 @@ public:
         swap(m_capacity, rhs.m_capacity);
         swap(m_hk, rhs.m_hk);
         swap(m_indices, rhs.m_indices);
+        swap(m_ctrl, rhs.m_ctrl);
         swap(m_size, rhs.m_size);
         swap(m_slots, rhs.m_slots);
         swap(m_used, rhs.m_used);
+        swap(m_max_tombstone_factor, rhs.m_max_tombstone_factor);
         if constexpr (typename alloc_traits::propagate_on_container_swap())
         {
             swap(m_alloc, rhs.m_alloc);
@@ -493,6 +959,79 @@ public:
         return m_capacity;
     }
 
+    /**
+     * @brief: The ratio of removed elements which still occupy slots to capacity.
+    */
+    float tombstone_factor() const
+    {
+        return m_capacity == 0 ? 0.0f : static_cast<float>(m_used - m_size) / m_capacity;
+    }
+
+    float max_tombstone_factor() const
+    {
+        return m_max_tombstone_factor;
+    }
+
+    /**
+     * @brief: Set the threshold of tombstone_factor. Once the ratio exceeds it,
+     *  the next insertion will compact the table first.
+    */
+    void max_tombstone_factor(float ml)
+    {
+        assert(ml > 0 && "max_tombstone_factor should be positive");
+        m_max_tombstone_factor = ml;
+    }
+
+    /**
+     * @brief: Remove all dead elements and rebuild indices with same capacity.
+     * 
+     * The relative order of elements in slots is kept. All iterators are invalidated.
+    */
+    void compact()
+    {
+        if (m_used == m_size)
+        {
+            return;
+        }
+
+        constexpr bool NothrowRebuild = std::is_nothrow_move_constructible_v<value_type> 
+            && (CacheHashCode || noexcept(std::declval<const hasher&>()(std::declval<const key_type&>())));
+
+        if constexpr (NothrowRebuild)
+        {
+            compact_in_place();
+        }
+        else
+        {
+            resize(m_capacity);
+        }
+    }
+
+    /**
+     * @brief: Rebuild the table with the minimum capacity that can hold current elements.
+     * 
+     * The relative order of elements in slots is kept. All iterators are invalidated.
+    */
+    void shrink_to_fit()
+    {
+        if (m_size == 0)
+        {
+            clear();
+            return;
+        }
+
+        const auto new_capacity = capacity_for(m_size);
+
+        if (new_capacity < m_capacity)
+        {
+            resize(new_capacity);
+        }
+        else
+        {
+            compact();
+        }
+    }
+
     hasher hash_function() const
     {
         return static_cast<hasher>(m_hk);
@@ -508,11 +1047,17 @@ public:
         return m_alloc;
     }
 
-    const index_type *indices() const
+    const void *indices() const
     {
         return m_indices;
     }
 
+    // Bytes of each index in indices.
+    std::size_t index_width() const
+    {
+        return index_width_of(m_capacity);
+    }
+
     const slot_type *slots() const
     {
         return m_slots;
@@ -523,10 +1068,79 @@ public:
         return static_cast<std::size_t>(-1) - 2;
     }
 
+    /**
+     * @brief: Make sure the table can hold n elements without growing.
+    */
+    void reserve(size_type n)
+    {
+        // The removed elements still occupy slots.
+        const auto new_capacity = capacity_for(n + (m_used - m_size));
+
+        if (new_capacity > m_capacity)
+        {
+            resize(new_capacity);
+        }
+    }
+
+    /**
+     * @brief: Insert all elements in rg.
+     * 
+     * If the size of rg is known, the table grows at most once. For forward ranges
+     * of value_type, the elements are inserted in batches which compute hash codes
+     * first and prefetch probe positions.
+    */
+    template <container_compatible_range<value_type> R>
+    void insert_range(R&& rg)
+    {
+        using reference = std::ranges::range_reference_t<R>;
+
+        // The elements of a container passed as rvalue are moved. The views may
+        // refer to the elements of other containers, so they are not moved. 
+        // Iterators such as std::move_iterator already yield rvalues.
+        constexpr bool MoveElements = !std::is_lvalue_reference_v<R> && !std::ranges::view<std::remove_cvref_t<R>>;
+
+        if constexpr (std::ranges::sized_range<R> || std::ranges::forward_range<R>)
+        {
+            const auto n = static_cast<size_type>(std::ranges::distance(rg));
+
+            if (n == 0)
+            {
+                return;
+            }
+
+            if (tombstone_factor() > m_max_tombstone_factor)
+            {
+                compact();
+            }
+
+            // After reserving, each insertion increases m_used by at most one,
+            // so the table will never grow during the insertion.
+            reserve(m_size + n);
+
+            if constexpr (std::ranges::forward_range<R> && std::same_as<std::remove_cvref_t<reference>, value_type>)
+            {
+                insert_batch<MoveElements>(std::ranges::begin(rg), n);
+                return;
+            }
+        }
+
+        for (auto first = std::ranges::begin(rg); first != std::ranges::end(rg); ++first)
+        {
+            if constexpr (MoveElements)
+            {
+                emplace(std::ranges::iter_move(first));
+            }
+            else
+            {
+                emplace(*first);
+            }
+        }
+    }
+
     iterator begin()
     {
         std::size_t idx = 0;
-        for (; idx < m_capacity && m_indices[idx] >= SlotDeleted; idx++);
+        for (; idx < m_capacity && index_at(idx) >= SlotDeleted; idx++);
         return { this, idx };
     }
 
@@ -603,6 +1217,50 @@ public:
         return const_cast<py_hashtable &>(*this).find(x);
     }
 
+    /**
+     * @brief: Find all keys and write the iterators to out in order, 
+     *  end() is written for the keys which are not found.
+     * 
+     * The lookups of different keys are interleaved with software prefetching,
+     * which hides the memory latency when the table does not fit in cache.
+     * 
+     * @return: Output iterator past the last element written.
+    */
+    template <typename K = key_type, std::output_iterator<iterator> O>
+    O find_many(std::span<const key_arg_t<K>> keys, O out)
+    {
+        find_batch(keys, [&](std::size_t offset) {
+            *out = iterator(this, offset);
+            ++out;
+        });
+        return out;
+    }
+
+    template <typename K = key_type, std::output_iterator<const_iterator> O>
+    O find_many(std::span<const key_arg_t<K>> keys, O out) const
+    {
+        find_batch(keys, [&](std::size_t offset) {
+            *out = const_iterator(iterator(const_cast<py_hashtable*>(this), offset));
+            ++out;
+        });
+        return out;
+    }
+
+    /**
+     * @brief: Check whether each key is in the table and write the results to out in order.
+     * 
+     * @return: Output iterator past the last element written.
+    */
+    template <typename K = key_type, std::output_iterator<bool> O>
+    O contains_many(std::span<const key_arg_t<K>> keys, O out) const
+    {
+        find_batch(keys, [&](std::size_t offset) {
+            *out = offset != m_capacity;
+            ++out;
+        });
+        return out;
+    }
+
     iterator erase(iterator pos)
     {
         return remove_by_iterator(pos);
@@ -644,11 +1302,17 @@ public:
         }
 
         // Free memory
-        detail::deallocate(m_alloc, m_indices, m_capacity);
+        detail::deallocate(m_alloc, m_indices, index_storage_size(m_capacity));
         detail::deallocate(m_alloc, m_slots, m_capacity);
 
+        if constexpr (GroupProbing)
+        {
+            detail::deallocate(m_alloc, m_ctrl, m_capacity);
+        }
+
         // Reset other member
         m_indices = nullptr;
+        m_ctrl = nullptr;
         m_slots = nullptr;
         m_capacity = 0;
         m_size = 0;
@@ -660,11 +1324,13 @@ private:
     [[no_unique_address]] hash_key_equal<Hasher, KeyEqual> m_hk;
     [[no_unique_address]] allocator_type m_alloc;
 
-    index_type* m_indices = nullptr;      // store indices or state
+    index_storage_type* m_indices = nullptr;  // store indices or state
+    detail::control_byte* m_ctrl = nullptr;  // store H2 or state, only for group probing
     slot_type* m_slots = nullptr;         // store entries
     std::size_t m_size = 0;               // number of elements
     std::size_t m_capacity = 0;           // table capacity
     std::size_t m_used = 0;               // used slots, always point the end of m_slots
+    float m_max_tombstone_factor = 0.25f; // compact the table if too many elements are removed
 
 };
 
@@ -1,4 +1,6 @@
 #include "pyhash.hpp"
+#include <random>
+#include <string>
 #include <catch2/catch_all.hpp>
 
 using pyhashset = cpp::collections::py_hashtable<
@@ -8,6 +10,14 @@ using pyhashset = cpp::collections::py_hashtable<
     std::allocator<int>
 >;
 
+using group_hashset = cpp::collections::py_hashtable<
+    cpp::collections::identity<int>,
+    std::hash<int>,
+    std::equal_to<int>,
+    std::allocator<int>,
+    cpp::collections::detail::group_hash_generator<>
+>;
+
 TEST_CASE("hash table insert")
 {
     pyhashset h;
@@ -67,6 +77,316 @@ TEST_CASE("random test")
 
 }
 
+TEST_CASE("group probing random test")
+{
+    std::unordered_set<int> s1;
+    group_hashset s2;
+
+    constexpr auto N = 100000;
+    std::mt19937 gen(42);
+
+    for (int i = 0; i < N; ++i) 
+    {
+        auto x = static_cast<int>(gen() % N);
+        auto [it1, succeed1] = s1.insert(x);
+        auto [it2, succeed2] = s2.insert(x);
+        CHECK(succeed1 == succeed2);
+    }
+
+    for (int i = 0; i < N; ++i) 
+    {
+        auto x = static_cast<int>(gen() % N);
+        CHECK(s1.erase(x) == s2.erase(x));
+        CHECK(s1.contains(x + 1) == s2.contains(x + 1));
+    }
+
+    CHECK(s1.size() == s2.size());
+    CHECK(std::ranges::all_of(s2, [&](int x) { return s1.contains(x); }));
+}
+
+TEST_CASE("group probing spreads dense integer keys")
+{
+    using generator = cpp::collections::detail::group_hash_generator<>;
+
+    // std::hash<int> is usually identity, the consecutive keys should still
+    // start from different groups.
+    constexpr std::size_t table_size = 1 << 16;
+    std::unordered_set<std::size_t> groups;
+
+    for (int i = 0; i < 1024; ++i)
+        groups.insert(*generator(std::hash<int>()(i), table_size));
+
+    CHECK(groups.size() > 900);
+
+    group_hashset h;
+
+    for (int i = 0; i < 200000; ++i)
+        h.insert(i);
+
+    CHECK(h.size() == 200000);
+
+    for (int i = 0; i < 200000; ++i)
+        CHECK(h.contains(i));
+}
 
+TEST_CASE("index width grows with capacity")
+{
+    pyhashset h;
+
+    h.insert(0);
+    CHECK(h.index_width() == 1);
+
+    for (int i = 0; i < 1000; ++i)
+        h.insert(i);
+
+    CHECK(h.index_width() == 2);
+    CHECK(h.size() == 1000);
+
+    for (int i = 0; i < 1000; ++i)
+        CHECK(h.contains(i));
+}
+
+TEST_CASE("compact and shrink_to_fit")
+{
+    pyhashset h;
+
+    for (int i = 0; i < 1000; ++i)
+        h.insert(i);
+
+    for (int i = 0; i < 1000; i += 2)
+        h.erase(i);
+
+    CHECK(h.tombstone_factor() > 0);
+
+    auto capacity = h.capacity();
+    h.compact();
+
+    CHECK(h.tombstone_factor() == 0);
+    CHECK(h.capacity() == capacity);
+    CHECK(h.size() == 500);
+
+    for (int i = 0; i < 1000; i += 3)
+        h.erase(i);
+
+    h.shrink_to_fit();
+
+    CHECK(h.capacity() < capacity);
+    CHECK(std::ranges::distance(h) == h.size());
+
+    for (int i = 0; i < 1000; ++i)
+        CHECK(h.contains(i) == (i % 2 == 1 && i % 3 != 0));
+}
+
+TEST_CASE("insertion compacts the table if too many elements are removed")
+{
+    pyhashset h;
+    h.max_tombstone_factor(0.1f);
+
+    for (int round = 0; round < 100; ++round)
+    {
+        for (int i = 0; i < 100; ++i)
+            h.insert(round * 100 + i);
+
+        for (int i = 0; i < 100; ++i)
+            h.erase(round * 100 + i);
+
+        CHECK(h.tombstone_factor() <= 0.1f + 100.0f / h.capacity());
+    }
+
+    CHECK(h.empty());
+    CHECK(h.capacity() <= 512);
+}
+
+TEST_CASE("insert range")
+{
+    std::vector<int> values;
 
+    for (int i = 0; i < 10000; ++i)
+        values.emplace_back(i % 5000);
 
+    pyhashset h(std::from_range, values);
+
+    CHECK(h.size() == 5000);
+    CHECK(std::ranges::all_of(std::views::iota(0, 5000), [&](int x) { return h.contains(x); }));
+
+    // The table is reserved once for all elements.
+    auto capacity = h.capacity();
+    h.insert_range(std::views::iota(0, 5000));
+    CHECK(h.capacity() == capacity);
+    CHECK(h.size() == 5000);
+
+    pyhashset h2 = { 1, 2, 3, 3 };
+    CHECK(h2.size() == 3);
+
+    pyhashset h3(values.begin(), values.end());
+    CHECK(h3.size() == 5000);
+}
+
+struct copy_counted
+{
+    inline static int copies = 0;
+
+    int value;
+
+    copy_counted(int value) : value(value) { }
+
+    copy_counted(const copy_counted& other) : value(other.value)
+    {
+        ++copies;
+    }
+
+    copy_counted(copy_counted&&) noexcept = default;
+
+    bool operator==(const copy_counted&) const = default;
+};
+
+struct copy_counted_hash
+{
+    std::size_t operator()(const copy_counted& x) const
+    {
+        return std::hash<int>()(x.value);
+    }
+};
+
+TEST_CASE("insert range moves elements")
+{
+    using counted_hashset = cpp::collections::py_hashtable<
+        cpp::collections::identity<copy_counted>,
+        copy_counted_hash,
+        std::equal_to<copy_counted>,
+        std::allocator<copy_counted>
+    >;
+
+    auto make_values = []() {
+        std::vector<copy_counted> values;
+        for (int i = 0; i < 1000; ++i)
+            values.emplace_back(i);
+        return values;
+    };
+
+    auto values = make_values();
+    copy_counted::copies = 0;
+
+    counted_hashset h1;
+    h1.insert_range(std::move(values));
+    CHECK(h1.size() == 1000);
+    CHECK(copy_counted::copies == 0);
+
+    values = make_values();
+    counted_hashset h2(std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()));
+    CHECK(h2.size() == 1000);
+    CHECK(copy_counted::copies == 0);
+
+    // The elements of lvalue ranges are copied.
+    values = make_values();
+    counted_hashset h3;
+    h3.insert_range(values);
+    CHECK(h3.size() == 1000);
+    CHECK(copy_counted::copies == 1000);
+    CHECK(values.front().value == 0);
+}
+
+TEST_CASE("hash code caching policy")
+{
+    using cpp::collections::detail::cache_hash_code;
+
+    STATIC_CHECK(!cache_hash_code<int>::value);
+    STATIC_CHECK(!cache_hash_code<double>::value);
+    STATIC_CHECK(cache_hash_code<std::string>::value);
+
+    using cached_hashset = cpp::collections::py_hashtable<
+        cpp::collections::identity<int>,
+        std::hash<int>,
+        std::equal_to<int>,
+        std::allocator<int>,
+        cpp::collections::detail::py_hash_generator<>,
+        true
+    >;
+
+    cached_hashset h1;
+    pyhashset h2;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        h1.insert(i);
+        h2.insert(i);
+    }
+
+    for (int i = 0; i < 2000; ++i)
+        CHECK(h1.contains(i) == h2.contains(i));
+}
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+template <typename HashSet>
+void test_find_many()
+{
+    HashSet h;
+
+    for (int i = 0; i < 10000; i += 2)
+        h.insert(i);
+
+    for (int i = 0; i < 10000; i += 6)
+        h.erase(i);
+
+    std::vector<int> keys;
+
+    for (int i = -10; i < 10010; ++i)
+        keys.emplace_back(i * 7 % 10010);
+
+    std::vector<typename HashSet::iterator> iterators;
+    std::vector<bool> found;
+
+    h.find_many(keys, std::back_inserter(iterators));
+    std::as_const(h).contains_many(keys, std::back_inserter(found));
+
+    REQUIRE(iterators.size() == keys.size());
+    REQUIRE(found.size() == keys.size());
+
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        CHECK(iterators[i] == h.find(keys[i]));
+        CHECK(found[i] == h.contains(keys[i]));
+    }
+
+    HashSet empty;
+    found.clear();
+    empty.contains_many(keys, std::back_inserter(found));
+    CHECK(std::ranges::none_of(found, std::identity()));
+}
+
+TEST_CASE("find_many")
+{
+    test_find_many<pyhashset>();
+    test_find_many<group_hashset>();
+}
+
+#include <leviathan/extc++/seeded_hash.hpp>
+
+TEST_CASE("seeded string hash")
+{
+    using string_hashset = cpp::collections::py_hashtable<
+        cpp::collections::identity<std::string>,
+        cpp::seeded_hash,
+        std::equal_to<>,
+        std::allocator<std::string>
+    >;
+
+    CHECK(cpp::seeded_hash(1)("hello") != cpp::seeded_hash(2)("hello"));
+    CHECK(cpp::seeded_hash()(std::string("hello")) == cpp::seeded_hash()(std::string_view("hello")));
+
+    string_hashset h;
+
+    // Cover the short, medium and multi-lane paths of hash_bytes.
+    for (int i = 0; i < 300; ++i)
+        h.insert(std::string(i, 'a'));
+
+    CHECK(h.size() == 300);
+
+    for (int i = 0; i < 300; ++i)
+        CHECK(h.contains(std::string_view(std::string(i, 'a'))));
+
+    CHECK(!h.contains(std::string_view("b")));
+}
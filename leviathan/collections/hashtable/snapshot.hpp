@@ -0,0 +1,724 @@
+/**
+ * A read-only snapshot of py_hashtable which can be mapped into memory and
+ * queried without deserialization.
+ *
+ * The table keeps elements in slots and their positions in indices, both arrays
+ * can be written to file directly if the element is trivially copyable. The
+ * layout of file(version 1) is:
+ *
+ *  +-------------------+ 0
+ *  | snapshot_header   |
+ *  +-------------------+ indices_offset
+ *  | indices           | index_storage_size(capacity) * 8 bytes
+ *  +-------------------+ ctrl_offset
+ *  | control bytes     | capacity bytes, only for group probing
+ *  +-------------------+ slots_offset
+ *  | slots             | used * sizeof(slot_type) bytes, removed elements included
+ *  +-------------------+ file_size
+ *
+ * Each section is aligned to 64 bytes. The header records the layout of slot,
+ * a fingerprint of hash function and probe sequence and a checksum of the whole
+ * file. Snapshots written by another hasher, another table type or a machine
+ * with different byte order are rejected when loading.
+ *
+ * The file is mapped by mmap, so it is only available on Linux.
+*/
+#pragma once
+
+#if !defined(__linux__)
+#error "snapshot requires mmap."
+#endif
+
+#include "pyhash.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cpp::collections
+{
+
+namespace detail
+{
+
+// std::pair is never trivially copyable since its assignment operators are
+// user-provided, but its copy constructor and destructor are trivial if both
+// members are, which is enough for reading it from file.
+template <typename T>
+struct is_snapshot_value : std::is_trivially_copyable<T> { };
+
+template <typename T1, typename T2>
+struct is_snapshot_value<std::pair<T1, T2>>
+    : std::bool_constant<std::is_trivially_copyable_v<T1> && std::is_trivially_copyable_v<T2>> { };
+
+/**
+ * @brief: A fast non-cryptographic checksum, used to detect broken files.
+ *
+ * Four lanes are updated independently in each step so that the
+ * multiplications can be pipelined.
+*/
+inline std::uint64_t snapshot_checksum(const void* data, std::size_t n, std::uint64_t seed = 0)
+{
+    constexpr std::uint64_t prime = 0x9E3779B97F4A7C15ull;
+
+    auto mix = [](std::uint64_t h, std::uint64_t w) {
+        h = (h ^ w) * prime;
+        return h ^ (h >> 29);
+    };
+
+    auto read = [](const unsigned char* p) {
+        std::uint64_t w;
+        std::memcpy(&w, p, sizeof(w));
+        return w;
+    };
+
+    auto p = static_cast<const unsigned char*>(data);
+    const auto length = n;
+
+    std::uint64_t lanes[4] = {
+        seed ^ 0x243F6A8885A308D3ull,
+        seed ^ 0x13198A2E03707344ull,
+        seed ^ 0xA4093822299F31D0ull,
+        seed ^ 0x082EFA98EC4E6C89ull
+    };
+
+    for (; n >= 32; p += 32, n -= 32)
+    {
+        lanes[0] = mix(lanes[0], read(p));
+        lanes[1] = mix(lanes[1], read(p + 8));
+        lanes[2] = mix(lanes[2], read(p + 16));
+        lanes[3] = mix(lanes[3], read(p + 24));
+    }
+
+    auto h = mix(mix(mix(lanes[0], lanes[1]), lanes[2]), lanes[3]);
+
+    for (; n >= 8; p += 8, n -= 8)
+    {
+        h = mix(h, read(p));
+    }
+
+    for (; n; ++p, --n)
+    {
+        h = mix(h, *p);
+    }
+
+    return mix(h, length);
+}
+
+/**
+ * @brief: A read-only memory mapping of the whole file.
+*/
+class mapped_file
+{
+public:
+
+    explicit mapped_file(const std::filesystem::path& path)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (fd == -1)
+        {
+            throw std::system_error(errno, std::generic_category(), "Failed to open " + path.string());
+        }
+
+        struct ::stat st;
+
+        if (::fstat(fd, &st) == -1)
+        {
+            const auto error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "Failed to stat " + path.string());
+        }
+
+        m_size = static_cast<std::size_t>(st.st_size);
+
+        if (m_size)
+        {
+            auto data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            const auto error = errno;
+
+            // The mapping is still valid after the file is closed.
+            ::close(fd);
+
+            if (data == MAP_FAILED)
+            {
+                throw std::system_error(error, std::generic_category(), "Failed to map " + path.string());
+            }
+
+            m_data = static_cast<const unsigned char*>(data);
+        }
+        else
+        {
+            ::close(fd);
+        }
+    }
+
+    mapped_file(const mapped_file&) = delete;
+
+    mapped_file(mapped_file&& rhs) noexcept
+        : m_data(std::exchange(rhs.m_data, nullptr)), m_size(std::exchange(rhs.m_size, 0)) { }
+
+    mapped_file& operator=(mapped_file rhs) noexcept
+    {
+        std::swap(m_data, rhs.m_data);
+        std::swap(m_size, rhs.m_size);
+        return *this;
+    }
+
+    ~mapped_file()
+    {
+        if (m_data)
+        {
+            ::munmap(const_cast<unsigned char*>(m_data), m_size);
+        }
+    }
+
+    const unsigned char* data() const
+    { return m_data; }
+
+    std::size_t size() const
+    { return m_size; }
+
+private:
+
+    const unsigned char* m_data = nullptr;
+    std::size_t m_size = 0;
+};
+
+} // namespace detail
+
+struct snapshot_header
+{
+    static constexpr char signature[8] = { 'L', 'V', 'P', 'Y', 'H', 'A', 'S', 'H' };
+    static constexpr std::uint32_t current_version = 1;
+    static constexpr std::uint32_t byte_order_mark = 0x01020304;
+    static constexpr std::uint64_t cache_hash_code_flag = 1;
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t fingerprint;      // hash codes and probe positions of some elements
+    std::uint64_t checksum;         // header with zero checksum and all sections
+    std::uint64_t size;
+    std::uint64_t capacity;
+    std::uint64_t used;
+    std::uint64_t index_width;
+    std::uint64_t slot_size;
+    std::uint64_t slot_align;
+    std::uint64_t group_width;      // zero if group probing is not used
+    std::uint64_t flags;
+    std::uint64_t indices_offset;
+    std::uint64_t ctrl_offset;
+    std::uint64_t slots_offset;
+    std::uint64_t file_size;
+};
+
+static_assert(std::is_trivially_copyable_v<snapshot_header> && std::has_unique_object_representations_v<snapshot_header>);
+
+/**
+ * @brief: A py_hashtable loaded from file by mmap.
+ *
+ * The indices and slots are used in place, so loading only checks the header
+ * and optionally the checksum. Lookups probe the mapped memory in the same way
+ * as the table.
+ *
+ * @param Table py_hashtable whose value_type is trivially copyable.
+*/
+template <typename Table>
+class py_hashtable_snapshot
+{
+    using key_value = typename Table::key_value;
+    using slot_type = typename Table::slot_type;
+    using index_type = typename Table::index_type;
+    using index_storage_type = typename Table::index_storage_type;
+    using hash_generator_type = typename Table::hash_generator_type;
+
+    static constexpr bool GroupProbing = Table::GroupProbing;
+    static constexpr bool CacheHashCode = Table::IsCacheHashCode;
+    static constexpr bool IsTransparent = Table::IsTransparent;
+    static constexpr index_type SlotUnused = Table::SlotUnused;
+    static constexpr index_type SlotDeleted = Table::SlotDeleted;
+
+    static constexpr std::size_t section_alignment = 64;
+    static constexpr std::size_t fingerprint_samples = 16;
+
+    static_assert(detail::is_snapshot_value<typename Table::value_type>::value,
+        "Only the table with trivially copyable elements can be written to snapshot.");
+    static_assert(alignof(slot_type) <= section_alignment);
+
+public:
+
+    using key_type = typename Table::key_type;
+    using value_type = typename Table::value_type;
+    using hasher = typename Table::hasher;
+    using key_equal = typename Table::key_equal;
+    using allocator_type = typename Table::allocator_type;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = const value_type&;
+    using const_reference = const value_type&;
+
+private:
+
+    template <typename U>
+    using key_arg_t = detail::key_arg<IsTransparent, U, key_type>;
+
+    struct snapshot_iterator
+    {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = value_type;
+        using reference = const value_type&;
+        using pointer = const value_type*;
+        using difference_type = std::ptrdiff_t;
+
+        const py_hashtable_snapshot* m_link = nullptr;
+        std::size_t m_idx = 0;
+
+        bool operator==(const snapshot_iterator&) const = default;
+
+        reference operator*() const
+        {
+            return m_link->m_slots[m_link->index_at(m_idx)].value();
+        }
+
+        pointer operator->() const
+        {
+            return std::addressof(**this);
+        }
+
+        snapshot_iterator& operator++()
+        {
+            m_idx = m_link->next_active(m_idx + 1);
+            return *this;
+        }
+
+        snapshot_iterator operator++(int)
+        {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
+    };
+
+public:
+
+    using iterator = snapshot_iterator;
+    using const_iterator = snapshot_iterator;
+
+    /**
+     * @brief: Map the snapshot into memory.
+     *
+     * @param verify_checksum Whether to check the checksum of whole file. It reads
+     *  all pages of file, skip it only if the file is trusted.
+     * @exception: std::system_error if the file cannot be mapped, std::runtime_error
+     *  if the file is not a valid snapshot of Table.
+    */
+    explicit py_hashtable_snapshot(const std::filesystem::path& path, bool verify_checksum = true, const hasher& hash = hasher(), const key_equal& ke = key_equal())
+        : m_file(path), m_hk(hash, ke)
+    {
+        if (m_file.size() < sizeof(snapshot_header))
+        {
+            throw std::runtime_error("Snapshot is too small");
+        }
+
+        snapshot_header header;
+        std::memcpy(&header, m_file.data(), sizeof(header));
+
+        if (std::memcmp(header.magic, snapshot_header::signature, sizeof(header.magic)) != 0)
+        {
+            throw std::runtime_error("Not a py_hashtable snapshot");
+        }
+
+        if (header.version != snapshot_header::current_version)
+        {
+            throw std::runtime_error("Unsupported snapshot version " + std::to_string(header.version));
+        }
+
+        if (header.byte_order != snapshot_header::byte_order_mark)
+        {
+            throw std::runtime_error("Snapshot is written with different byte order");
+        }
+
+        const bool valid_capacity = header.capacity == 0
+            || (std::has_single_bit(header.capacity) && header.capacity >= Table::default_hash_size);
+
+        if (!valid_capacity || header.used > header.capacity || header.size > header.used)
+        {
+            throw std::runtime_error("Snapshot has invalid size");
+        }
+
+        const auto expected = layout(header.capacity, header.used);
+
+        const bool compatible = header.index_width == expected.index_width
+            && header.slot_size == expected.slot_size
+            && header.slot_align == expected.slot_align
+            && header.group_width == expected.group_width
+            && header.flags == expected.flags
+            && header.indices_offset == expected.indices_offset
+            && header.ctrl_offset == expected.ctrl_offset
+            && header.slots_offset == expected.slots_offset;
+
+        if (!compatible)
+        {
+            throw std::runtime_error("Snapshot is written for a different table type");
+        }
+
+        if (header.file_size != m_file.size())
+        {
+            throw std::runtime_error("Snapshot is truncated");
+        }
+
+        auto indices = reinterpret_cast<const index_storage_type*>(m_file.data() + header.indices_offset);
+        auto ctrl = reinterpret_cast<const detail::control_byte*>(m_file.data() + header.ctrl_offset);
+        auto slots = reinterpret_cast<const slot_type*>(m_file.data() + header.slots_offset);
+
+        if (verify_checksum && header.checksum != checksum_of(header, indices, ctrl, slots))
+        {
+            throw std::runtime_error("Snapshot checksum mismatch");
+        }
+
+        // Elements can only be found by the hasher and probe sequence which inserted them.
+        if (header.fingerprint != fingerprint(m_hk, slots, header.used, header.capacity))
+        {
+            throw std::runtime_error("Snapshot is written with a different hash function");
+        }
+
+        m_indices = indices;
+        m_ctrl = ctrl;
+        m_slots = slots;
+        m_size = header.size;
+        m_capacity = header.capacity;
+        m_used = header.used;
+    }
+
+    /**
+     * @brief: Write the table to path.
+     *
+     * The file is written to a temporary file next to path first and then renamed,
+     * so readers never see a partially written snapshot.
+    */
+    static void save(const Table& table, const std::filesystem::path& path)
+    {
+        auto header = layout(table.m_capacity, table.m_used);
+        header.size = table.m_size;
+        header.fingerprint = fingerprint(table.m_hk, table.m_slots, table.m_used, table.m_capacity);
+        header.checksum = checksum_of(header, table.m_indices, table.m_ctrl, table.m_slots);
+
+        auto temp = path;
+        temp += ".tmp";
+
+        {
+            std::ofstream ofs(temp, std::ios::binary | std::ios::out | std::ios::trunc);
+
+            if (!ofs)
+            {
+                throw std::runtime_error("Failed to create snapshot " + temp.string());
+            }
+
+            std::size_t position = 0;
+
+            auto write_section = [&](std::size_t offset, const void* data, std::size_t n) {
+                constexpr char zeros[section_alignment] = {};
+
+                // Padding between sections.
+                ofs.write(zeros, static_cast<std::streamsize>(offset - position));
+                ofs.write(static_cast<const char*>(data), static_cast<std::streamsize>(n));
+                position = offset + n;
+            };
+
+            write_section(0, &header, sizeof(header));
+            write_section(header.indices_offset, table.m_indices, indices_bytes(header));
+            write_section(header.ctrl_offset, table.m_ctrl, ctrl_bytes(header));
+            write_section(header.slots_offset, table.m_slots, slots_bytes(header));
+
+            ofs.close();
+
+            if (!ofs)
+            {
+                throw std::runtime_error("Failed to write snapshot " + temp.string());
+            }
+        }
+
+        std::filesystem::rename(temp, path);
+    }
+
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    size_type capacity() const
+    {
+        return m_capacity;
+    }
+
+    hasher hash_function() const
+    {
+        return static_cast<hasher>(m_hk);
+    }
+
+    key_equal key_eq() const
+    {
+        return static_cast<key_equal>(m_hk);
+    }
+
+    const_iterator begin() const
+    {
+        return { this, next_active(0) };
+    }
+
+    const_iterator end() const
+    {
+        return { this, m_capacity };
+    }
+
+    template <typename K = key_type>
+    const_iterator find(const key_arg_t<K>& x) const
+    {
+        return { this, find_slot_by_key(x) };
+    }
+
+    template <typename K = key_type>
+    bool contains(const key_arg_t<K>& x) const
+    {
+        return find_slot_by_key(x) != m_capacity;
+    }
+
+    template <typename K = key_type>
+    size_type count(const key_arg_t<K>& x) const
+    {
+        return contains(x);
+    }
+
+    /**
+     * @brief: Copy the snapshot into a mutable table.
+     *
+     * The arrays are copied as a whole without rehashing, so the table has the
+     * same capacity and iteration order as the one written.
+    */
+    Table to_table(const allocator_type& alloc = allocator_type()) const
+    {
+        Table table(hash_function(), key_eq(), alloc);
+
+        if (m_capacity)
+        {
+            table.initialize(m_capacity);
+            std::memcpy(table.m_indices, m_indices, Table::index_storage_size(m_capacity) * sizeof(index_storage_type));
+            std::memcpy(static_cast<void*>(table.m_slots), m_slots, m_used * sizeof(slot_type));
+
+            if constexpr (GroupProbing)
+            {
+                std::memcpy(table.m_ctrl, m_ctrl, m_capacity);
+            }
+
+            table.m_size = m_size;
+            table.m_used = m_used;
+        }
+
+        return table;
+    }
+
+private:
+
+    static constexpr std::size_t align_up(std::size_t n)
+    {
+        return (n + section_alignment - 1) / section_alignment * section_alignment;
+    }
+
+    static std::size_t indices_bytes(const snapshot_header& header)
+    {
+        return Table::index_storage_size(header.capacity) * sizeof(index_storage_type);
+    }
+
+    static std::size_t ctrl_bytes(const snapshot_header& header)
+    {
+        return GroupProbing ? header.capacity : 0;
+    }
+
+    static std::size_t slots_bytes(const snapshot_header& header)
+    {
+        return header.used * sizeof(slot_type);
+    }
+
+    /**
+     * @brief: The header of table with capacity and used, the size,
+     *  fingerprint and checksum are left zero.
+    */
+    static snapshot_header layout(std::size_t capacity, std::size_t used)
+    {
+        snapshot_header header = {};
+
+        std::memcpy(header.magic, snapshot_header::signature, sizeof(header.magic));
+        header.version = snapshot_header::current_version;
+        header.byte_order = snapshot_header::byte_order_mark;
+        header.capacity = capacity;
+        header.used = used;
+        header.index_width = capacity ? Table::index_width_of(capacity) : 0;
+        header.slot_size = sizeof(slot_type);
+        header.slot_align = alignof(slot_type);
+        header.flags = CacheHashCode ? snapshot_header::cache_hash_code_flag : 0;
+
+        if constexpr (GroupProbing)
+        {
+            header.group_width = hash_generator_type::group_width;
+        }
+
+        header.indices_offset = align_up(sizeof(snapshot_header));
+        header.ctrl_offset = align_up(header.indices_offset + indices_bytes(header));
+        header.slots_offset = align_up(header.ctrl_offset + ctrl_bytes(header));
+        header.file_size = header.slots_offset + slots_bytes(header);
+
+        return header;
+    }
+
+    static std::uint64_t checksum_of(snapshot_header header, const index_storage_type* indices, const detail::control_byte* ctrl, const slot_type* slots)
+    {
+        header.checksum = 0;
+
+        auto h = detail::snapshot_checksum(&header, sizeof(header));
+        h = detail::snapshot_checksum(indices, indices_bytes(header), h);
+        h = detail::snapshot_checksum(ctrl, ctrl_bytes(header), h);
+        return detail::snapshot_checksum(slots, slots_bytes(header), h);
+    }
+
+    /**
+     * @brief: Hash codes and the first two probe positions of the first few elements.
+     *
+     * If the hasher(e.g. a seeded one) or the probe sequence is changed, the
+     * elements in snapshot cannot be found anymore.
+    */
+    static std::uint64_t fingerprint(const hash_key_equal<hasher, key_equal>& hk, const slot_type* slots, std::size_t used, std::size_t capacity)
+    {
+        std::uint64_t samples[fingerprint_samples * 3] = {};
+        const auto n = std::min(used, fingerprint_samples);
+
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const auto hash_code = hk(key_value()(slots[i].value()));
+            hash_generator_type g { hash_code, capacity };
+
+            samples[i * 3] = hash_code;
+            samples[i * 3 + 1] = *g;
+            samples[i * 3 + 2] = g();
+        }
+
+        return detail::snapshot_checksum(samples, sizeof(samples), n);
+    }
+
+    index_type index_at(std::size_t offset) const
+    {
+        return Table::load_index(m_indices, m_capacity, offset);
+    }
+
+    std::size_t next_active(std::size_t idx) const
+    {
+        for (; idx < m_capacity && index_at(idx) >= SlotDeleted; idx++);
+        return idx;
+    }
+
+    template <typename K>
+    bool check_equal(std::size_t hash_code, std::size_t pos, const K& x) const
+    {
+        if constexpr (CacheHashCode)
+        {
+            return hash_code == m_slots[pos].m_hash_code
+                && m_hk(x, key_value()(m_slots[pos].value()));
+        }
+        else
+        {
+            return m_hk(x, key_value()(m_slots[pos].value()));
+        }
+    }
+
+    /**
+     * @brief: Find the location of x.
+     * @return: The offset of x in indices or capacity if x is not found.
+    */
+    template <typename K>
+    std::size_t find_slot_by_key(const K& x) const
+    {
+        if (m_capacity == 0)
+        {
+            return m_capacity;
+        }
+
+        const auto hash_code = m_hk(x);
+        hash_generator_type g { hash_code, m_capacity };
+
+        if constexpr (GroupProbing)
+        {
+            using group_type = typename hash_generator_type::group_type;
+            const auto h2 = hash_generator_type::h2(hash_code);
+
+            while (1)
+            {
+                const auto base = *g;
+                const group_type group { m_ctrl + base };
+
+                for (auto mask = group.match(h2); mask; mask &= mask - 1)
+                {
+                    const auto offset = base + std::countr_zero(mask);
+
+                    if (check_equal(hash_code, index_at(offset), x))
+                        return offset;
+                }
+
+                if (group.match_empty())
+                    return m_capacity;
+
+                g();
+            }
+        }
+        else
+        {
+            for (auto offset = *g; ; offset = g())
+            {
+                const auto pos = index_at(offset);
+
+                if (pos == SlotUnused)
+                    return m_capacity;
+
+                if (pos != SlotDeleted && check_equal(hash_code, pos, x))
+                    return offset;
+            }
+        }
+        std::unreachable();
+    }
+
+    detail::mapped_file m_file;
+    [[no_unique_address]] hash_key_equal<hasher, key_equal> m_hk;
+
+    const index_storage_type* m_indices = nullptr;
+    const detail::control_byte* m_ctrl = nullptr;
+    const slot_type* m_slots = nullptr;
+    std::size_t m_size = 0;
+    std::size_t m_capacity = 0;
+    std::size_t m_used = 0;
+};
+
+/**
+ * @brief: Write table to path, see py_hashtable_snapshot.
+*/
+template <typename Table>
+void save_snapshot(const Table& table, const std::filesystem::path& path)
+{
+    py_hashtable_snapshot<Table>::save(table, path);
+}
+
+} // namespace cpp::collections
+
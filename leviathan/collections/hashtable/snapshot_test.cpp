@@ -0,0 +1,166 @@
+#include "snapshot.hpp"
+#include <catch2/catch_all.hpp>
+
+#include <filesystem>
+#include <fstream>
+
+template <typename T>
+using pyhashset = cpp::collections::py_hashtable<
+    cpp::collections::identity<T>,
+    std::hash<T>,
+    std::equal_to<T>,
+    std::allocator<T>
+>;
+
+using pyhashmap = cpp::collections::py_hashtable<
+    cpp::collections::select1st<int, double>,
+    std::hash<int>,
+    std::equal_to<int>,
+    std::allocator<std::pair<const int, double>>,
+    cpp::collections::detail::group_hash_generator<>
+>;
+
+struct shifted_hash
+{
+    std::size_t operator()(int x) const
+    { return std::hash<int>()(x) + 1; }
+};
+
+using shifted_hashset = cpp::collections::py_hashtable<
+    cpp::collections::identity<int>,
+    shifted_hash,
+    std::equal_to<int>,
+    std::allocator<int>
+>;
+
+static std::filesystem::path snapshot_path(const char* name)
+{
+    return std::filesystem::temp_directory_path() / name;
+}
+
+TEST_CASE("snapshot round trip")
+{
+    const auto path = snapshot_path("leviathan_pyhash_set.snapshot");
+
+    pyhashset<int> s;
+
+    for (int i = 0; i < 10000; ++i)
+        s.insert(i);
+
+    for (int i = 0; i < 10000; i += 3)
+        s.erase(i);
+
+    cpp::collections::save_snapshot(s, path);
+
+    cpp::collections::py_hashtable_snapshot<pyhashset<int>> snapshot(path);
+
+    CHECK(snapshot.size() == s.size());
+    CHECK(snapshot.capacity() == s.capacity());
+    CHECK(std::ranges::equal(snapshot, s));
+
+    for (int i = -100; i < 10100; ++i)
+        CHECK(snapshot.contains(i) == s.contains(i));
+
+    auto table = snapshot.to_table();
+
+    CHECK(table.size() == s.size());
+    CHECK(std::ranges::equal(table, s));
+
+    table.insert(-1);
+    CHECK(table.contains(-1));
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("snapshot with group probing")
+{
+    const auto path = snapshot_path("leviathan_pyhash_map.snapshot");
+
+    pyhashmap m;
+
+    for (int i = 0; i < 1000; ++i)
+        m.emplace(i, i * 0.5);
+
+    cpp::collections::save_snapshot(m, path);
+
+    cpp::collections::py_hashtable_snapshot<pyhashmap> snapshot(path);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto it = snapshot.find(i);
+        REQUIRE(it != snapshot.end());
+        CHECK(it->second == i * 0.5);
+    }
+
+    CHECK(snapshot.find(1000) == snapshot.end());
+
+    auto table = snapshot.to_table();
+
+    CHECK(table.size() == m.size());
+    CHECK(table.contains(999));
+    CHECK(!table.contains(1000));
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("snapshot of empty table")
+{
+    const auto path = snapshot_path("leviathan_pyhash_empty.snapshot");
+
+    cpp::collections::save_snapshot(pyhashset<int>(), path);
+
+    cpp::collections::py_hashtable_snapshot<pyhashset<int>> snapshot(path);
+
+    CHECK(snapshot.empty());
+    CHECK(snapshot.begin() == snapshot.end());
+    CHECK(!snapshot.contains(0));
+    CHECK(snapshot.to_table().empty());
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("snapshot rejects invalid file")
+{
+    const auto path = snapshot_path("leviathan_pyhash_invalid.snapshot");
+
+    // Only the first few elements are sampled by fingerprint.
+    pyhashset<int> s;
+
+    for (int i = 0; i < 100; ++i)
+        s.insert(i);
+
+    cpp::collections::save_snapshot(s, path);
+
+    SECTION("different table type")
+    {
+        using snapshot_type = cpp::collections::py_hashtable_snapshot<pyhashset<long long>>;
+        CHECK_THROWS_AS(snapshot_type(path), std::runtime_error);
+    }
+
+    SECTION("different hash function")
+    {
+        using snapshot_type = cpp::collections::py_hashtable_snapshot<shifted_hashset>;
+        CHECK_THROWS_AS(snapshot_type(path), std::runtime_error);
+    }
+
+    SECTION("broken file")
+    {
+        {
+            std::fstream fs(path, std::ios::binary | std::ios::in | std::ios::out);
+            fs.seekp(-1, std::ios::end);
+            fs.put('\x7f');
+        }
+
+        using snapshot_type = cpp::collections::py_hashtable_snapshot<pyhashset<int>>;
+        CHECK_THROWS_AS(snapshot_type(path), std::runtime_error);
+        CHECK_NOTHROW(snapshot_type(path, false));
+    }
+
+    SECTION("missing file")
+    {
+        using snapshot_type = cpp::collections::py_hashtable_snapshot<pyhashset<int>>;
+        CHECK_THROWS_AS(snapshot_type(snapshot_path("leviathan_pyhash_missing.snapshot")), std::system_error);
+    }
+
+    std::filesystem::remove(path);
+}
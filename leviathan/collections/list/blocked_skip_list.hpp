@@ -0,0 +1,756 @@
+/**
+ * An unrolled(blocked) skip list.
+ *
+ * skip_list stores one element in each node, so a range scan touches a new node,
+ * and usually a new cache line, for every element. Here the bottom level is a
+ * doubly linked list of blocks, each block stores up to BlockSize sorted elements
+ * in an inline array, and the upper levels index the blocks. A scan reads the
+ * elements of a block contiguously and a search only walks n / BlockSize towers.
+ *
+ * - Blocks are ordered by their last elements. A search stops at the last block
+ *   on each level whose last element is less than the key, so the target block is
+ *   always the next one on the bottom level and the blocks found by the search
+ *   are exactly the predecessors of the target block.
+ * - The tower(forward pointers) of a block is placed after its elements in the
+ *   same allocation by cpp::layout, whatever the height of the tower is.
+ * - A full block is split into halves, but an element appended after the last
+ *   block starts a new block, so ascending insertion fills each block completely.
+ * - An emptied block is unlinked, and a block is merged with its successor when
+ *   both of them fit in 3/4 of a block after erasing.
+ *
+ * Iterator invalidation:
+ * - Same as btree, insert/emplace/erase invalidate all iterators, references and
+ *   pointers to elements of the list(including end()).
+ *
+ * Elements are relocated(move constructed and destroyed) when blocks are shifted,
+ * split or merged. If relocating throws, std::terminate is called.
+*/
+#pragma once
+
+#include <leviathan/collections/common.hpp>
+#include <leviathan/collections/container_interface.hpp>
+#include <leviathan/utils/layout.hpp>
+#include <leviathan/allocators/adaptor_allocator.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <random>
+
+namespace cpp::collections
+{
+
+namespace detail
+{
+
+// Keep the elements of a block in about 8 cache lines like btree.
+template <typename T>
+inline constexpr std::size_t skip_block_capacity = std::clamp<std::size_t>(512 / sizeof(T), 16, 64);
+
+} // namespace detail
+
+/*
+
+struct skip_block
+{
+    skip_block* m_prev;     // Double recycle link list of blocks
+    int m_level;            // Size of next
+    uint32_t m_count;       // Number of elements
+    T values[BlockSize];    // Elements, only the first m_count are constructed
+    skip_block* m_next[];   // Flexible array member
+};
+
+*/
+template <typename T, std::size_t BlockSize>
+struct skip_block
+{
+    using node_layout_type = cpp::layout<skip_block, T, skip_block*>;
+
+    skip_block* m_prev;
+    int m_level;
+    std::uint32_t m_count;
+
+    // The offsets of elements and tower do not depend on the height of tower.
+    static constexpr auto layout_of(int level)
+    {
+        return node_layout_type(1, BlockSize, level);
+    }
+
+    std::byte* self_ptr()
+    {
+        return reinterpret_cast<std::byte*>(this);
+    }
+
+    T* value_ptr(std::size_t i)
+    {
+        return std::launder(layout_of(0).template pointer<1>(self_ptr()) + i);
+    }
+
+    T& value(std::size_t i)
+    {
+        return *value_ptr(i);
+    }
+
+    T& back()
+    {
+        return value(m_count - 1);
+    }
+
+    skip_block*& next(int i)
+    {
+        return layout_of(0).template pointer<2>(self_ptr())[i];
+    }
+
+    size_t alloc_size() const
+    {
+        return layout_of(m_level).alloc_size();
+    }
+};
+
+template <typename KeyOfValue, typename Block>
+struct blocked_skip_iterator
+{
+    using link_type = Block*;
+    using value_type = typename KeyOfValue::value_type;
+    using key_type = typename KeyOfValue::key_type;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::bidirectional_iterator_tag;
+    using reference = std::conditional_t<std::is_same_v<key_type, value_type>, const value_type&, value_type&>;
+
+    link_type m_block = nullptr;
+    std::size_t m_pos = 0;
+
+    constexpr blocked_skip_iterator() = default;
+    constexpr blocked_skip_iterator(const blocked_skip_iterator&) = default;
+    constexpr blocked_skip_iterator(link_type block, std::size_t pos) : m_block(block), m_pos(pos) { }
+
+    constexpr blocked_skip_iterator base() const
+    {
+        return *this;
+    }
+
+    // The end iterator is the position 0 of header.
+    constexpr blocked_skip_iterator& operator++()
+    {
+        if (++m_pos == m_block->m_count)
+        {
+            m_block = m_block->next(0);
+            m_pos = 0;
+        }
+        return *this;
+    }
+
+    constexpr blocked_skip_iterator& operator--()
+    {
+        if (m_pos == 0)
+        {
+            m_block = m_block->m_prev;
+            m_pos = m_block->m_count;
+        }
+        --m_pos;
+        return *this;
+    }
+
+    constexpr blocked_skip_iterator operator++(int)
+    {
+        blocked_skip_iterator tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    constexpr blocked_skip_iterator operator--(int)
+    {
+        blocked_skip_iterator tmp = *this;
+        --*this;
+        return tmp;
+    }
+
+    constexpr auto operator->() const
+    {
+        return std::addressof(operator*());
+    }
+
+    constexpr reference operator*() const
+    {
+        return m_block->value(m_pos);
+    }
+
+    friend constexpr bool operator==(blocked_skip_iterator, blocked_skip_iterator) = default;
+};
+
+/**
+ * @brief An unrolled skip list.
+ *
+ * @param KeyOfValue Extractor extract key from value. identity<T> for set and select1st<K, V> for map.
+ * @param Compare
+ * @param Allocator
+ * @param UniqueKey True for set/map and False for multiset/multimap.
+ * @param BlockSize Maximum number of elements in each block.
+ * @param RandomEngine Random generator to generate random numbers.
+ * @param SeedGenerator Seed generator for random engine.
+ * @param MaxLevel Max level of block.
+ * @param Ratio Reciprocal of probability.
+*/
+template <typename KeyOfValue,
+    typename Compare,
+    typename Allocator,
+    bool UniqueKey,
+    std::size_t BlockSize = detail::skip_block_capacity<typename KeyOfValue::value_type>,
+    typename RandomEngine = std::mt19937,
+    typename SeedGenerator = std::random_device,
+    int MaxLevel = 16,
+    int Ratio = 4>
+class blocked_skip_list : public iterable_interface,
+                          public std::conditional_t<UniqueKey, unique_insert_interface, insert_interface>,
+                          public erase_interface,
+                          public lookup_interface
+{
+    static_assert(BlockSize >= 4 && BlockSize <= UINT32_MAX);
+    static_assert(Ratio > 1);
+    static_assert(std::is_unsigned_v<typename RandomEngine::result_type>);
+
+    using insert_functions = std::conditional_t<UniqueKey, unique_insert_interface, insert_interface>;
+
+    static constexpr auto pro = std::lerp(RandomEngine::min(), RandomEngine::max(), 1.0 / Ratio);
+
+    static int get_level()
+    {
+        thread_local RandomEngine random = RandomEngine(SeedGenerator()());
+
+        int level = 1;
+        for (; level < MaxLevel && random() < pro; ++level);
+        return level;
+    }
+
+public:
+
+    using value_type = typename KeyOfValue::value_type;
+    using key_type = typename KeyOfValue::key_type;
+    using reference = typename KeyOfValue::reference;
+    using const_reference = typename KeyOfValue::const_reference;
+    using difference_type = std::ptrdiff_t;
+    using key_compare = Compare;
+    using value_compare = Compare;
+    using pointer = std::allocator_traits<Allocator>::pointer;
+    using const_pointer = std::allocator_traits<Allocator>::const_pointer;
+    using size_type = std::size_t;
+    using allocator_type = Allocator;
+
+    static constexpr size_type block_size = BlockSize;
+
+private:
+
+    using block_type = skip_block<value_type, BlockSize>;
+    using node_allocator = adaptor_allocator<Allocator, std::byte>;
+
+    // The last block on each level before some block.
+    using position = std::array<block_type*, MaxLevel>;
+
+    template <typename U>
+    using key_arg_t = detail::key_arg<detail::transparent<Compare>, U, key_type>;
+
+public:
+
+    using iterator = blocked_skip_iterator<KeyOfValue, block_type>;
+    using const_iterator = std::const_iterator<iterator>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    blocked_skip_list(const Compare& compare, const Allocator& allocator)
+        : m_cmp(compare), m_alloc(allocator)
+    {
+        m_header = alloc_block(MaxLevel);
+        reset_header();
+    }
+
+    blocked_skip_list() : blocked_skip_list(Compare(), Allocator()) { }
+
+    blocked_skip_list(const blocked_skip_list&) = delete;
+    blocked_skip_list& operator=(const blocked_skip_list&) = delete;
+
+    ~blocked_skip_list()
+    {
+        clear();
+        dealloc_block(m_header);
+    }
+
+    // Iterators
+    template <typename Self>
+    self_iter_t<Self> begin(this Self&& self)
+    {
+        return iterator(self.m_header->next(0), 0);
+    }
+
+    template <typename Self>
+    self_iter_t<Self> end(this Self&& self)
+    {
+        return iterator(self.m_header, 0);
+    }
+
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    allocator_type get_allocator() const
+    {
+        return allocator_type(m_alloc);
+    }
+
+    size_type max_size() const
+    {
+        return std::allocator_traits<Allocator>::max_size(m_alloc);
+    }
+
+    static KeyOfValue key_of_value()
+    {
+        return KeyOfValue();
+    }
+
+    key_compare key_comp() const
+    {
+        return m_cmp;
+    }
+
+    value_compare value_comp() const
+    {
+        return m_cmp;
+    }
+
+    void clear()
+    {
+        for (auto block = m_header->next(0); block != m_header; )
+        {
+            auto next = block->next(0);
+            std::destroy_n(block->value_ptr(0), block->m_count);
+            dealloc_block(block);
+            block = next;
+        }
+
+        reset_header();
+    }
+
+    // Lookup
+    template <typename Self, typename K = key_type>
+    self_iter_t<Self> lower_bound(this Self&& self, const key_arg_t<K>& x)
+    {
+        auto& list = as_non_const(self);
+        auto pred = [&](const value_type& v) { return list.m_cmp(KeyOfValue()(v), x); };
+        return list.find_first(pred);
+    }
+
+    template <typename Self, typename K = key_type>
+    self_iter_t<Self> upper_bound(this Self&& self, const key_arg_t<K>& x)
+    {
+        auto& list = as_non_const(self);
+        auto pred = [&](const value_type& v) { return !list.m_cmp(x, KeyOfValue()(v)); };
+        return list.find_first(pred);
+    }
+
+    // Modifiers
+    template <typename... Args>
+    auto emplace(Args&&... args)
+    {
+        if constexpr (UniqueKey)
+        {
+            if constexpr (detail::emplace_helper<value_type, Args...>::value ||
+                          (sizeof...(Args) == 1 && detail::transparent<Compare>))
+            {
+                return insert_unique((Args&&)args...);
+            }
+            else
+            {
+                value_handle<value_type, allocator_type> handle(m_alloc, (Args&&)args...);
+                return insert_unique(*handle);
+            }
+        }
+        else
+        {
+            value_handle<value_type, allocator_type> handle(m_alloc, (Args&&)args...);
+            return insert_multi(std::move(*handle));
+        }
+    }
+
+    using erase_interface::erase;
+
+    size_type erase(const key_type& x)
+    {
+        auto first = lower_bound(x);
+        const auto n = static_cast<size_type>(std::distance(first, upper_bound(x)));
+
+        for (auto i = n; i > 0; --i)
+        {
+            first = erase_at(first.m_block, first.m_pos);
+        }
+
+        return n;
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        auto it = pos.base();
+        return erase_at(it.m_block, it.m_pos);
+    }
+
+    // Erasing invalidates last, so we count the elements first.
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        const auto n = static_cast<size_type>(std::distance(first, last));
+
+        if (n == size())
+        {
+            clear();
+            return end();
+        }
+
+        auto it = first.base();
+
+        for (auto i = n; i > 0; --i)
+        {
+            it = erase_at(it.m_block, it.m_pos);
+        }
+
+        return it;
+    }
+
+    using insert_functions::insert;
+
+private:
+
+    const key_type& key_of(const value_type& value) const
+    {
+        return KeyOfValue()(value);
+    }
+
+    // Find the last block on each level whose last element satisfies pred and
+    // return the next block on the bottom level. The elements which satisfy pred
+    // should be a prefix of list.
+    template <typename Pred>
+    block_type* find_position(position& prev, Pred pred)
+    {
+        auto cur = m_header;
+
+        for (int i = m_level - 1; i >= 0; --i)
+        {
+            for (auto next = cur->next(i); next != m_header && pred(next->back()); next = cur->next(i))
+            {
+                cur = next;
+            }
+
+            prev[i] = cur;
+        }
+
+        return cur->next(0);
+    }
+
+    // Return the first element which does not satisfy pred.
+    template <typename Pred>
+    iterator find_first(Pred pred)
+    {
+        auto cur = m_header;
+
+        for (int i = m_level - 1; i >= 0; --i)
+        {
+            for (auto next = cur->next(i); next != m_header && pred(next->back()); next = cur->next(i))
+            {
+                cur = next;
+            }
+        }
+
+        auto block = cur->next(0);
+
+        if (block == m_header)
+        {
+            return end();
+        }
+
+        auto pos = std::partition_point(block->value_ptr(0), block->value_ptr(block->m_count), pred);
+        return iterator(block, pos - block->value_ptr(0));
+    }
+
+    // Find the predecessors of block.
+    void find_position_of(position& prev, block_type* block)
+    {
+        const auto& key = key_of(block->back());
+        auto cur = find_position(prev, [&](const value_type& v) { return m_cmp(key_of(v), key); });
+
+        // Pass the blocks whose last elements are equivalent to the last element of block.
+        for (; cur != block; cur = cur->next(0))
+        {
+            for (int i = 0; i < cur->m_level; ++i)
+            {
+                prev[i] = cur;
+            }
+        }
+    }
+
+    template <typename U>
+    std::pair<iterator, bool> insert_unique(U&& value)
+    {
+        const auto& key = key_of(value);
+        auto pred = [&](const value_type& v) { return m_cmp(key_of(v), key); };
+
+        position prev;
+        auto block = find_position(prev, pred);
+        std::size_t pos = 0;
+
+        if (block != m_header)
+        {
+            pos = std::partition_point(block->value_ptr(0), block->value_ptr(block->m_count), pred) - block->value_ptr(0);
+
+            if (!m_cmp(key, key_of(block->value(pos))))
+            {
+                return { iterator(block, pos), false };
+            }
+        }
+
+        return { insert_at(prev, block, pos, (U&&)value), true };
+    }
+
+    // The new element is placed after the equivalent elements.
+    iterator insert_multi(value_type&& value)
+    {
+        const auto& key = key_of(value);
+        auto pred = [&](const value_type& v) { return !m_cmp(key, key_of(v)); };
+
+        position prev;
+        auto block = find_position(prev, pred);
+        std::size_t pos = 0;
+
+        if (block != m_header)
+        {
+            pos = std::partition_point(block->value_ptr(0), block->value_ptr(block->m_count), pred) - block->value_ptr(0);
+        }
+
+        return insert_at(prev, block, pos, std::move(value));
+    }
+
+    /**
+     * @brief: Insert value before position pos of block.
+     *
+     * @param prev The predecessors of block.
+     * @param block The target block, header if value is greater than all elements.
+    */
+    template <typename U>
+    iterator insert_at(const position& prev, block_type* block, std::size_t pos, U&& value)
+    {
+        // Prefer appending to the previous block, so no element is shifted.
+        if (pos == 0 && prev[0] != m_header && prev[0]->m_count < BlockSize)
+        {
+            block = prev[0];
+            pos = block->m_count;
+        }
+
+        if (block == m_header)
+        {
+            // The value is greater than all elements and the last block is full.
+            auto new_block = alloc_block(get_level());
+
+            try
+            {
+                construct_value(new_block->value_ptr(0), (U&&)value);
+            }
+            catch (...)
+            {
+                dealloc_block(new_block);
+                throw;
+            }
+
+            new_block->m_count = 1;
+            link_block(prev, prev[0], new_block);
+            ++m_size;
+            return iterator(new_block, 0);
+        }
+
+        if (block->m_count == BlockSize)
+        {
+            auto right = alloc_block(get_level());
+            constexpr std::size_t mid = BlockSize / 2;
+
+            relocate_values(block, mid, right, 0, BlockSize - mid);
+            block->m_count = mid;
+            right->m_count = BlockSize - mid;
+            link_block(prev, block, right);
+
+            if (pos > mid)
+            {
+                block = right;
+                pos -= mid;
+            }
+        }
+
+        relocate_values(block, pos, block, pos + 1, block->m_count - pos);
+        block->m_count++;
+
+        try
+        {
+            construct_value(block->value_ptr(pos), (U&&)value);
+        }
+        catch (...)
+        {
+            relocate_values(block, pos + 1, block, pos, block->m_count - pos - 1);
+            block->m_count--;
+            throw;
+        }
+
+        ++m_size;
+        return iterator(block, pos);
+    }
+
+    // Link block after the block `after`, prev are the predecessors of `after`
+    // on the levels which `after` does not reach.
+    void link_block(const position& prev, block_type* after, block_type* block)
+    {
+        const int level = block->m_level;
+
+        for (int i = 0; i < level; ++i)
+        {
+            // The new levels of list start from header.
+            auto pred = i < after->m_level ? after : i < m_level ? prev[i] : m_header;
+            block->next(i) = pred->next(i);
+            pred->next(i) = block;
+        }
+
+        block->m_prev = after;
+        block->next(0)->m_prev = block;
+        m_level = std::max(m_level, level);
+    }
+
+    void unlink_block(const position& prev, block_type* block)
+    {
+        for (int i = 0; i < block->m_level; ++i)
+        {
+            prev[i]->next(i) = block->next(i);
+        }
+
+        block->next(0)->m_prev = block->m_prev;
+        dealloc_block(block);
+
+        for (; m_level > 1 && m_header->next(m_level - 1) == m_header; --m_level);
+    }
+
+    iterator erase_at(block_type* block, std::size_t pos)
+    {
+        auto next = block->next(0);
+        const bool emptied = block->m_count == 1;
+        const bool merged = !emptied && next != m_header && block->m_count - 1 + next->m_count <= BlockSize * 3 / 4;
+
+        // The predecessors are found before erasing since they are searched by the last element.
+        position prev;
+
+        if (emptied || merged)
+        {
+            find_position_of(prev, block);
+        }
+
+        destroy_value(block->value_ptr(pos));
+        relocate_values(block, pos + 1, block, pos, block->m_count - pos - 1);
+        block->m_count--;
+        --m_size;
+
+        if (emptied)
+        {
+            unlink_block(prev, block);
+            return iterator(next, 0);
+        }
+
+        if (merged)
+        {
+            // The predecessors of next are block or the predecessors of block.
+            for (int i = 0; i < block->m_level; ++i)
+            {
+                prev[i] = block;
+            }
+
+            relocate_values(next, 0, block, block->m_count, next->m_count);
+            block->m_count += next->m_count;
+            unlink_block(prev, next);
+        }
+
+        return pos < block->m_count ? iterator(block, pos) : iterator(block->next(0), 0);
+    }
+
+    template <typename... Args>
+    void construct_value(value_type* p, Args&&... args)
+    {
+        std::allocator_traits<Allocator>::construct(m_alloc, p, (Args&&)args...);
+    }
+
+    void destroy_value(value_type* p)
+    {
+        std::allocator_traits<Allocator>::destroy(m_alloc, p);
+    }
+
+    // Relocate n elements from src to dst, the ranges may overlap.
+    void relocate_values(block_type* src, std::size_t from, block_type* dst, std::size_t to, std::size_t n) noexcept
+    {
+        const auto relocate = [this](value_type* x, value_type* y) {
+            construct_value(y, std::move(*x));
+            destroy_value(x);
+        };
+
+        if (src == dst && to > from)
+        {
+            for (std::size_t i = n; i-- > 0; )
+                relocate(src->value_ptr(from + i), dst->value_ptr(to + i));
+        }
+        else
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                relocate(src->value_ptr(from + i), dst->value_ptr(to + i));
+        }
+    }
+
+    [[nodiscard]] block_type* alloc_block(int level)
+    {
+        auto size = block_type::layout_of(level).alloc_size();
+        auto block = static_cast<block_type*>(
+            static_cast<void*>(node_allocator::allocate(m_alloc, size))
+        );
+
+        block->m_level = level;
+        block->m_count = 0;
+        return block;
+    }
+
+    void dealloc_block(block_type* block)
+    {
+        node_allocator::deallocate(m_alloc, block->self_ptr(), block->alloc_size());
+    }
+
+    void reset_header()
+    {
+        m_header->m_prev = m_header;
+
+        for (int i = 0; i < MaxLevel; ++i)
+        {
+            m_header->next(i) = m_header;
+        }
+
+        m_level = 1;
+        m_size = 0;
+    }
+
+    [[no_unique_address]] Compare m_cmp;
+    [[no_unique_address]] Allocator m_alloc;
+    int m_level;
+    block_type* m_header;
+    size_type m_size;
+};
+
+template <typename T, typename Compare = std::less<T>, typename Allocator = std::allocator<T>>
+using blocked_skip_set = blocked_skip_list<identity<T>, Compare, Allocator, true>;
+
+template <typename T, typename Compare = std::less<T>, typename Allocator = std::allocator<T>>
+using blocked_skip_multiset = blocked_skip_list<identity<T>, Compare, Allocator, false>;
+
+} // namespace cpp::collections
+
@@ -0,0 +1,184 @@
+#include "blocked_skip_list.hpp"
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <ranges>
+#include <set>
+#include <string>
+#include <vector>
+#include <catch2/catch_all.hpp>
+
+using namespace cpp::collections;
+
+// Small blocks so that splitting and merging happen frequently.
+using BlockedSkipList = blocked_skip_list<identity<int>, std::ranges::less, std::allocator<int>, true, 4>;
+using MultiBlockedSkipList = blocked_skip_list<identity<int>, std::ranges::less, std::allocator<int>, false, 4>;
+
+template <typename List, typename Set>
+bool same_elements(const List& list, const Set& set)
+{
+    return list.size() == set.size()
+        && std::ranges::equal(list, set)
+        && std::ranges::equal(list | std::views::reverse, set | std::views::reverse);
+}
+
+TEST_CASE("blocked skip list search elements", "[contains][find][lower_bound][upper_bound][count]")
+{
+    BlockedSkipList h;
+
+    REQUIRE(h.empty());
+    REQUIRE(h.begin() == h.end());
+
+    for (int i = 1; i < 100; i += 2)
+    {
+        CHECK(h.insert(i).second);
+    }
+
+    CHECK(!h.insert(1).second);
+    CHECK(h.size() == 50);
+
+    CHECK(h.contains(1));
+    CHECK(!h.contains(0));
+    CHECK(h.find(2) == h.end());
+    CHECK(*h.find(51) == 51);
+
+    CHECK(*h.lower_bound(0) == 1);
+    CHECK(*h.lower_bound(2) == 3);
+    CHECK(h.lower_bound(100) == h.end());
+    CHECK(*h.upper_bound(1) == 3);
+    CHECK(*h.upper_bound(2) == 3);
+    CHECK(h.upper_bound(99) == h.end());
+
+    CHECK(h.count(3) == 1);
+    CHECK(h.count(4) == 0);
+    CHECK(std::ranges::is_sorted(h));
+}
+
+TEST_CASE("blocked skip list random insert and erase")
+{
+    BlockedSkipList h;
+    std::set<int> s;
+    std::mt19937 random(0);
+
+    for (int i = 0; i < 20000; ++i)
+    {
+        const int x = random() % 1000;
+
+        if (random() % 3)
+        {
+            auto [it, ok] = h.insert(x);
+            CHECK(ok == s.insert(x).second);
+            CHECK(*it == x);
+        }
+        else
+        {
+            CHECK(h.erase(x) == s.erase(x));
+        }
+    }
+
+    CHECK(same_elements(h, s));
+
+    // Erase by iterator returns the next element.
+    for (auto it = h.begin(); it != h.end(); )
+    {
+        const auto x = *it;
+        auto next = std::next(s.find(x));
+        s.erase(x);
+
+        if (x % 2)
+        {
+            it = h.erase(it);
+            CHECK((it == h.end() ? next == s.end() : *it == *next));
+        }
+        else
+        {
+            ++it;
+            s.insert(x);
+        }
+    }
+
+    CHECK(same_elements(h, s));
+
+    h.clear();
+    CHECK(h.empty());
+    CHECK(h.insert(1).second);
+}
+
+TEST_CASE("blocked skip list ascending and descending insert")
+{
+    BlockedSkipList h;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        h.insert(i);
+    }
+
+    for (int i = -1; i > -1000; --i)
+    {
+        h.insert(i);
+    }
+
+    CHECK(h.size() == 1999);
+    CHECK(std::ranges::equal(h, std::views::iota(-999, 1000)));
+
+    auto first = h.lower_bound(-500);
+    auto last = h.lower_bound(500);
+    auto it = h.erase(first, last);
+    CHECK(*it == 500);
+    CHECK(h.size() == 999);
+    CHECK(*std::prev(it) == -501);
+
+    h.erase(h.begin(), h.end());
+    CHECK(h.empty());
+}
+
+TEST_CASE("blocked skip list multi-key")
+{
+    MultiBlockedSkipList h;
+    std::multiset<int> s;
+    std::mt19937 random(1);
+
+    for (int i = 0; i < 5000; ++i)
+    {
+        const int x = random() % 100;
+        h.insert(x);
+        s.insert(x);
+    }
+
+    CHECK(same_elements(h, s));
+
+    for (int x = 0; x < 100; ++x)
+    {
+        CHECK(h.count(x) == s.count(x));
+    }
+
+    for (int x = 0; x < 100; x += 3)
+    {
+        CHECK(h.erase(x) == s.erase(x));
+    }
+
+    CHECK(same_elements(h, s));
+}
+
+TEST_CASE("blocked skip list string")
+{
+    blocked_skip_set<std::string> h;
+    std::set<std::string> s;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto str = std::to_string(i * 7 % 1000) + std::string(i % 30, 'x');
+        h.insert(str);
+        s.insert(str);
+    }
+
+    CHECK(same_elements(h, s));
+
+    for (int i = 0; i < 1000; i += 2)
+    {
+        auto str = std::to_string(i * 7 % 1000) + std::string(i % 30, 'x');
+        CHECK(h.erase(str) == s.erase(str));
+    }
+
+    CHECK(same_elements(h, s));
+}
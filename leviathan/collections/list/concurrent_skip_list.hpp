@@ -0,0 +1,680 @@
+/**
+ * A lock-free ordered set/map based on skip list.
+ *
+ * The forward pointers of each node are atomic and the lowest bit of a pointer
+ * is used as the deletion mark(Harris). Erasing an element marks the forward
+ * pointers of node from the top level down, the thread which marks the bottom
+ * level owns the erasure. Marked nodes are unlinked by any thread that meets
+ * them during searching, so find/insert/erase never block each other.
+ *
+ * The memory of unlinked nodes is reclaimed by an epoch_domain owned by the
+ * list. A node may still be linked into the upper levels by its inserter after
+ * it is erased, so both the inserter and the eraser hold a reference of node
+ * and the last one unlinks it from all levels and retires it.
+ *
+ * Like concurrent_hash_map, there is no iterator escaping from the container.
+ * Elements are accessed by visitors which are invoked while the domain is
+ * pinned, the visitor only gets a const reference since other threads may read
+ * the element at the same time. Traversals are weakly consistent, they see each
+ * element at most once but may or may not see concurrent modifications.
+ *
+ * Compare should not throw.
+*/
+#pragma once
+
+#include <leviathan/collections/common.hpp>
+#include <leviathan/collections/epoch.hpp>
+#include <leviathan/utils/layout.hpp>
+#include <leviathan/allocators/adaptor_allocator.hpp>
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+namespace cpp::collections
+{
+
+/*
+
+struct concurrent_skip_node : epoch_node
+{
+    int m_level;                       // Size of next
+    std::atomic<int> m_owners;         // Inserter and eraser
+    T value;                           // Value field, not constructed for header
+    std::atomic<uintptr_t> m_next[];   // Marked pointers
+};
+
+*/
+template <typename T>
+struct concurrent_skip_node : epoch_node
+{
+    using node_layout_type = cpp::layout<concurrent_skip_node, T, std::atomic<std::uintptr_t>>;
+
+    static constexpr std::uintptr_t mark_bit = 1;
+
+    int m_level;
+    std::atomic<int> m_owners;
+
+    constexpr auto self_layout() const
+    {
+        return node_layout_type(1, 1, m_level);
+    }
+
+    template <typename Self>
+    constexpr auto self_ptr(this Self& self)
+    {
+        using byte_type = std::conditional_t<std::is_const_v<Self>, const std::byte, std::byte>;
+        return reinterpret_cast<byte_type*>(std::addressof(self));
+    }
+
+    template <typename Self>
+    constexpr auto value_ptr(this Self& self)
+    {
+        return self.self_layout().template pointer<1>(self.self_ptr());
+    }
+
+    std::atomic<std::uintptr_t>& next(int level)
+    {
+        return self_layout().template pointer<2>(self_ptr())[level];
+    }
+
+    constexpr size_t alloc_size() const
+    {
+        return self_layout().alloc_size();
+    }
+
+    static concurrent_skip_node* get_pointer(std::uintptr_t p)
+    {
+        return reinterpret_cast<concurrent_skip_node*>(p & ~mark_bit);
+    }
+
+    static bool is_marked(std::uintptr_t p)
+    {
+        return p & mark_bit;
+    }
+
+    static std::uintptr_t to_link(concurrent_skip_node* node)
+    {
+        return reinterpret_cast<std::uintptr_t>(node);
+    }
+};
+
+/**
+ * @brief A lock-free skip list with unique keys.
+ *
+ * @param KeyOfValue Extractor extract key from value. identity<T> for set and select1st<K, V> for map.
+ * @param Compare
+ * @param Allocator
+ * @param RandomEngine Random generator to generate random numbers, each thread has its own engine.
+ * @param SeedGenerator Seed generator for random engine.
+ * @param MaxLevel Max level of node.
+ * @param Ratio Reciprocal of probability.
+*/
+template <typename KeyOfValue,
+    typename Compare,
+    typename Allocator,
+    typename RandomEngine = std::mt19937,
+    typename SeedGenerator = std::random_device,
+    int MaxLevel = 24,
+    int Ratio = 4>
+class concurrent_skip_list
+{
+    static_assert(Ratio > 1);
+    static_assert(MaxLevel > 0);
+    static_assert(std::is_unsigned_v<typename RandomEngine::result_type>);
+
+    static constexpr auto pro = std::lerp(RandomEngine::min(), RandomEngine::max(), 1.0 / Ratio);
+
+    static int get_level()
+    {
+        thread_local RandomEngine random = RandomEngine(SeedGenerator()());
+
+        int level = 1;
+        for (; level < MaxLevel && random() < pro; ++level);
+        return level;
+    }
+
+public:
+
+    using value_type = typename KeyOfValue::value_type;
+    using key_type = typename KeyOfValue::key_type;
+    using key_compare = Compare;
+    using allocator_type = Allocator;
+    using size_type = std::size_t;
+
+private:
+
+    using list_node = concurrent_skip_node<value_type>;
+    using node_allocator = adaptor_allocator<Allocator, std::byte>;
+    using guard = epoch_domain::guard;
+
+    template <typename U>
+    using key_arg_t = detail::key_arg<detail::transparent<Compare>, U, key_type>;
+
+    // Predecessors and successors of a key on each level.
+    struct position
+    {
+        std::array<list_node*, MaxLevel> m_preds;
+        std::array<list_node*, MaxLevel> m_succs;
+    };
+
+public:
+
+    concurrent_skip_list(const Compare& compare, const Allocator& allocator)
+        : m_cmp(compare), m_alloc(allocator)
+    {
+        m_header = alloc_node(MaxLevel);
+        reset_header();
+    }
+
+    concurrent_skip_list() : concurrent_skip_list(Compare(), Allocator()) { }
+
+    concurrent_skip_list(const concurrent_skip_list&) = delete;
+    concurrent_skip_list& operator=(const concurrent_skip_list&) = delete;
+
+    ~concurrent_skip_list()
+    {
+        reset();
+        dealloc_node(m_header);
+    }
+
+    /**
+     * @brief: Number of elements, it may be stale if other threads are modifying the list.
+    */
+    size_type size() const
+    {
+        return m_size.load(std::memory_order_relaxed);
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    allocator_type get_allocator() const
+    {
+        return allocator_type(m_alloc);
+    }
+
+    key_compare key_comp() const
+    {
+        return m_cmp;
+    }
+
+    static KeyOfValue key_of_value()
+    {
+        return KeyOfValue();
+    }
+
+    template <typename K = key_type>
+    bool contains(const key_arg_t<K>& key) const
+    {
+        return visit(key, [](const value_type&) { });
+    }
+
+    template <typename K = key_type>
+    size_type count(const key_arg_t<K>& key) const
+    {
+        return contains(key);
+    }
+
+    /**
+     * @brief: Invoke fn with the element whose key is equal to key.
+     * @return: True if the element is found.
+    */
+    template <typename Fn, typename K = key_type>
+    bool visit(const key_arg_t<K>& key, Fn fn) const
+    {
+        auto g = m_epoch.pin();
+
+        if (auto node = find_node(key); node)
+        {
+            fn(std::as_const(*node->value_ptr()));
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief: Invoke fn with each element in ascending order.
+    */
+    template <typename Fn>
+    void visit_all(Fn fn) const
+    {
+        auto g = m_epoch.pin();
+        visit_from(m_header, fn, [](const auto&) { return true; });
+    }
+
+    /**
+     * @brief: Invoke fn with each element whose key is in [first, last) in ascending order.
+    */
+    template <typename Fn, typename K1 = key_type, typename K2 = key_type>
+    void visit_range(const key_arg_t<K1>& first, const key_arg_t<K2>& last, Fn fn) const
+    {
+        auto g = m_epoch.pin();
+        visit_from(find_last_less(first), fn, [&](const auto& key) { return m_cmp(key, last); });
+    }
+
+    /**
+     * @brief: Insert an element constructed by args if the key does not exist.
+     * @return: True if the element is inserted.
+    */
+    template <typename... Args>
+    bool emplace(Args&&... args)
+    {
+        return insert_node(create_node((Args&&) args...));
+    }
+
+    bool insert(const value_type& value)
+    {
+        return emplace(value);
+    }
+
+    bool insert(value_type&& value)
+    {
+        return emplace(std::move(value));
+    }
+
+    template <typename K = key_type>
+    size_type erase(const key_arg_t<K>& key)
+    {
+        auto g = m_epoch.pin();
+        position pos;
+
+        while (find_position(key, pos))
+        {
+            auto victim = pos.m_succs[0];
+
+            // Freeze the upper levels first, so no successor will be linked
+            // after the node once it is logically erased.
+            for (int i = victim->m_level - 1; i > 0; --i)
+            {
+                auto succ = victim->next(i).load(std::memory_order_relaxed);
+                while (!list_node::is_marked(succ) && !victim->next(i).compare_exchange_weak(succ, succ | list_node::mark_bit, std::memory_order_acq_rel, std::memory_order_relaxed));
+            }
+
+            auto succ = victim->next(0).load(std::memory_order_relaxed);
+
+            while (!list_node::is_marked(succ))
+            {
+                if (victim->next(0).compare_exchange_weak(succ, succ | list_node::mark_bit, std::memory_order_acq_rel, std::memory_order_relaxed))
+                {
+                    m_size.fetch_sub(1, std::memory_order_relaxed);
+                    release_node(g, victim);
+                    return 1;
+                }
+            }
+
+            // Erased by another thread, a new element with the same key may
+            // be inserted after that, so search again.
+        }
+
+        return 0;
+    }
+
+    /**
+     * @brief: Erase all elements.
+     *
+     * It should not be called concurrently with any other member function.
+    */
+    void clear()
+    {
+        reset();
+    }
+
+private:
+
+    const key_type& key_of(list_node* node) const
+    {
+        return KeyOfValue()(*node->value_ptr());
+    }
+
+    int top_level() const
+    {
+        return m_level.load(std::memory_order_acquire);
+    }
+
+    // Make sure the searching starts from at least level.
+    void raise_level(int level)
+    {
+        auto top = m_level.load(std::memory_order_relaxed);
+        while (top < level && !m_level.compare_exchange_weak(top, level, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // Find the first unmarked node whose key is not less than key and return
+    // it if its key is equal to key. Marked nodes are skipped but not unlinked.
+    template <typename K>
+    list_node* find_node(const K& key) const
+    {
+        auto pred = m_header;
+
+        for (int i = top_level() - 1; i >= 0; --i)
+        {
+            auto curr = list_node::get_pointer(pred->next(i).load(std::memory_order_acquire));
+
+            while (curr)
+            {
+                const auto succ = curr->next(i).load(std::memory_order_acquire);
+
+                if (list_node::is_marked(succ))
+                {
+                    curr = list_node::get_pointer(succ);
+                }
+                else if (m_cmp(key_of(curr), key))
+                {
+                    pred = curr;
+                    curr = list_node::get_pointer(succ);
+                }
+                else
+                {
+                    break;
+                }
+            }
+
+            if (curr && !m_cmp(key, key_of(curr)) && !list_node::is_marked(curr->next(0).load(std::memory_order_acquire)))
+            {
+                return curr;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Return the last node whose key is less than key, or header.
+    template <typename K>
+    list_node* find_last_less(const K& key) const
+    {
+        auto pred = m_header;
+
+        for (int i = top_level() - 1; i >= 0; --i)
+        {
+            auto curr = list_node::get_pointer(pred->next(i).load(std::memory_order_acquire));
+
+            while (curr)
+            {
+                const auto succ = curr->next(i).load(std::memory_order_acquire);
+
+                if (!list_node::is_marked(succ) && m_cmp(key_of(curr), key))
+                {
+                    pred = curr;
+                }
+                else if (!list_node::is_marked(succ))
+                {
+                    break;
+                }
+
+                curr = list_node::get_pointer(succ);
+            }
+        }
+
+        return pred;
+    }
+
+    template <typename Fn, typename InRange>
+    void visit_from(list_node* pred, Fn& fn, InRange in_range) const
+    {
+        auto curr = list_node::get_pointer(pred->next(0).load(std::memory_order_acquire));
+
+        while (curr)
+        {
+            const auto succ = curr->next(0).load(std::memory_order_acquire);
+
+            if (!list_node::is_marked(succ))
+            {
+                if (!in_range(key_of(curr)))
+                {
+                    return;
+                }
+
+                fn(std::as_const(*curr->value_ptr()));
+            }
+
+            curr = list_node::get_pointer(succ);
+        }
+    }
+
+    /**
+     * @brief: Find the predecessors and successors of key on each level below
+     *  top_level(), the marked nodes on the way are unlinked.
+     *
+     * If Upper is false, the successors are the first nodes whose keys are not less
+     * than key, otherwise the first nodes whose keys are greater than key.
+     *
+     * @return: True if the successor of the bottom level has the same key.
+    */
+    template <bool Upper = false, typename K>
+    bool find_position(const K& key, position& pos)
+    {
+    retry:
+        auto pred = m_header;
+        list_node* curr = nullptr;
+
+        for (int i = top_level() - 1; i >= 0; --i)
+        {
+            curr = list_node::get_pointer(pred->next(i).load(std::memory_order_acquire));
+
+            while (curr)
+            {
+                auto succ = curr->next(i).load(std::memory_order_acquire);
+
+                if (list_node::is_marked(succ))
+                {
+                    // The next pointer of a marked node never changes, so linking
+                    // pred to its successor will not lose any node.
+                    auto expected = list_node::to_link(curr);
+                    const auto unmarked = succ & ~list_node::mark_bit;
+
+                    if (!pred->next(i).compare_exchange_strong(expected, unmarked, std::memory_order_acq_rel, std::memory_order_acquire))
+                    {
+                        goto retry;
+                    }
+
+                    curr = list_node::get_pointer(unmarked);
+                    continue;
+                }
+
+                const bool forward = Upper ? !m_cmp(key, key_of(curr)) : m_cmp(key_of(curr), key);
+
+                if (!forward)
+                {
+                    break;
+                }
+
+                pred = curr;
+                curr = list_node::get_pointer(succ);
+            }
+
+            pos.m_preds[i] = pred;
+            pos.m_succs[i] = curr;
+        }
+
+        return !Upper && curr && !m_cmp(key, key_of(curr));
+    }
+
+    bool insert_node(list_node* node)
+    {
+        const int level = node->m_level;
+        const auto& key = key_of(node);
+
+        raise_level(level);
+
+        auto g = m_epoch.pin();
+        position pos;
+
+        // Link the bottom level, the element is inserted once it succeeds.
+        while (true)
+        {
+            if (find_position(key, pos))
+            {
+                drop_node(node);
+                return false;
+            }
+
+            for (int i = 0; i < level; ++i)
+            {
+                node->next(i).store(list_node::to_link(pos.m_succs[i]), std::memory_order_relaxed);
+            }
+
+            auto expected = list_node::to_link(pos.m_succs[0]);
+
+            if (pos.m_preds[0]->next(0).compare_exchange_strong(expected, list_node::to_link(node), std::memory_order_release, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+
+        m_size.fetch_add(1, std::memory_order_relaxed);
+
+        // Link the upper levels, stop if the node is erased by another thread.
+        for (int i = 1; i < level; ++i)
+        {
+            while (true)
+            {
+                auto next = node->next(i).load(std::memory_order_acquire);
+                const auto succ = list_node::to_link(pos.m_succs[i]);
+
+                if (list_node::is_marked(next)
+                 || (next != succ && !node->next(i).compare_exchange_strong(next, succ, std::memory_order_release, std::memory_order_relaxed)))
+                {
+                    if (list_node::is_marked(node->next(i).load(std::memory_order_acquire)))
+                    {
+                        release_node(g, node);
+                        return true;
+                    }
+
+                    continue;
+                }
+
+                auto expected = succ;
+
+                if (pos.m_preds[i]->next(i).compare_exchange_strong(expected, list_node::to_link(node), std::memory_order_release, std::memory_order_relaxed))
+                {
+                    break;
+                }
+
+                // The predecessors are changed, if the node is not found again,
+                // it is erased.
+                find_position(key, pos);
+
+                if (pos.m_succs[0] != node)
+                {
+                    release_node(g, node);
+                    return true;
+                }
+            }
+        }
+
+        release_node(g, node);
+        return true;
+    }
+
+    // Drop the reference of inserter or eraser. The last one unlinks the node from
+    // all levels and retires it.
+    void release_node(guard& g, list_node* node)
+    {
+        if (node->m_owners.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            // Other elements with the same key may be inserted before the node,
+            // so pass all of them to make sure the node is met on each level.
+            position pos;
+            find_position<true>(key_of(node), pos);
+            m_epoch.retire(g, node, [this](epoch_node* p) { drop_node(static_cast<list_node*>(p)); });
+        }
+    }
+
+    template <typename... Args>
+    list_node* create_node(Args&&... args)
+    {
+        auto node = alloc_node(get_level());
+
+        try
+        {
+            std::allocator_traits<Allocator>::construct(m_alloc, node->value_ptr(), (Args&&) args...);
+        }
+        catch (...)
+        {
+            dealloc_node(node);
+            throw;
+        }
+
+        node->m_owners.store(2, std::memory_order_relaxed);
+        return node;
+    }
+
+    [[nodiscard]] list_node* alloc_node(int count)
+    {
+        auto size = typename list_node::node_layout_type(1, 1, count).alloc_size();
+        auto node = static_cast<list_node*>(
+            static_cast<void*>(node_allocator::allocate(m_alloc, size))
+        );
+
+        std::construct_at(node);
+        node->m_level = count;
+
+        for (int i = 0; i < count; ++i)
+        {
+            std::construct_at(&node->next(i), 0);
+        }
+
+        return node;
+    }
+
+    void dealloc_node(list_node* node)
+    {
+        auto size = node->alloc_size();
+        node_allocator::deallocate(m_alloc, node->self_ptr(), size);
+    }
+
+    void drop_node(list_node* node)
+    {
+        std::allocator_traits<Allocator>::destroy(m_alloc, node->value_ptr());
+        dealloc_node(node);
+    }
+
+    void reset_header()
+    {
+        for (int i = 0; i < MaxLevel; ++i)
+        {
+            m_header->next(i).store(0, std::memory_order_relaxed);
+        }
+
+        m_level.store(1, std::memory_order_relaxed);
+        m_size.store(0, std::memory_order_relaxed);
+    }
+
+    // No marked node is linked when there is no concurrent operation.
+    void reset()
+    {
+        auto node = list_node::get_pointer(m_header->next(0).load(std::memory_order_relaxed));
+
+        while (node)
+        {
+            auto next = list_node::get_pointer(node->next(0).load(std::memory_order_relaxed));
+            drop_node(node);
+            node = next;
+        }
+
+        m_epoch.drain([this](epoch_node* p) { drop_node(static_cast<list_node*>(p)); });
+        reset_header();
+    }
+
+    [[no_unique_address]] Compare m_cmp;
+    [[no_unique_address]] Allocator m_alloc;
+    list_node* m_header;
+    alignas(detail::cache_line_size) std::atomic<int> m_level;
+    alignas(detail::cache_line_size) std::atomic<size_type> m_size;
+    mutable epoch_domain m_epoch;
+};
+
+template <typename T, typename Compare = std::less<T>, typename Allocator = std::allocator<T>>
+using concurrent_skip_set = concurrent_skip_list<identity<T>, Compare, Allocator>;
+
+template <typename K, typename V, typename Compare = std::less<K>, typename Allocator = std::allocator<std::pair<const K, V>>>
+using concurrent_skip_map = concurrent_skip_list<select1st<K, V>, Compare, Allocator>;
+
+} // namespace cpp::collections
+
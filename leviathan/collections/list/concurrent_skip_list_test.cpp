@@ -0,0 +1,181 @@
+#include "concurrent_skip_list.hpp"
+#include <catch2/catch_all.hpp>
+
+#include <atomic>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using set_type = cpp::collections::concurrent_skip_set<int>;
+using map_type = cpp::collections::concurrent_skip_map<int, std::string>;
+
+TEST_CASE("concurrent_skip_list basic operations")
+{
+    set_type s;
+
+    CHECK(s.empty());
+    CHECK(s.insert(3));
+    CHECK(s.insert(1));
+    CHECK(s.emplace(2));
+    CHECK(!s.insert(1));
+    CHECK(s.size() == 3);
+
+    CHECK(s.contains(1));
+    CHECK(!s.contains(0));
+    CHECK(s.count(2) == 1);
+
+    std::vector<int> values;
+    s.visit_all([&](int x) { values.push_back(x); });
+    CHECK(values == std::vector{ 1, 2, 3 });
+
+    CHECK(s.erase(2) == 1);
+    CHECK(s.erase(2) == 0);
+    CHECK(!s.contains(2));
+    CHECK(s.size() == 2);
+
+    s.clear();
+    CHECK(s.empty());
+    CHECK(!s.contains(1));
+    CHECK(s.insert(1));
+}
+
+TEST_CASE("concurrent_skip_list map and range")
+{
+    map_type m;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        CHECK(m.emplace(i * 2, std::to_string(i)));
+    }
+
+    std::string value;
+    CHECK(m.visit(10, [&](const auto& x) { value = x.second; }));
+    CHECK(value == "5");
+    CHECK(!m.visit(11, [&](const auto& x) { value = x.second; }));
+
+    std::vector<int> keys;
+    m.visit_range(9, 20, [&](const auto& x) { keys.push_back(x.first); });
+    CHECK(keys == std::vector{ 10, 12, 14, 16, 18 });
+
+    keys.clear();
+    m.visit_range(1000, 2000, [&](const auto& x) { keys.push_back(x.first); });
+    CHECK(keys.empty());
+}
+
+TEST_CASE("concurrent_skip_list multi-thread insert and erase")
+{
+    set_type s;
+
+    constexpr int ThreadCount = 8;
+    constexpr int N = 20000;
+
+    std::atomic<int> inserted = 0;
+    std::atomic<int> erased = 0;
+
+    {
+        std::vector<std::jthread> threads;
+
+        // Each key is inserted and erased by several threads at the same time.
+        for (int t = 0; t < ThreadCount; ++t)
+        {
+            threads.emplace_back([&, t] {
+                for (int i = 0; i < N; ++i)
+                {
+                    const auto key = (i * 7 + t) % (N / 4);
+
+                    if (s.insert(key))
+                    {
+                        inserted.fetch_add(1);
+                    }
+
+                    if (i % 3 == t % 3 && s.erase((key + 1) % (N / 4)))
+                    {
+                        erased.fetch_add(1);
+                    }
+
+                    s.contains(key);
+                }
+            });
+        }
+    }
+
+    CHECK(static_cast<int>(s.size()) == inserted - erased);
+
+    std::vector<int> values;
+    s.visit_all([&](int x) { values.push_back(x); });
+
+    CHECK(values.size() == s.size());
+    CHECK(std::ranges::is_sorted(values));
+    CHECK(std::ranges::adjacent_find(values) == values.end());
+}
+
+TEST_CASE("concurrent_skip_list readers and writers")
+{
+    set_type s;
+
+    for (int i = 0; i < 1000; i += 2)
+    {
+        s.insert(i);
+    }
+
+    std::atomic<bool> stop = false;
+    std::atomic<bool> failed = false;
+
+    {
+        std::vector<std::jthread> threads;
+
+        // Even keys are never erased, so readers should always find them.
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&] {
+                while (!stop)
+                {
+                    int last = -1;
+
+                    s.visit_all([&](int x) {
+                        if (x <= last)
+                        {
+                            failed = true;
+                        }
+                        last = x;
+                    });
+
+                    for (int i = 0; i < 1000; i += 2)
+                    {
+                        if (!s.contains(i))
+                        {
+                            failed = true;
+                        }
+                    }
+                }
+            });
+        }
+
+        std::vector<std::jthread> writers;
+
+        for (int t = 0; t < 4; ++t)
+        {
+            writers.emplace_back([&, t] {
+                for (int round = 0; round < 50; ++round)
+                {
+                    for (int i = 1 + 2 * t; i < 1000; i += 8)
+                    {
+                        s.insert(i);
+                    }
+
+                    for (int i = 1 + 2 * t; i < 1000; i += 8)
+                    {
+                        s.erase(i);
+                    }
+                }
+            });
+        }
+
+        writers.clear();
+        stop = true;
+    }
+
+    CHECK(!failed);
+    CHECK(s.size() == 500);
+}
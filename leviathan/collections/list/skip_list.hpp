@@ -7,6 +7,7 @@
 #include <leviathan/collections/list/skip_node.hpp>
 #include <leviathan/collections/list/skip_list_drawer.hpp>
 
+#include <array>
 #include <span>
 #include <random>
 #include <cstddef>
@@ -17,6 +18,10 @@ namespace cpp::collections
 /**
  * @brief A skiplist implementation.
  * 
+ * Each link records the number of elements it skips(indexable skip list), so the
+ * rank of a position is accumulated while searching. count/count_range do not
+ * visit the elements and erasing a range only updates the boundary links of each level.
+ * 
  * @param KeyOfValue Extractor extract key from value. identity<T> for set and select1st<K, V> for map.
  * @param Compare
  * @param Allocator
@@ -40,13 +45,13 @@ class skip_list : public lookup_interface,
                   public erase_interface, 
                   public node_drawer
 {
-    static_assert(UniqueKey, "Not support multi-key now");
     static_assert(Ratio > 1);
     static_assert(std::is_unsigned_v<typename RandomEngine::result_type>);
 
     static constexpr auto pro = std::lerp(RandomEngine::min(), RandomEngine::max(), 1.0 / Ratio);
 
-    inline static RandomEngine random = RandomEngine(SeedGenerator()());
+    // Each thread has its own engine, so lists used by different threads do not race on it.
+    inline static thread_local RandomEngine random = RandomEngine(SeedGenerator()());
 
     static int get_level()
     {
@@ -145,8 +150,12 @@ public:
     template <typename... Args>
     auto emplace(Args&&... args)
     {
-        if constexpr (detail::emplace_helper<value_type, Args...>::value || 
-                     (sizeof...(Args) == 1 && detail::transparent<Compare>))
+        if constexpr (!UniqueKey)
+        {
+            return insert_multi(create_node((Args&&) args...));
+        }
+        else if constexpr (detail::emplace_helper<value_type, Args...>::value ||
+                          (sizeof...(Args) == 1 && detail::transparent<Compare>))
         {
             return insert_unique((Args&&) args...);
         }
@@ -156,27 +165,82 @@ public:
             return insert_unique(*handle);
         }
     }
-    
+
     size_type erase(const key_type& x)
     {
-        auto old_size = size();
-        erase_node_by_value(x);
-        return old_size - size();
+        position first, last;
+        find_position(first, less_than(x));
+        find_position(last, not_greater_than(x));
+        return erase_range(first, last);
     }
 
     iterator erase(const_iterator pos)
     {
         auto next = std::next(pos).base();
-        erase(*pos);
+        position first, last;
+        find_position_of(first, pos.base().link());
+        last = first;
+
+        for (int i = 0; i < pos.base().level(); ++i)
+        {
+            last.m_prev[i] = pos.base().link();
+            last.m_rank[i] = first.m_rank[0] + 1;
+        }
+
+        erase_range(first, last);
         return next;
     }
 
+    /**
+     * @brief: Erase elements in [first, last).
+     *
+     * Only the boundary pointers of each level are updated, the elements in range
+     * are destroyed without searching.
+    */
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        if (first != last)
+        {
+            position lower, upper;
+            find_position_of(lower, first.base().link());
+            find_position_of(upper, last.base().link());
+            erase_range(lower, upper);
+        }
+
+        return last.base();
+    }
+
     // Observers
     template <typename Self, typename K = key_type>
     self_iter_t<Self> lower_bound(this Self&& self, const key_arg_t<K>& x)
     {
-        auto [it, exist] = as_non_const(self).find_node(x);
-        return exist ? it : std::next(it);
+        return as_non_const(self).find_first(as_non_const(self).less_than(x));
+    }
+
+    template <typename Self, typename K = key_type>
+    self_iter_t<Self> upper_bound(this Self&& self, const key_arg_t<K>& x)
+    {
+        return as_non_const(self).find_first(as_non_const(self).not_greater_than(x));
+    }
+
+    template <typename K = key_type>
+    size_type count(const key_arg_t<K>& x) const
+    {
+        return count_range<K, K>(x, x, true);
+    }
+
+    /**
+     * @brief: Number of elements whose keys are in [lo, hi), or [lo, hi] if closed is true.
+     *
+     * Each link records how many elements it skips, so the ranks of both
+     * bounds are accumulated while searching and no element is visited.
+    */
+    template <typename K1 = key_type, typename K2 = key_type>
+    size_type count_range(const key_arg_t<K1>& lo, const key_arg_t<K2>& hi, bool closed = false) const
+    {
+        const auto first = rank_if(less_than(lo));
+        const auto last = closed ? rank_if(not_greater_than(hi)) : rank_if(less_than(hi));
+        return last > first ? last - first : 0;
     }
 
     skip_list(const Compare& compare, const Allocator& allocator)
@@ -190,9 +254,10 @@ public:
 
     skip_list() : skip_list(Compare(), Allocator()) { }
 
-    ~skip_list() 
+    ~skip_list()
     {
         clear();
+        dealloc_node(m_header);
     }
 
     void clear()
@@ -208,123 +273,212 @@ public:
 
 private:
 
+    // The last node on each level before some position and the ranks of them.
+    struct position
+    {
+        std::array<list_node*, MaxLevel> m_prev;
+        std::array<size_type, MaxLevel> m_rank;
+    };
+
+    const key_type& key_of(const list_node* node) const
+    {
+        return KeyOfValue()(*node->value_ptr());
+    }
+
+    template <typename K>
+    auto less_than(const K& x) const
+    {
+        return [&x, this](const list_node* node) { return m_cmp(key_of(node), x); };
+    }
+
     template <typename K>
-    void erase_node_by_value(const K& val)
+    auto not_greater_than(const K& x) const
+    {
+        return [&x, this](const list_node* node) { return !m_cmp(x, key_of(node)); };
+    }
+
+    // Find the last node on each level which satisfies pred. The nodes which
+    // satisfy pred should be a prefix of list.
+    template <typename Pred>
+    void find_position(position& pos, Pred pred)
     {
-        std::array<iterator, MaxLevel> prev;
-        prev.fill(end());
+        auto cur = header();
+        size_type rank = 0;
 
-        auto [cur, exist] = find_node_with_prev(val, prev);
+        for (int i = m_level - 1; i >= 0; --i)
+        {
+            for (auto next = cur->nexts()[i]; next != header() && pred(next); next = cur->nexts()[i])
+            {
+                rank += cur->widths()[i];
+                cur = next;
+            }
+
+            pos.m_prev[i] = cur;
+            pos.m_rank[i] = rank;
+        }
+    }
 
-        if (!exist)
+    // Find the position before node, node may be header.
+    void find_position_of(position& pos, list_node* node)
+    {
+        if (node == header())
         {
+            find_position(pos, [](const list_node*) { return true; });
             return;
         }
 
-        auto deleted_pos = cur.skip(0);
-        deleted_pos.skip(0).set_prev(cur);
+        find_position(pos, less_than(key_of(node)));
 
-        for (int i = 0; i < deleted_pos.level(); ++i)
+        // Pass the equivalent elements before node.
+        for (auto cur = pos.m_prev[0]->nexts()[0]; cur != node; cur = cur->nexts()[0])
         {
-            prev[i].set_next(i, deleted_pos.skip(i));
+            const auto rank = pos.m_rank[0] + 1;
+
+            for (int i = 0; i < cur->count(); ++i)
+            {
+                pos.m_prev[i] = cur;
+                pos.m_rank[i] = rank;
+            }
         }
+    }
 
-        int new_level;
-        iterator sent = end();
-        iterator head = iterator{ header() };
-        for (new_level = m_level - 1; new_level >= 0 && head.skip(new_level) == sent; --new_level);
-        m_level = new_level + 1;
+    // Number of nodes which satisfy pred.
+    template <typename Pred>
+    size_type rank_if(Pred pred) const
+    {
+        auto cur = header();
+        size_type rank = 0;
+
+        for (int i = m_level - 1; i >= 0; --i)
+        {
+            for (auto next = cur->nexts()[i]; next != header() && pred(next); next = cur->nexts()[i])
+            {
+                rank += cur->widths()[i];
+                cur = next;
+            }
+        }
 
-        drop_node(deleted_pos.link());
-        --m_size;
-        return;
+        return rank;
     }
 
-    // return target node if succeed otherwise prev of target value 
-    template <typename K>
-    std::pair<iterator, bool> find_node(const K& val) 
+    template <typename Pred>
+    iterator find_first(Pred pred)
     {
-        auto cur = iterator(header());
-        auto sent = end();
+        auto cur = header();
 
-        for (int i = m_level; i >= 0; --i)
+        for (int i = m_level - 1; i >= 0; --i)
         {
-            for (; cur.skip(i) != sent && m_cmp(KeyOfValue()(*cur.skip(i)), val); cur.skip_to(i));
-            auto next = cur.skip(i);
-
-            if (next != sent && !m_cmp(val, KeyOfValue()(*next)))
+            for (auto next = cur->nexts()[i]; next != header() && pred(next); next = cur->nexts()[i])
             {
-                return { next, true };
+                cur = next;
             }
         }
-        return { cur, false };
+
+        return iterator(cur->nexts()[0]);
     }
 
     template <typename U>
     std::pair<iterator, bool> insert_unique(U&& val)
     {
-        std::array<iterator, MaxLevel> prev;
-        prev.fill(end());
+        position pos;
+        find_position(pos, less_than(KeyOfValue()(val)));
 
-        auto [cur, exist] = find_node_with_prev(KeyOfValue()(val), prev);
+        auto next = pos.m_prev[0]->nexts()[0];
 
-        if (exist)
+        if (next != header() && !m_cmp(KeyOfValue()(val), key_of(next)))
         {
-            return { cur, false };
+            return { iterator(next), false };
         }
 
-        // insert a new node
         auto new_node = create_node((U&&) val);
-        iterator worker { new_node };
-        iterator head { header() };
-        
-        new_node->reset(cur.link(), header());
-        cur.skip(0).set_prev(new_node);
-        
-        // update header
+        link_node(new_node, pos);
+        return { iterator(new_node), true };
+    }
+
+    // The new element is placed after the equivalent elements.
+    iterator insert_multi(list_node* new_node)
+    {
+        position pos;
+        find_position(pos, not_greater_than(key_of(new_node)));
+        link_node(new_node, pos);
+        return iterator(new_node);
+    }
+
+    void link_node(list_node* new_node, position& pos)
+    {
         const int level = new_node->count();
 
-        for (int i = 0; i < level; ++i)
+        // The new levels of header link to end.
+        for (int i = m_level; i < level; ++i)
         {
-            if (i >= m_level)
-            {
-                head.set_next(i, worker);
-            }
-            else
-            {
-                worker.set_next(i, prev[i].skip(i));
-                prev[i].set_next(i, worker);
-            }
+            pos.m_prev[i] = header();
+            pos.m_rank[i] = 0;
+            header()->nexts()[i] = header();
+            header()->widths()[i] = m_size + 1;
         }
 
         m_level = std::max(m_level, level);
+
+        const auto rank = pos.m_rank[0] + 1;
+
+        for (int i = 0; i < level; ++i)
+        {
+            auto prev = pos.m_prev[i];
+            const auto distance = rank - pos.m_rank[i];
+
+            new_node->nexts()[i] = prev->nexts()[i];
+            new_node->widths()[i] = prev->widths()[i] - distance + 1;
+            prev->nexts()[i] = new_node;
+            prev->widths()[i] = distance;
+        }
+
+        // The higher links skip one more element.
+        for (int i = level; i < m_level; ++i)
+        {
+            ++pos.m_prev[i]->widths()[i];
+        }
+
+        new_node->pointers()[0] = pos.m_prev[0];
+        new_node->nexts()[0]->pointers()[0] = new_node;
         ++m_size;
-        return { worker, true };
     }
 
-    // return target node if succeed otherwise prev position of target node for inserting
-    template <typename K>
-    std::pair<iterator, bool> find_node_with_prev(const K& val, std::span<iterator, MaxLevel> prev) 
+    // Unlink the nodes between first and last and destroy them, first and last
+    // are the positions before the first erased node and the first reserved node.
+    size_type erase_range(const position& first, const position& last)
     {
-        iterator cur = header();
-        iterator sent = end();
-        bool exits = false;
+        const auto count = last.m_rank[0] - first.m_rank[0];
 
-        for (int i = m_level - 1; i >= 0; --i)
+        if (count == 0)
         {
-            for (; cur.skip(i) != sent && m_cmp(KeyOfValue()(*cur.skip(i)), val); cur.skip_to(i));
-            auto next = cur.skip(i);
+            return 0;
+        }
 
-            // cur is prev of position, so val <= *next
-            if (next != end() && !m_cmp(val, KeyOfValue()(*next)))
-            {
-                exits = true; // find it and do nothing
-            }
-            prev[i] = cur;
+        auto node = first.m_prev[0]->nexts()[0];
+        auto sent = last.m_prev[0]->nexts()[0];
+
+        for (int i = 0; i < m_level; ++i)
+        {
+            // Rank of the first node on level i after the range, before erasing.
+            const auto next_rank = last.m_rank[i] + last.m_prev[i]->widths()[i];
+            auto prev = first.m_prev[i];
+
+            prev->nexts()[i] = last.m_prev[i]->nexts()[i];
+            prev->widths()[i] = next_rank - count - first.m_rank[i];
+        }
+
+        sent->pointers()[0] = first.m_prev[0];
+
+        while (node != sent)
+        {
+            drop_node(std::exchange(node, node->nexts()[0]));
         }
 
-        // cur is prev of node
-        return { cur, exits };
+        m_size -= count;
+
+        for (; m_level > 1 && header()->nexts()[m_level - 1] == header(); --m_level);
+
+        return count;
     }
 
     template <typename... Args>
@@ -348,7 +502,7 @@ private:
 
     [[nodiscard]] list_node* alloc_node(int count)
     {
-        auto size = node_layout_type(1, 1, 1 + count).template alloc_size();
+        auto size = list_node::layout_of(count).alloc_size();
         auto node = static_cast<list_node*>(
             static_cast<void*>(node_allocator::allocate(m_alloc, size))
         );
@@ -381,6 +535,7 @@ private:
     {
         assert(header()->count() == MaxLevel);
         header()->reset(m_header, m_header);
+        std::ranges::fill(header()->widths(), 1);
     }
 
     void reset()
@@ -410,6 +565,9 @@ private:
 template <typename T, typename Compare = std::less<T>, typename Allocator = std::allocator<T>>
 using skip_set = skip_list<identity<T>, Compare, Allocator, true>;
 
+template <typename T, typename Compare = std::less<T>, typename Allocator = std::allocator<T>>
+using skip_multiset = skip_list<identity<T>, Compare, Allocator, false>;
+
 
 } // namespace cpp::collections
 
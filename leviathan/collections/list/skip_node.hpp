@@ -16,6 +16,7 @@ struct skip_node
     int node_count;       // Size of next
     skip_node* m_prev;    // Double recycle link list
     skip_node* m_next[];  // Flexible array member
+    size_t m_width[];     // Number of elements skipped by m_next[i]
 };
 
 */
@@ -23,13 +24,18 @@ template <typename T>
 struct skip_node
 {
     // Flexible array is forbidden in ISO C++. So we use layout to simulate it.
-    using node_layout_type = cpp::layout<T, int, skip_node*>;
+    using node_layout_type = cpp::layout<T, int, skip_node*, size_t>;
 
-    static constexpr auto node_layout = node_layout_type(1, 1, 1);
+    static constexpr auto node_layout = node_layout_type(1, 1, 1, 0);
+
+    static constexpr auto layout_of(int count)
+    {
+        return node_layout_type(1, 1, 1 + count, count);
+    }
 
     constexpr auto self_layout() const
     {
-        return node_layout_type(1, 1, 1 + count());
+        return layout_of(count());
     }
 
     template <typename Self>
@@ -63,6 +69,14 @@ struct skip_node
         return self.pointers().subspan(1);
     }
 
+    // The width of m_next[i] is the difference between the ranks of node and m_next[i],
+    // the rank of header is 0 and the rank of end is size() + 1.
+    template <typename Self>
+    constexpr auto widths(this Self& self)
+    {
+        return self.self_layout().template slice<3>(self.self_ptr());
+    }
+
     constexpr int count() const
     {
         return this->count_ref();
@@ -1,10 +1,16 @@
 #include <iostream>
 #include "skip_list.hpp"
+#include <leviathan/allocators/node_pool_allocator.hpp>
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <random>
 #include <catch2/catch_all.hpp>
 
 using namespace cpp::collections;
 
-using SkipList = skip_set<identity<int>, std::ranges::less, std::allocator<int>, true>;
+using SkipList = skip_list<identity<int>, std::ranges::less, std::allocator<int>, true>;
+using MultiSkipList = skip_list<identity<int>, std::ranges::less, std::allocator<int>, false>;
 
 TEST_CASE("observer", "[empty][size]")
 {
@@ -84,3 +90,134 @@ TEST_CASE("remove elements", "[iterator][remove][clear][find][size][empty]")
     h.erase(h.find(3));
     REQUIRE(h.empty());
 }
+
+TEST_CASE("node pool allocator")
+{
+    // The nodes with different levels are allocated from different size classes.
+    skip_list<identity<int>, std::ranges::less, cpp::alloc::node_pool_allocator<int>, true> h;
+    std::set<int> s;
+    std::mt19937 random(42);
+
+    for (auto i = 0; i < 10000; ++i)
+    {
+        auto x = static_cast<int>(random() % 5000);
+
+        if (random() % 2)
+        {
+            h.insert(x);
+            s.insert(x);
+        }
+        else
+        {
+            REQUIRE(h.erase(x) == s.erase(x));
+        }
+    }
+
+    REQUIRE(h.size() == s.size());
+    REQUIRE(std::ranges::equal(h, s));
+}
+
+TEST_CASE("multi-key")
+{
+    MultiSkipList h;
+    std::multiset<int> s;
+    std::mt19937 random(42);
+
+    for (auto i = 0; i < 10000; ++i)
+    {
+        auto x = static_cast<int>(random() % 500);
+
+        if (random() % 3)
+        {
+            h.insert(x);
+            s.insert(x);
+        }
+        else
+        {
+            REQUIRE(h.erase(x) == s.erase(x));
+        }
+    }
+
+    REQUIRE(h.size() == s.size());
+    REQUIRE(std::ranges::equal(h, s));
+
+    for (auto x = -1; x <= 500; ++x)
+    {
+        REQUIRE(h.count(x) == s.count(x));
+        REQUIRE(std::distance(h.begin(), h.lower_bound(x)) == std::distance(s.begin(), s.lower_bound(x)));
+        REQUIRE(std::distance(h.begin(), h.upper_bound(x)) == std::distance(s.begin(), s.upper_bound(x)));
+    }
+
+    // Erase a single element among the equivalent elements.
+    auto it = std::next(h.lower_bound(100));
+    REQUIRE(*it == 100);
+    h.erase(it);
+    s.erase(std::next(s.lower_bound(100)));
+    REQUIRE(std::ranges::equal(h, s));
+}
+
+TEST_CASE("erase range and count range")
+{
+    MultiSkipList h;
+    std::multiset<int> s;
+    std::mt19937 random(7);
+
+    for (auto i = 0; i < 5000; ++i)
+    {
+        auto x = static_cast<int>(random() % 1000);
+        h.insert(x);
+        s.insert(x);
+    }
+
+    for (auto i = 0; i < 1000; ++i)
+    {
+        auto lo = static_cast<int>(random() % 1100) - 50;
+        auto hi = static_cast<int>(random() % 1100) - 50;
+        auto expected = lo < hi ? std::distance(s.lower_bound(lo), s.lower_bound(hi)) : 0;
+        REQUIRE(h.count_range(lo, hi) == static_cast<size_t>(expected));
+    }
+
+    // Sliding window: expire the oldest elements in batches.
+    for (auto bound = 0; bound <= 1000; bound += 37)
+    {
+        auto it = h.erase(h.begin(), h.lower_bound(bound));
+        s.erase(s.begin(), s.lower_bound(bound));
+
+        REQUIRE(it == h.begin());
+        REQUIRE(h.size() == s.size());
+        REQUIRE(std::ranges::equal(h, s));
+        REQUIRE(h.count_range(bound, 1000) == s.size());
+    }
+
+    // Erase from the middle of equivalent elements.
+    for (auto i = 0; i < 2000; ++i)
+    {
+        h.insert(i % 50);
+        s.insert(i % 50);
+    }
+
+    for (auto i = 0; i < 20 && !s.empty(); ++i)
+    {
+        auto first = static_cast<std::ptrdiff_t>(random() % s.size());
+        auto last = first + static_cast<std::ptrdiff_t>(random() % (s.size() - first + 1));
+
+        auto it = h.erase(std::next(h.begin(), first), std::next(h.begin(), last));
+        s.erase(std::next(s.begin(), first), std::next(s.begin(), last));
+
+        REQUIRE(std::distance(h.begin(), it) == first);
+        REQUIRE(h.size() == s.size());
+        REQUIRE(std::ranges::equal(h, s));
+
+        for (auto x = 0; x < 50; x += 7)
+        {
+            REQUIRE(h.count_range(x, x + 10) == static_cast<size_t>(std::distance(s.lower_bound(x), s.lower_bound(x + 10))));
+        }
+    }
+
+    h.erase(h.begin(), h.end());
+    REQUIRE(h.empty());
+    REQUIRE(h.count_range(0, 1000) == 0);
+
+    h.insert(1);
+    REQUIRE(h.count(1) == 1);
+}
@@ -0,0 +1,234 @@
+/**
+ * A byte ring buffer whose pages are mapped twice back-to-back.
+ *
+ *   virtual memory: | page 0 ... page n-1 | page 0 ... page n-1 |
+ *                   ^ base                ^ base + capacity
+ *
+ * Both halves map the same memory, so the byte at base + i + capacity is the
+ * byte at base + i. A window starting anywhere in the first half can extend
+ * beyond the end of it, and the readable bytes and the writable space are
+ * always a single contiguous range. Unlike ring_buffer, there is no wraparound
+ * split and the readable bytes can be passed to parsers as a std::string_view
+ * without copying.
+ *
+ * The capacity is rounded up to a multiple of the page size. The memory is
+ * created by memfd_create and mapped by mmap, so it is only available on Linux.
+*/
+#pragma once
+
+#if !defined(__linux__)
+#error "mirrored_ring_buffer requires memfd_create and mmap."
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace cpp::collections
+{
+
+class mirrored_ring_buffer
+{
+public:
+
+    using value_type = char;
+    using size_type = std::size_t;
+
+    /**
+     * @brief: Create a buffer which can hold at least capacity bytes.
+     *
+     * @exception: std::system_error if the memory cannot be mapped.
+    */
+    explicit mirrored_ring_buffer(size_type capacity)
+    {
+        const auto page = static_cast<size_type>(::sysconf(_SC_PAGESIZE));
+        m_capacity = std::max<size_type>((capacity + page - 1) / page, 1) * page;
+        map_memory();
+    }
+
+    mirrored_ring_buffer(const mirrored_ring_buffer&) = delete;
+    mirrored_ring_buffer& operator=(const mirrored_ring_buffer&) = delete;
+
+    mirrored_ring_buffer(mirrored_ring_buffer&& other) noexcept
+        : m_base(std::exchange(other.m_base, nullptr)),
+          m_capacity(std::exchange(other.m_capacity, 0)),
+          m_read(std::exchange(other.m_read, 0)),
+          m_size(std::exchange(other.m_size, 0)) { }
+
+    mirrored_ring_buffer& operator=(mirrored_ring_buffer&& other) noexcept
+    {
+        if (this != std::addressof(other))
+        {
+            unmap_memory();
+            m_base = std::exchange(other.m_base, nullptr);
+            m_capacity = std::exchange(other.m_capacity, 0);
+            m_read = std::exchange(other.m_read, 0);
+            m_size = std::exchange(other.m_size, 0);
+        }
+        return *this;
+    }
+
+    ~mirrored_ring_buffer()
+    {
+        unmap_memory();
+    }
+
+    void swap(mirrored_ring_buffer& other) noexcept
+    {
+        std::swap(m_base, other.m_base);
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_read, other.m_read);
+        std::swap(m_size, other.m_size);
+    }
+
+    size_type capacity() const
+    { return m_capacity; }
+
+    size_type size() const
+    { return m_size; }
+
+    bool empty() const
+    { return m_size == 0; }
+
+    bool full() const
+    { return m_size == m_capacity; }
+
+    void clear()
+    { m_read = m_size = 0; }
+
+    // Readable bytes.
+    const char* data() const
+    { return m_base + m_read; }
+
+    char* data()
+    { return m_base + m_read; }
+
+    std::string_view view() const
+    { return { data(), m_size }; }
+
+    std::span<char> readable()
+    { return { data(), m_size }; }
+
+    // Free space after the readable bytes, call commit after writing to it.
+    std::span<char> writable()
+    { return { m_base + m_read + m_size, m_capacity - m_size }; }
+
+    // Make n bytes of writable space readable.
+    void commit(size_type n)
+    {
+        assert(n <= m_capacity - m_size);
+        m_size += n;
+    }
+
+    // Discard the first n readable bytes.
+    void consume(size_type n)
+    {
+        assert(n <= m_size);
+        m_read += n;
+        m_size -= n;
+
+        if (m_read >= m_capacity)
+        {
+            m_read -= m_capacity;
+        }
+    }
+
+    /**
+     * @brief: Append bytes as many as possible.
+     *
+     * @return: Number of bytes written.
+    */
+    size_type write(std::string_view bytes)
+    {
+        auto space = writable();
+        const auto n = std::min(bytes.size(), space.size());
+        std::memcpy(space.data(), bytes.data(), n);
+        commit(n);
+        return n;
+    }
+
+    /**
+     * @brief: Copy at most n readable bytes to dest and consume them.
+     *
+     * @return: Number of bytes read.
+    */
+    size_type read(char* dest, size_type n)
+    {
+        n = std::min(n, m_size);
+        std::memcpy(dest, data(), n);
+        consume(n);
+        return n;
+    }
+
+private:
+
+    // Reserve the address space of both halves first, then map the memory
+    // file into them.
+    void map_memory()
+    {
+        const int fd = ::memfd_create("mirrored_ring_buffer", MFD_CLOEXEC);
+
+        if (fd == -1)
+        {
+            throw std::system_error(errno, std::system_category(), "memfd_create");
+        }
+
+        auto fail = [&](const char* what) {
+            const int error = errno;
+            ::close(fd);
+            unmap_memory();
+            throw std::system_error(error, std::system_category(), what);
+        };
+
+        if (::ftruncate(fd, static_cast<off_t>(m_capacity)) == -1)
+        {
+            fail("ftruncate");
+        }
+
+        auto base = ::mmap(nullptr, m_capacity * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (base == MAP_FAILED)
+        {
+            fail("mmap");
+        }
+
+        m_base = static_cast<char*>(base);
+
+        for (auto half : { m_base, m_base + m_capacity })
+        {
+            if (::mmap(half, m_capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+            {
+                fail("mmap");
+            }
+        }
+
+        // The mappings keep the memory alive.
+        ::close(fd);
+    }
+
+    void unmap_memory()
+    {
+        if (m_base)
+        {
+            ::munmap(m_base, m_capacity * 2);
+            m_base = nullptr;
+        }
+    }
+
+    char* m_base = nullptr;
+    size_type m_capacity = 0;
+    size_type m_read = 0;
+    size_type m_size = 0;
+};
+
+} // namespace cpp::collections
+
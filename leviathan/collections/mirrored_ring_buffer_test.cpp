@@ -0,0 +1,110 @@
+#include "mirrored_ring_buffer.hpp"
+#include <catch2/catch_all.hpp>
+
+#include <string>
+#include <string_view>
+
+using namespace cpp::collections;
+
+TEST_CASE("mirrored ring buffer capacity")
+{
+    mirrored_ring_buffer buffer(1);
+
+    const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+
+    CHECK(buffer.capacity() == page);
+    CHECK(buffer.empty());
+    CHECK(buffer.writable().size() == page);
+
+    mirrored_ring_buffer buffer2(page + 1);
+    CHECK(buffer2.capacity() == page * 2);
+}
+
+TEST_CASE("mirrored ring buffer wraparound is contiguous")
+{
+    mirrored_ring_buffer buffer(1);
+    const auto capacity = buffer.capacity();
+
+    // The read position is 0.
+    const char* base = buffer.data();
+
+    // Move the read position close to the end of the first half.
+    std::string padding(capacity - 3, '-');
+    CHECK(buffer.write(padding) == padding.size());
+    buffer.consume(padding.size());
+    CHECK(buffer.empty());
+
+    // The bytes cross the end of the first half but are still a single view.
+    CHECK(buffer.write("hello world") == 11);
+    CHECK(buffer.view() == "hello world");
+    CHECK(buffer.readable().size() == 11);
+    CHECK(buffer.writable().size() == capacity - 11);
+
+    char out[6] = { };
+    CHECK(buffer.read(out, 5) == 5);
+    CHECK(std::string_view(out, 5) == "hello");
+    CHECK(buffer.view() == " world");
+
+    // The read position has been moved back to the first half.
+    CHECK(buffer.data() < base + capacity);
+    CHECK(buffer.data() == base + 2);
+}
+
+TEST_CASE("mirrored ring buffer commit and consume")
+{
+    mirrored_ring_buffer buffer(1);
+    const auto capacity = buffer.capacity();
+
+    for (std::size_t round = 0; round < 10; ++round)
+    {
+        auto space = buffer.writable();
+        const auto n = space.size() / 3 + 1;
+
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            space[i] = static_cast<char>('a' + (round + i) % 26);
+        }
+
+        buffer.commit(n);
+
+        auto bytes = buffer.view();
+        CHECK(bytes.size() == n);
+        CHECK(bytes.front() == static_cast<char>('a' + round % 26));
+        CHECK(bytes.back() == static_cast<char>('a' + (round + n - 1) % 26));
+
+        buffer.consume(n);
+    }
+
+    CHECK(buffer.empty());
+
+    // Fill it up.
+    std::string bytes(capacity + 10, 'x');
+    CHECK(buffer.write(bytes) == capacity);
+    CHECK(buffer.full());
+    CHECK(buffer.write("y") == 0);
+    CHECK(buffer.view() == std::string_view(bytes).substr(0, capacity));
+
+    buffer.clear();
+    CHECK(buffer.empty());
+    CHECK(buffer.write("abc") == 3);
+    CHECK(buffer.view() == "abc");
+}
+
+TEST_CASE("mirrored ring buffer move")
+{
+    mirrored_ring_buffer buffer(1);
+    buffer.write("abc");
+
+    mirrored_ring_buffer buffer2 = std::move(buffer);
+    CHECK(buffer2.view() == "abc");
+
+    mirrored_ring_buffer buffer3(1);
+    buffer3.write("de");
+    buffer3 = std::move(buffer2);
+    CHECK(buffer3.view() == "abc");
+
+    mirrored_ring_buffer buffer4(1);
+    buffer4.swap(buffer3);
+    CHECK(buffer4.view() == "abc");
+    CHECK(buffer3.empty());
+}
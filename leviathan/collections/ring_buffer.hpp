@@ -13,6 +13,8 @@
 #include <memory>
 #include <bit>
 #include <compare>
+#include <span>
+#include <utility>
 
 namespace cpp::collections
 {
@@ -54,7 +56,7 @@ private:
 
         offset_helper& operator++()
         {
-            m_index = (m_index + 1) % m_mask; 
+            m_index = (m_index + 1) & m_mask; 
             return *this;
         }
 
@@ -69,7 +71,8 @@ private:
         using iterator_category = std::random_access_iterator_tag;
         using difference_type = std::ptrdiff_t;
 
-        // For simplify, we just reuse index and operator[] instead of pointer.
+        // The iterator keeps the logical index, so it is not invalidated when
+        // the read position is moved. The slot is located by masking.
         ring_buffer* m_buf = nullptr;
 
         // We use size_t since the idx is started from 0. However, some methods
@@ -84,7 +87,7 @@ private:
         ring_buffer_iterator(ring_buffer* buf, size_t idx) : m_buf(buf), m_idx(idx) { }
 
         reference operator*() const
-        { return m_buf->operator[](m_idx); }
+        { return m_buf->m_impl.at(m_idx); }
 
         auto operator->() const
         { return &(**this); }
@@ -150,10 +153,12 @@ private:
         reference operator[](difference_type n) const
         {
             assert(n >= 0);
-            return m_buf->operator[](m_idx + n);
+            return m_buf->m_impl.at(m_idx + n);
         }
     };
 
+    // The capacity is always zero or a power of two, so the positions are
+    // wrapped by masking instead of modulo.
     struct impl 
     {
         T* m_start = nullptr;
@@ -162,6 +167,13 @@ private:
         size_type m_size = 0;
         size_type m_capacity = 0;
 
+        size_type mask() const
+        { return m_capacity - 1; }
+
+        // The idx-th element from read.
+        T& at(size_type idx) const
+        { return m_start[(m_read + idx) & mask()]; }
+
         T* read_ptr() 
         { return m_start + m_read; }
 
@@ -175,37 +187,21 @@ private:
         { return m_start + m_write; }
 
         void forward_read_ptr()
-        { m_read = (m_read + 1) % m_capacity; }
+        { m_read = (m_read + 1) & mask(); }
 
         void backward_read_ptr()
-        {
-            if (m_read == 0)
-            {
-                m_read = m_capacity - 1;
-            }
-            else
-            {
-                m_read--;
-            }
-        }
+        { m_read = (m_read - 1) & mask(); }
 
         void forward_write_ptr()
-        { m_write = (m_write + 1) % m_capacity; }
+        { m_write = (m_write + 1) & mask(); }
 
         void backward_write_ptr()
-        {
-            if (m_write == 0)
-            {
-                m_write = m_capacity - 1;
-            }
-            else
-            {
-                m_write--;
-            }
-        }
+        { m_write = (m_write - 1) & mask(); }
 
+        // The capacity is rounded up to a power of two.
         void initialize(Allocator& alloc, size_t capacity)
         {
+            capacity = capacity ? std::bit_ceil(capacity) : 0;
             m_start = alloc_traits::allocate(alloc, capacity);
             m_capacity = capacity;
             m_size = m_read = m_write = 0;
@@ -213,7 +209,7 @@ private:
 
         void clear(Allocator& alloc)
         {
-            offset_helper oh { .m_mask = m_capacity, .m_index = m_read };
+            offset_helper oh { .m_mask = mask(), .m_index = m_read };
 
             for (size_type i = 0; i < m_size; ++i, ++oh)
             {
@@ -234,35 +230,31 @@ private:
         bool is_contiguous() const
         { return m_read + m_size <= m_capacity; }
 
+        // The elements are in [read, read + first) and [start, start + second).
+        std::pair<size_type, size_type> segments() const
+        {
+            auto first = std::min(m_size, m_capacity - m_read);
+            return { first, m_size - first };
+        }
+
         bool operator==(const impl&) const = default;
     };
 
     template <typename Action, typename Impl>
     static void carry_elements(allocator_type& alloc, Impl&& src, impl& dst, Action action) 
     {
-        // There are two situations:
-        // 1. The write is the right side.
-        // 2. The read is the right side.
-        if (src.m_write > src.m_read)
-        {
-            // The elements are in [read, write).
-            for (size_type i = src.m_read; i != src.m_write && dst.m_write != dst.m_capacity; ++i, ++dst.m_write, ++dst.m_size)
-            {
-                alloc_traits::construct(alloc, dst.m_start + dst.m_write, action(*(src.m_start + i)));
-            }
-        }
-        else
-        {
-            // The elements are in [read, finish) and [start, write).
-            for (size_type i = src.m_read; i != src.m_capacity && dst.m_write != dst.m_capacity; ++i, dst.m_write++, ++dst.m_size)
-            {
-                alloc_traits::construct(alloc, dst.m_start + dst.m_write, action(*(src.m_start + i)));
-            }
-            for (size_type i = 0; i != src.m_write && dst.m_write != dst.m_capacity; ++i, dst.m_write++, ++dst.m_size)
+        // The elements are in [read, read + first) and [start, start + second).
+        auto [first, second] = src.segments();
+        auto copy = [&](T* ptr, size_type n) {
+            for (size_type i = 0; i != n && dst.m_write != dst.m_capacity; ++i, ++dst.m_write, ++dst.m_size)
             {
-                alloc_traits::construct(alloc, dst.m_start + dst.m_write, action(*(src.m_start + i)));
+                alloc_traits::construct(alloc, dst.m_start + dst.m_write, action(ptr[i]));
             }
-        }
+        };
+
+        copy(src.m_start + src.m_read, first);
+        copy(src.m_start, second);
+        dst.m_write &= dst.mask();
     }
 
     [[no_unique_address]] Allocator m_alloc;
@@ -477,7 +469,12 @@ public:
     { return begin(); }
 
     void reserve(size_type capacity)
-    { expand_capacity_unchecked(capacity); }
+    {
+        if (capacity > this->capacity())
+        {
+            expand_capacity_unchecked(capacity);
+        }
+    }
 
     size_type capacity() const 
     { return m_impl.m_capacity; }
@@ -560,20 +557,17 @@ public:
     { m_impl.clear(m_alloc); }
 
     void shrink_to_fit()
-    { expand_capacity_unchecked(size()); }
+    {
+        if (std::bit_ceil(size()) < capacity())
+        {
+            expand_capacity_unchecked(size());
+        }
+    }
 
     T& operator[](size_type idx)
     { 
         assert(idx < size());
-        if (m_impl.m_write > m_impl.m_read)
-        {
-            return *(m_impl.read_ptr() + idx);
-        }
-        else
-        {
-            auto offset = m_impl.m_read + idx;
-            return offset >= capacity() ? m_impl.m_start[offset % capacity()] : *(m_impl.read_ptr() + idx);
-        }
+        return m_impl.at(idx);
     }
 
     const T& operator[](size_type idx) const    
@@ -582,23 +576,36 @@ public:
     bool is_contiguous() const
     { return m_impl.is_contiguous(); }
 
+    /**
+     * @brief: Return the elements as two contiguous segments in order, the
+     *  second one is empty if the buffer is contiguous.
+     * 
+     * The segments can be passed to bulk copy or vectorized algorithms directly.
+    */
+    std::pair<std::span<T>, std::span<T>> as_spans()
+    {
+        auto [first, second] = m_impl.segments();
+        return { std::span<T>(m_impl.read_ptr(), first), std::span<T>(m_impl.m_start, second) };
+    }
+
+    std::pair<std::span<const T>, std::span<const T>> as_spans() const
+    {
+        auto [first, second] = const_cast<ring_buffer&>(*this).as_spans();
+        return { first, second };
+    }
+
     void resize(size_type count)
     {
-        auto old = size();
-        
-        if (count == old)
+        while (size() > count)
         {
-            return;
+            pop_back();
         }
 
-        expand_capacity_unchecked(count);
-        
-        if (count > old)
+        reserve(count);
+
+        for (size_type i = size(); i != count; ++i)
         {
-            for (size_type i = old; i != count; ++i)
-            {
-                emplace_back_unchecked();
-            }
+            emplace_back_unchecked();
         }
     }
 
@@ -8,6 +8,7 @@
 #include <list>
 #include <random>
 #include <algorithm>
+#include <ranges>
 
 #include "ring_buffer.hpp"
 // #include <catch2/catch_all.hpp>
@@ -349,3 +350,52 @@ TEST_CASE("erase")
     }
 }
 
+TEST_CASE("as spans")
+{
+    SECTION("contigious")
+    {
+        auto rb = MakeRingBuffer(true);
+        auto [first, second] = rb.as_spans();
+        REQUIRE(std::ranges::equal(first, std::vector{ 0, 1, 2, 3 }));
+        REQUIRE(second.empty());
+    }
+
+    SECTION("not contigious")
+    {
+        // [4, 5, 2, 3]
+        const auto rb = MakeRingBuffer(false);
+        auto [first, second] = rb.as_spans();
+        REQUIRE(std::ranges::equal(first, std::vector{ 2, 3 }));
+        REQUIRE(std::ranges::equal(second, std::vector{ 4, 5 }));
+    }
+}
+
+TEST_CASE("power of two capacity")
+{
+    cpp::collections::ring_buffer<int> rb;
+
+    rb.reserve(5);
+    REQUIRE(rb.capacity() == 8);
+
+    for (int i = 0; i < 20; ++i)
+    {
+        rb.emplace_back(i);
+        rb.emplace_front(-i);
+        rb.pop_back();
+    }
+
+    REQUIRE(rb.size() == 20);
+    REQUIRE(std::has_single_bit(rb.capacity()));
+    REQUIRE(rb.front() == -19);
+    REQUIRE(rb.back() == 0);
+    REQUIRE(std::ranges::equal(rb, std::views::iota(-19, 1)));
+
+    rb.resize(3);
+    REQUIRE(rb.size() == 3);
+    REQUIRE(rb[0] == -19);
+    REQUIRE(rb[2] == -17);
+
+    rb.shrink_to_fit();
+    REQUIRE(rb.capacity() == 4);
+    REQUIRE(rb[1] == -18);
+}
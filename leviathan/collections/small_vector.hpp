@@ -0,0 +1,711 @@
+#pragma once
+
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <assert.h>
+
+#include "common.hpp"
+
+namespace cpp::collections
+{
+
+/**
+ * @brief A vector which stores up to N elements inside the object and spills
+ *  to memory from Allocator when it grows beyond that.
+ *
+ *  Most of vectors in a request are small, keeping the elements inline saves
+ *  an allocation for each of them. Unlike static_vector, the capacity is not
+ *  limited, it behaves like std::vector once the elements are moved to heap.
+ *
+ *  Trivially relocatable elements are relocated by std::memcpy/std::memmove when
+ *  the storage grows and when elements are inserted or erased.
+ *  See is_trivially_relocatable.
+ *
+ *  Notice that moving or swapping a small_vector whose elements are inline will
+ *  move the elements one by one, so iterators and references are invalidated.
+ *
+ * @param T The type of element that will be stored.
+ * @param N The number of elements can be stored without allocation.
+ * @param Allocator Allocator for elements out of the inline storage.
+*/
+template <typename T, std::size_t N, typename Allocator = std::allocator<T>>
+class small_vector
+{
+    static_assert(N > 0, "Use std::vector instead.");
+    static_assert(std::is_same_v<T, typename std::allocator_traits<Allocator>::value_type>);
+
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+    // Elements can be moved to another address by copying their bytes.
+    static constexpr bool relocate_by_memcpy = detail::relocate_by_memcpy<T, Allocator>;
+
+public:
+
+    using value_type = T;
+    using allocator_type = Allocator;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator = pointer;
+    using const_iterator = const_pointer;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    small_vector() noexcept(std::is_nothrow_default_constructible_v<allocator_type>)
+        : m_start(inline_storage()) { }
+
+    explicit small_vector(const allocator_type& alloc) noexcept
+        : m_start(inline_storage()), m_alloc(alloc) { }
+
+    explicit small_vector(size_type n, const allocator_type& alloc = allocator_type())
+        : small_vector(alloc)
+    {
+        resize(n);
+    }
+
+    small_vector(size_type n, const value_type& value, const allocator_type& alloc = allocator_type())
+        : small_vector(alloc)
+    {
+        assign(n, value);
+    }
+
+    template <std::input_iterator InputIterator>
+    small_vector(InputIterator first, InputIterator last, const allocator_type& alloc = allocator_type())
+        : small_vector(alloc)
+    {
+        assign(first, last);
+    }
+
+    small_vector(std::initializer_list<value_type> il, const allocator_type& alloc = allocator_type())
+        : small_vector(il.begin(), il.end(), alloc) { }
+
+    small_vector(const small_vector& other)
+        : small_vector(other.begin(), other.end(), alloc_traits::select_on_container_copy_construction(other.m_alloc)) { }
+
+    small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<value_type>)
+        : m_start(inline_storage()), m_alloc(std::move(other.m_alloc))
+    {
+        if (other.is_inline())
+        {
+            relocate_range(other.m_start, other.m_start + other.m_size, m_start);
+            m_size = std::exchange(other.m_size, 0);
+        }
+        else
+        {
+            steal(other);
+        }
+    }
+
+    small_vector& operator=(const small_vector& other)
+    {
+        if (this != std::addressof(other))
+        {
+            if constexpr (alloc_traits::propagate_on_container_copy_assignment::value)
+            {
+                if (m_alloc != other.m_alloc)
+                {
+                    // The memory must be released by the allocator that allocated it.
+                    clear();
+                    release_storage();
+                }
+                m_alloc = other.m_alloc;
+            }
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    small_vector& operator=(small_vector&& other)
+    noexcept(std::is_nothrow_move_constructible_v<value_type> &&
+        (alloc_traits::propagate_on_container_move_assignment::value || alloc_traits::is_always_equal::value))
+    {
+        if (this == std::addressof(other))
+        {
+            return *this;
+        }
+
+        clear();
+
+        constexpr bool propagate = alloc_traits::propagate_on_container_move_assignment::value;
+
+        if (!other.is_inline() && (propagate || m_alloc == other.m_alloc))
+        {
+            release_storage();
+
+            if constexpr (propagate)
+            {
+                m_alloc = std::move(other.m_alloc);
+            }
+
+            steal(other);
+        }
+        else
+        {
+            // The elements cannot be taken over, move them one by one.
+            reserve(other.m_size);
+            relocate_range(other.m_start, other.m_start + other.m_size, m_start);
+            m_size = std::exchange(other.m_size, 0);
+        }
+
+        return *this;
+    }
+
+    small_vector& operator=(std::initializer_list<value_type> il)
+    {
+        assign(il.begin(), il.end());
+        return *this;
+    }
+
+    ~small_vector()
+    {
+        clear();
+        release_storage();
+    }
+
+    template <std::input_iterator InputIterator>
+    void assign(InputIterator first, InputIterator last)
+    {
+        clear();
+
+        if constexpr (std::forward_iterator<InputIterator>)
+        {
+            reserve(static_cast<size_type>(std::distance(first, last)));
+        }
+
+        for (; first != last; ++first)
+        {
+            emplace_back(*first);
+        }
+    }
+
+    void assign(size_type n, const value_type& value)
+    {
+        if (n > capacity())
+        {
+            // The value may alias one of the elements.
+            small_vector(n, value, m_alloc).swap(*this);
+            return;
+        }
+
+        std::fill_n(m_start, std::min(n, m_size), value);
+
+        if (n > m_size)
+        {
+            std::uninitialized_fill_n(m_start + m_size, n - m_size, value);
+            m_size = n;
+        }
+        else
+        {
+            erase(begin() + n, end());
+        }
+    }
+
+    void assign(std::initializer_list<value_type> il)
+    {
+        assign(il.begin(), il.end());
+    }
+
+    allocator_type get_allocator() const
+    { return m_alloc; }
+
+    // iterators
+    iterator begin() { return m_start; }
+    const_iterator begin() const { return m_start; }
+    iterator end() { return m_start + m_size; }
+    const_iterator end() const { return m_start + m_size; }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+    const_reverse_iterator crbegin() const { return rbegin(); }
+    const_reverse_iterator crend() const { return rend(); }
+
+    // size/capacity
+    bool empty() const { return m_size == 0; }
+    size_type size() const { return m_size; }
+    size_type capacity() const { return m_capacity; }
+    size_type max_size() const { return alloc_traits::max_size(m_alloc); }
+    static constexpr size_type inline_capacity() { return N; }
+
+    // Return true if the elements are stored inside the object.
+    bool is_inline() const
+    { return m_start == inline_storage(); }
+
+    void reserve(size_type n)
+    {
+        if (n > m_capacity)
+        {
+            reallocate(n);
+        }
+    }
+
+    // Move the elements back to the inline storage if possible.
+    void shrink_to_fit()
+    {
+        if (is_inline() || m_size == m_capacity)
+        {
+            return;
+        }
+
+        if (m_size <= N)
+        {
+            auto storage = m_start;
+            auto capacity = m_capacity;
+            relocate_range(storage, storage + m_size, inline_storage());
+            m_start = inline_storage();
+            m_capacity = N;
+            alloc_traits::deallocate(m_alloc, storage, capacity);
+        }
+        else
+        {
+            reallocate(m_size);
+        }
+    }
+
+    void resize(size_type n)
+    {
+        if (n < m_size)
+        {
+            erase(begin() + n, end());
+        }
+        else
+        {
+            reserve(n);
+
+            for (; m_size < n; ++m_size)
+            {
+                alloc_traits::construct(m_alloc, m_start + m_size);
+            }
+        }
+    }
+
+    void resize(size_type n, const value_type& value)
+    {
+        if (n < m_size)
+        {
+            erase(begin() + n, end());
+        }
+        else if (n > m_size)
+        {
+            insert(end(), n - m_size, value);
+        }
+    }
+
+    // element and data access
+    reference operator[](size_type n)
+    {
+        assert(n < m_size && "invalid index");
+        return m_start[n];
+    }
+
+    const_reference operator[](size_type n) const
+    {
+        assert(n < m_size && "invalid index");
+        return m_start[n];
+    }
+
+    reference at(size_type n)
+    {
+        if (n >= m_size)
+        {
+            throw std::out_of_range("small_vector::at");
+        }
+        return m_start[n];
+    }
+
+    const_reference at(size_type n) const
+    {
+        if (n >= m_size)
+        {
+            throw std::out_of_range("small_vector::at");
+        }
+        return m_start[n];
+    }
+
+    reference front()
+    {
+        assert(!empty() && "small_vector has no element!");
+        return m_start[0];
+    }
+
+    const_reference front() const
+    {
+        assert(!empty() && "small_vector has no element!");
+        return m_start[0];
+    }
+
+    reference back()
+    {
+        assert(!empty() && "small_vector has no element!");
+        return m_start[m_size - 1];
+    }
+
+    const_reference back() const
+    {
+        assert(!empty() && "small_vector has no element!");
+        return m_start[m_size - 1];
+    }
+
+    T* data() { return m_start; }
+    const T* data() const { return m_start; }
+
+    // modifiers
+    template <typename... Args>
+    reference emplace_back(Args&&... args)
+    {
+        if (m_size == m_capacity)
+        {
+            // Something in args... could alias one of the elements, construct
+            // the new element before the old storage is released.
+            auto new_capacity = std::max(m_size + 1, m_capacity * 2);
+            auto new_start = alloc_traits::allocate(m_alloc, new_capacity);
+
+            try
+            {
+                alloc_traits::construct(m_alloc, new_start + m_size, (Args&&) args...);
+            }
+            catch (...)
+            {
+                alloc_traits::deallocate(m_alloc, new_start, new_capacity);
+                throw;
+            }
+
+            try
+            {
+                relocate_range(m_start, m_start + m_size, new_start);
+            }
+            catch (...)
+            {
+                alloc_traits::destroy(m_alloc, new_start + m_size);
+                alloc_traits::deallocate(m_alloc, new_start, new_capacity);
+                throw;
+            }
+
+            replace_storage(new_start, new_capacity);
+        }
+        else
+        {
+            alloc_traits::construct(m_alloc, m_start + m_size, (Args&&) args...);
+        }
+
+        return m_start[m_size++];
+    }
+
+    void push_back(const value_type& x)
+    { emplace_back(x); }
+
+    void push_back(value_type&& x)
+    { emplace_back(std::move(x)); }
+
+    void pop_back()
+    {
+        assert(!empty() && "small_vector has no element!");
+        alloc_traits::destroy(m_alloc, m_start + --m_size);
+    }
+
+    template <typename... Args>
+    iterator emplace(const_iterator position, Args&&... args)
+    {
+        assert(begin() <= position && position <= end() && "invalid position");
+
+        const auto dist = position - cbegin();
+
+        if (dist == static_cast<difference_type>(m_size))
+        {
+            emplace_back((Args&&) args...);
+            return begin() + dist;
+        }
+
+        // See buffer::emplace.
+        value_handle<T, Allocator> handle(m_alloc, (Args&&) args...);
+        grow(m_size + 1);
+
+        auto dest = m_start + dist;
+
+        if constexpr (relocate_by_memcpy)
+        {
+            std::memmove(dest + 1, dest, (m_size - dist) * sizeof(T));
+            ::new (static_cast<void*>(dest)) T(*handle);
+        }
+        else
+        {
+            alloc_traits::construct(m_alloc, m_start + m_size, std::move(back()));
+            std::move_backward(dest, m_start + m_size - 1, m_start + m_size);
+            *dest = *handle;
+        }
+
+        ++m_size;
+        return dest;
+    }
+
+    iterator insert(const_iterator position, const value_type& x)
+    { return emplace(position, x); }
+
+    iterator insert(const_iterator position, value_type&& x)
+    { return emplace(position, std::move(x)); }
+
+    iterator insert(const_iterator position, size_type n, const value_type& x)
+    {
+        const auto dist = position - cbegin();
+
+        if (n == 0)
+        {
+            return begin() + dist;
+        }
+
+        if (m_size + n > m_capacity)
+        {
+            // The x may alias one of the elements.
+            value_type copy = x;
+            grow(m_size + n);
+            std::uninitialized_fill_n(end(), n, copy);
+        }
+        else
+        {
+            std::uninitialized_fill_n(end(), n, x);
+        }
+
+        m_size += n;
+        std::rotate(begin() + dist, end() - n, end());
+        return begin() + dist;
+    }
+
+    template <std::input_iterator InputIterator>
+    iterator insert(const_iterator position, InputIterator first, InputIterator last)
+    {
+        const auto dist = position - cbegin();
+        const auto old_size = m_size;
+
+        if constexpr (std::forward_iterator<InputIterator>)
+        {
+            grow(m_size + static_cast<size_type>(std::distance(first, last)));
+        }
+
+        // Append the elements and rotate them to the position, the same as buffer::insert.
+        for (; first != last; ++first)
+        {
+            emplace_back(*first);
+        }
+
+        std::rotate(begin() + dist, begin() + old_size, end());
+        return begin() + dist;
+    }
+
+    iterator insert(const_iterator position, std::initializer_list<value_type> il)
+    { return insert(position, il.begin(), il.end()); }
+
+    iterator erase(const_iterator position)
+    {
+        assert(begin() <= position && position < end() && "invalid position");
+        return erase(position, position + 1);
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        assert(begin() <= first && first <= last && last <= end() && "invalid position");
+
+        auto dest = begin() + (first - cbegin());
+        auto tail = begin() + (last - cbegin());
+        const auto count = static_cast<size_type>(tail - dest);
+
+        if (count == 0)
+        {
+            return dest;
+        }
+
+        if constexpr (relocate_by_memcpy)
+        {
+            destroy_range(dest, tail);
+            std::memmove(dest, tail, (end() - tail) * sizeof(T));
+        }
+        else
+        {
+            std::move(tail, end(), dest);
+            destroy_range(end() - count, end());
+        }
+
+        m_size -= count;
+        return dest;
+    }
+
+    void clear() noexcept
+    {
+        destroy_range(m_start, m_start + m_size);
+        m_size = 0;
+    }
+
+    void swap(small_vector& other)
+    noexcept(std::is_nothrow_move_constructible_v<value_type> && std::is_nothrow_swappable_v<allocator_type>)
+    {
+        if (this == std::addressof(other))
+        {
+            return;
+        }
+
+        if (!is_inline() && !other.is_inline())
+        {
+            if constexpr (alloc_traits::propagate_on_container_swap::value)
+            {
+                using std::swap;
+                swap(m_alloc, other.m_alloc);
+            }
+            else
+            {
+                assert(m_alloc == other.m_alloc && "The behaviour is undefined.");
+            }
+
+            std::swap(m_start, other.m_start);
+            std::swap(m_size, other.m_size);
+            std::swap(m_capacity, other.m_capacity);
+            return;
+        }
+
+        // At least one of them is inline, the elements must be moved.
+        small_vector temp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(temp);
+    }
+
+    friend void swap(small_vector& lhs, small_vector& rhs) noexcept(noexcept(lhs.swap(rhs)))
+    {
+        lhs.swap(rhs);
+    }
+
+    friend bool operator==(const small_vector& a, const small_vector& b)
+    { return std::ranges::equal(a, b); }
+
+    friend auto operator<=>(const small_vector& a, const small_vector& b)
+    requires std::three_way_comparable<value_type>
+    { return std::lexicographical_compare_three_way(a.begin(), a.end(), b.begin(), b.end()); }
+
+private:
+
+    T* inline_storage()
+    { return reinterpret_cast<T*>(m_inline); }
+
+    const T* inline_storage() const
+    { return reinterpret_cast<const T*>(m_inline); }
+
+    // Make room for n elements, the capacity is at least doubled.
+    void grow(size_type n)
+    {
+        if (n > m_capacity)
+        {
+            reallocate(std::max(n, m_capacity * 2));
+        }
+    }
+
+    void destroy_range(T* first, T* last)
+    {
+        for (; first != last; ++first)
+        {
+            alloc_traits::destroy(m_alloc, first);
+        }
+    }
+
+    // Move [first, last) to uninitialized memory dest and destroy them. If an
+    // exception is thrown, the source is unchanged.
+    void relocate_range(T* first, T* last, T* dest)
+    {
+        if constexpr (relocate_by_memcpy)
+        {
+            if (first != last)
+            {
+                std::memcpy(dest, first, (last - first) * sizeof(T));
+            }
+        }
+        else if constexpr (std::is_nothrow_move_constructible_v<T>)
+        {
+            for (; first != last; ++first, ++dest)
+            {
+                alloc_traits::construct(m_alloc, dest, std::move(*first));
+                alloc_traits::destroy(m_alloc, first);
+            }
+        }
+        else
+        {
+            auto cur = dest;
+
+            try
+            {
+                for (auto ptr = first; ptr != last; ++ptr, ++cur)
+                {
+                    alloc_traits::construct(m_alloc, cur, std::move_if_noexcept(*ptr));
+                }
+            }
+            catch (...)
+            {
+                destroy_range(dest, cur);
+                throw;
+            }
+
+            destroy_range(first, last);
+        }
+    }
+
+    void reallocate(size_type n)
+    {
+        assert(n >= m_size);
+        auto new_start = alloc_traits::allocate(m_alloc, n);
+
+        try
+        {
+            relocate_range(m_start, m_start + m_size, new_start);
+        }
+        catch (...)
+        {
+            alloc_traits::deallocate(m_alloc, new_start, n);
+            throw;
+        }
+
+        replace_storage(new_start, n);
+    }
+
+    // The elements have already been relocated to new_start.
+    void replace_storage(T* new_start, size_type new_capacity)
+    {
+        release_storage();
+        m_start = new_start;
+        m_capacity = new_capacity;
+    }
+
+    void release_storage()
+    {
+        if (!is_inline())
+        {
+            alloc_traits::deallocate(m_alloc, m_start, m_capacity);
+            m_start = inline_storage();
+            m_capacity = N;
+        }
+    }
+
+    void steal(small_vector& other)
+    {
+        m_start = std::exchange(other.m_start, other.inline_storage());
+        m_size = std::exchange(other.m_size, 0);
+        m_capacity = std::exchange(other.m_capacity, N);
+    }
+
+    T* m_start;
+    size_type m_size = 0;
+    size_type m_capacity = N;
+    [[no_unique_address]] allocator_type m_alloc;
+    alignas(T) unsigned char m_inline[sizeof(T) * N];
+};
+
+} // namespace cpp::collections
+
@@ -0,0 +1,189 @@
+#include "small_vector.hpp"
+#include <algorithm>
+#include <ranges>
+#include <string>
+#include <vector>
+#include <catch2/catch_all.hpp>
+
+using cpp::collections::small_vector;
+
+TEST_CASE("small vector ctor")
+{
+    small_vector<int, 8> v1;
+    REQUIRE(v1.empty());
+    REQUIRE(v1.capacity() == 8);
+    REQUIRE(v1.is_inline());
+
+    small_vector<int, 8> v2(8, 1);
+    REQUIRE(v2.size() == 8);
+    REQUIRE(v2.is_inline());
+    REQUIRE(std::ranges::all_of(v2, [](int x) { return x == 1; }));
+
+    small_vector<int, 8> v3(9);
+    REQUIRE(v3.size() == 9);
+    REQUIRE(!v3.is_inline());
+
+    std::initializer_list il = { 0, 1, 2, 3 };
+    small_vector<int, 2> v4(il);
+    REQUIRE(std::ranges::equal(v4, il));
+
+    small_vector<int, 2> v5 = v4;
+    REQUIRE(v5 == v4);
+
+    v5 = { 1 };
+    REQUIRE(v5.size() == 1);
+    v5 = v4;
+    REQUIRE(v5 == v4);
+}
+
+TEST_CASE("small vector spills to heap")
+{
+    small_vector<std::string, 4> v;
+    std::vector<std::string> expected;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        auto s = std::to_string(i) + std::string(20, 'x');
+        v.emplace_back(s);
+        expected.emplace_back(s);
+        REQUIRE(v.is_inline() == (i < 4));
+    }
+
+    REQUIRE(std::ranges::equal(v, expected));
+
+    // The argument aliases an element of the vector.
+    small_vector<std::string, 2> v2 = { "a", "b" };
+    v2.push_back(v2[0]);
+    REQUIRE(v2.back() == "a");
+
+    v.erase(v.begin() + 10, v.end());
+    v.shrink_to_fit();
+    REQUIRE(v.size() == 10);
+    REQUIRE(!v.is_inline());
+    REQUIRE(v.capacity() == 10);
+
+    v.erase(v.begin() + 4, v.end());
+    v.shrink_to_fit();
+    REQUIRE(v.is_inline());
+    REQUIRE(std::ranges::equal(v, expected | std::views::take(4)));
+}
+
+template <typename T, typename Generator>
+void random_operations(Generator make)
+{
+    small_vector<T, 8> v;
+    std::vector<T> expected;
+    unsigned seed = 1;
+
+    auto random = [&]() {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) & 0x7fff;
+    };
+
+    for (int i = 0; i < 3000; ++i)
+    {
+        const auto op = random() % 6;
+        const auto pos = expected.empty() ? 0 : random() % expected.size();
+
+        switch (op)
+        {
+            case 0:
+            case 1:
+                v.push_back(make(i));
+                expected.push_back(make(i));
+                break;
+            case 2:
+                v.insert(v.begin() + pos, make(i));
+                expected.insert(expected.begin() + pos, make(i));
+                break;
+            case 3:
+                v.insert(v.begin() + pos, 3, make(i));
+                expected.insert(expected.begin() + pos, 3, make(i));
+                break;
+            case 4:
+                if (!expected.empty())
+                {
+                    v.erase(v.begin() + pos);
+                    expected.erase(expected.begin() + pos);
+                }
+                break;
+            default:
+            {
+                const auto last = std::min<std::size_t>(pos + random() % 4, expected.size());
+                v.erase(v.begin() + pos, v.begin() + last);
+                expected.erase(expected.begin() + pos, expected.begin() + last);
+                break;
+            }
+        }
+
+        REQUIRE(std::ranges::equal(v, expected));
+    }
+
+    std::vector<T> values = { make(-1), make(-2) };
+    v.insert(v.begin() + 1, values.begin(), values.end());
+    expected.insert(expected.begin() + 1, values.begin(), values.end());
+    REQUIRE(std::ranges::equal(v, expected));
+}
+
+TEST_CASE("small vector insert and erase")
+{
+    random_operations<int>([](int i) { return i; });
+    random_operations<std::string>([](int i) { return std::to_string(i) + std::string(20, 'x'); });
+}
+
+TEST_CASE("small vector move and swap")
+{
+    small_vector<std::string, 2> inline_vector = { "a" };
+    small_vector<std::string, 2> heap_vector = { "b", "c", "d" };
+
+    auto v1 = std::move(inline_vector);
+    REQUIRE(v1.size() == 1);
+    REQUIRE(v1.is_inline());
+    REQUIRE(inline_vector.empty());
+
+    const auto data = heap_vector.data();
+    auto v2 = std::move(heap_vector);
+    REQUIRE(v2.data() == data);
+    REQUIRE(heap_vector.empty());
+    REQUIRE(heap_vector.is_inline());
+
+    v1.swap(v2);
+    REQUIRE(v1.data() == data);
+    REQUIRE(v1 == small_vector<std::string, 2>{ "b", "c", "d" });
+    REQUIRE(v2 == small_vector<std::string, 2>{ "a" });
+
+    v2 = std::move(v1);
+    REQUIRE(v2.data() == data);
+    REQUIRE(v1.empty());
+
+    small_vector<std::string, 2> v3 = { "e", "f", "g" };
+    small_vector<std::string, 2> v4 = { "h", "i", "j", "k" };
+    v3.swap(v4);
+    REQUIRE(v3.size() == 4);
+    REQUIRE(v4.size() == 3);
+}
+
+TEST_CASE("small vector resize and compare")
+{
+    small_vector<int, 4> v1 = { 1, 2, 3 };
+    small_vector<int, 4> v2 = { 1, 2, 4 };
+
+    REQUIRE(v1 < v2);
+    REQUIRE(v1 != v2);
+
+    v1.resize(10, 7);
+    REQUIRE(v1.size() == 10);
+    REQUIRE(v1.back() == 7);
+
+    v1.resize(2);
+    REQUIRE(v1.size() == 2);
+    REQUIRE(v1 < v2);
+
+    v1.assign(6, 5);
+    REQUIRE(v1.size() == 6);
+    REQUIRE(v1.at(5) == 5);
+    REQUIRE_THROWS_AS(v1.at(6), std::out_of_range);
+
+    v1.clear();
+    REQUIRE(v1.empty());
+}
@@ -8,12 +8,18 @@
 namespace cpp::collections
 {
     
-struct avl_node : public binary_node_operation
+/**
+ * @brief AVL tree node.
+ * 
+ * @param Augmentation Data maintained for each subtree, see tree_node_operation.hpp
+*/
+template <typename Augmentation = empty_augmentation>
+struct basic_avl_node : public binary_node_operation, public Augmentation
 {
     static constexpr int balance_factor = 2;
 
     // Nodes
-    avl_node* m_link[3];
+    basic_avl_node* m_link[3];
 
     // Height(balance factor) of current node, -1 for header, 1 for leaf and 0 for nullptr
     int m_height;
@@ -35,7 +41,7 @@ struct avl_node : public binary_node_operation
         m_height = -1;
     }
 
-    static int height(const avl_node* node)
+    static int height(const basic_avl_node* node)
     {
         return node ? node->m_height : 0;
     }
@@ -47,9 +53,10 @@ struct avl_node : public binary_node_operation
         m_height = std::max(lh, rh) + 1;
     }
 
-    void clone(const avl_node* x)
+    void clone(const basic_avl_node* x)
     {
         m_height = x->m_height;
+        static_cast<Augmentation&>(*this) = static_cast<const Augmentation&>(*x);
     }
 
     bool is_header() const
@@ -57,13 +64,13 @@ struct avl_node : public binary_node_operation
         return m_height == -1;
     }
 
-    void erase_node(avl_node* header)
+    void erase_node(basic_avl_node* header)
     {
         auto x = this;
         auto& [root, leftmost, rightmost] = header->m_link;
 
-        avl_node* child = nullptr;
-        avl_node* parent = nullptr; // for rebalance
+        basic_avl_node* child = nullptr;
+        basic_avl_node* parent = nullptr; // for rebalance
 
         if (x->lchild() && x->rchild())
         {
@@ -160,10 +167,11 @@ struct avl_node : public binary_node_operation
             parent = x->parent();
         }
 
+        parent->augment_to_root(*header);
         parent->avl_tree_rebalance_erase(header);
     }
 
-    avl_node* avl_tree_fix_l(avl_node* header)
+    basic_avl_node* avl_tree_fix_l(basic_avl_node* header)
     {
         auto x = this;
         auto r = x->rchild();
@@ -183,7 +191,7 @@ struct avl_node : public binary_node_operation
         return x->parent();
     }
 
-    avl_node* avl_tree_fix_r(avl_node* header)
+    basic_avl_node* avl_tree_fix_r(basic_avl_node* header)
     {
         auto x = this;
         auto l = x->lchild();
@@ -203,7 +211,7 @@ struct avl_node : public binary_node_operation
         return x->parent();
     }
 
-    void avl_tree_rebalance_erase(avl_node* header)
+    void avl_tree_rebalance_erase(basic_avl_node* header)
     {
         auto x = this;
 
@@ -234,7 +242,7 @@ struct avl_node : public binary_node_operation
         }
     }
 
-    void insert_and_rebalance(bool insert_left, avl_node* p, avl_node& header)
+    void insert_and_rebalance(bool insert_left, basic_avl_node* p, basic_avl_node& header)
     {
         assert(this->m_height == 1 && "The node should be a leaf node");
         this->insert_node_and_update_header(insert_left, p, header);
@@ -266,7 +274,7 @@ struct avl_node : public binary_node_operation
         }
     }
 
-    avl_node* rebalance_for_erase(avl_node& header)
+    basic_avl_node* rebalance_for_erase(basic_avl_node& header)
     {
         auto [successor, child, child_parent] = this->replace_node_with_successor(header);
 
@@ -285,8 +293,135 @@ struct avl_node : public binary_node_operation
         // this->erase_node(&header);
         // return this;
     }
-    
+
+    // Join-based algorithms, see https://en.wikipedia.org/wiki/Join-based_tree_algorithms
+
+    /**
+     * @brief: Join left, mid and right into one tree. The keys in left are not 
+     *  greater than key of mid and the keys in right are not less than key of mid.
+     * 
+     * @param mid Detached node, the fields will be reset.
+     * @return: Root of the new tree, the parent of root is unspecified.
+    */
+    static basic_avl_node* join(basic_avl_node* left, basic_avl_node* mid, basic_avl_node* right)
+    {
+        const int lh = height(left);
+        const int rh = height(right);
+
+        if (lh > rh + 1)
+        {
+            return join_right(left, mid, right);
+        }
+
+        if (rh > lh + 1)
+        {
+            return join_left(left, mid, right);
+        }
+
+        mid->link_children(left, right);
+        mid->update_height();
+        return mid;
+    }
+
+    // The height is stored in each node, so the rank of subtrees is always O(1).
+
+    static ranked_subtree<basic_avl_node> make_ranked(basic_avl_node* x)
+    {
+        return { x, height(x) };
+    }
+
+    // Return the children of t.root, call it before t.root is detached.
+    static std::pair<ranked_subtree<basic_avl_node>, ranked_subtree<basic_avl_node>> ranked_children(const ranked_subtree<basic_avl_node>& t)
+    {
+        return { make_ranked(t.root->lchild()), make_ranked(t.root->rchild()) };
+    }
+
+    static ranked_subtree<basic_avl_node> join(const ranked_subtree<basic_avl_node>& left, basic_avl_node* mid, const ranked_subtree<basic_avl_node>& right)
+    {
+        return make_ranked(join(left.root, mid, right.root));
+    }
+
+private:
+
+    static basic_avl_node* rotate_left_and_update(basic_avl_node* x)
+    {
+        auto y = x->rotate_left_subtree();
+        x->update_height();
+        y->update_height();
+        return y;
+    }
+
+    static basic_avl_node* rotate_right_and_update(basic_avl_node* x)
+    {
+        auto y = x->rotate_right_subtree();
+        x->update_height();
+        y->update_height();
+        return y;
+    }
+
+    // Join along the right spine of left, height(left) > height(right) + 1.
+    static basic_avl_node* join_right(basic_avl_node* left, basic_avl_node* mid, basic_avl_node* right)
+    {
+        auto l = left->lchild();
+        auto c = left->rchild();
+
+        if (height(c) <= height(right) + 1)
+        {
+            mid->link_children(c, right);
+            mid->update_height();
+
+            if (mid->m_height <= height(l) + 1)
+            {
+                left->link_children(l, mid);
+                left->update_height();
+                return left;
+            }
+
+            left->link_children(l, rotate_right_and_update(mid));
+            left->update_height();
+            return rotate_left_and_update(left);
+        }
+
+        auto t = join_right(c, mid, right);
+        left->link_children(l, t);
+        left->update_height();
+        return t->m_height <= height(l) + 1 ? left : rotate_left_and_update(left);
+    }
+
+    // Join along the left spine of right, height(right) > height(left) + 1.
+    static basic_avl_node* join_left(basic_avl_node* left, basic_avl_node* mid, basic_avl_node* right)
+    {
+        auto c = right->lchild();
+        auto r = right->rchild();
+
+        if (height(c) <= height(left) + 1)
+        {
+            mid->link_children(left, c);
+            mid->update_height();
+
+            if (mid->m_height <= height(r) + 1)
+            {
+                right->link_children(mid, r);
+                right->update_height();
+                return right;
+            }
+
+            right->link_children(rotate_left_and_update(mid), r);
+            right->update_height();
+            return rotate_right_and_update(right);
+        }
+
+        auto t = join_left(left, mid, c);
+        right->link_children(t, r);
+        right->update_height();
+        return t->m_height <= height(r) + 1 ? right : rotate_right_and_update(right);
+    }
 };
 
+using avl_node = basic_avl_node<>;
+
+// AVL tree node which supports order statistic.
+using indexed_avl_node = basic_avl_node<subtree_size_augmentation>;
+
 } // namespace cpp::collections
 
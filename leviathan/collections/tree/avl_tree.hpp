@@ -18,5 +18,18 @@ using avl_treemap = tree_map<avl_node, K, V, Compare, Allocator>;
 template <typename K, typename V, typename Compare = std::less<>, typename Allocator = std::allocator<std::pair<const K, V>>>
 using avl_tree_multimap = tree_multimap<avl_node, K, V, Compare, Allocator>;
 
+// AVL trees with nth_element and order_of_key.
+template <typename T, typename Compare = std::less<>, typename Allocator = std::allocator<T>>
+using indexed_avl_treeset = tree_set<indexed_avl_node, T, Compare, Allocator>;
+
+template <typename T, typename Compare = std::less<>, typename Allocator = std::allocator<T>>
+using indexed_avl_tree_multiset = tree_multiset<indexed_avl_node, T, Compare, Allocator>;
+
+template <typename K, typename V, typename Compare = std::less<>, typename Allocator = std::allocator<std::pair<const K, V>>>
+using indexed_avl_treemap = tree_map<indexed_avl_node, K, V, Compare, Allocator>;
+
+template <typename K, typename V, typename Compare = std::less<>, typename Allocator = std::allocator<std::pair<const K, V>>>
+using indexed_avl_tree_multimap = tree_multimap<indexed_avl_node, K, V, Compare, Allocator>;
+
 } // namespace cpp::collections
 
@@ -120,11 +120,14 @@ TEST_CASE("avl_tree_height_test")
     // Logger::WriteMessage(avl.draw().c_str());
 }
 
+TEST_CASE("avl_tree_order_statistic_test")
+{
+    CheckOrderStatistic<tree_set<indexed_avl_node, int>, std::set<int>>();
+    CheckOrderStatistic<tree_multiset<indexed_avl_node, int>, std::multiset<int>>();
+}
 
-
-
-
-
-
-
-
+TEST_CASE("avl_tree_join_test")
+{
+    CheckJoinBasedAlgorithms<Tree<int>, TreeWithMultiKey<int>>();
+    CheckJoinBasedAlgorithms<tree_set<indexed_avl_node, int>, tree_multiset<indexed_avl_node, int>>();
+}
@@ -0,0 +1,1743 @@
+/**
+ * A B+ tree with the same set/map interface as tree.
+ *
+ * Binary trees store one element per node and every level of a search is a
+ * dependent cache miss. B+ tree stores up to Capacity elements in each leaf and
+ * up to Capacity separator keys in each internal node, so a search only touches
+ * log(n) / log(Capacity) nodes and the keys of a node are compared in a few
+ * consecutive cache lines.
+ *
+ * - Elements are only stored in leaves. Leaves are linked with each other, so
+ *   iteration never climbs the tree.
+ * - Internal node keeps copies of keys as separators. For the i-th separator,
+ *   all elements in children[i] are not greater than it and all elements in
+ *   children[i + 1] are not less than it. Erasing an element never updates
+ *   separators unless the nodes are rebalanced since the separators are still valid.
+ * - Each node except root has at least (Capacity - 1) / 2 elements(or keys) unless
+ *   the node is built at the right edge by bulk loading, and nodes are rebalanced
+ *   by borrowing from or merging with siblings after erasing.
+ *
+ * Iterator invalidation:
+ * - Since elements are stored in arrays, insert/emplace/erase invalidate all iterators,
+ *   references and pointers to elements of the tree(including end()).
+ *
+ * Elements are relocated(move constructed and destroyed) when nodes are shifted,
+ * split or merged, so the element(key and mapped value for maps) should be nothrow
+ * move constructible. For maps, the element is stored in a union slot holding
+ * std::pair<K, V>, so the key is moved instead of copied, see detail::btree_slot.
+*/
+#pragma once
+
+#include <leviathan/collections/common.hpp>
+#include <leviathan/collections/container_interface.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace cpp::collections
+{
+
+namespace detail
+{
+
+/**
+ * @brief The default number of elements in each node.
+ *
+ * Keep the elements of a leaf in about 8 cache lines, and the number
+ * of elements in each node is between 16 and 64.
+*/
+template <typename T>
+inline constexpr std::size_t btree_node_capacity = std::clamp<std::size_t>(512 / sizeof(T), 16, 64);
+
+// The storage of element in leaf.
+template <typename T>
+union btree_slot
+{
+    using value_type = T;
+    using stored_type = T;   // the type actually constructed in the slot
+
+    value_type value;
+
+    btree_slot() { }
+    ~btree_slot() { }
+
+    stored_type* address()
+    { return std::addressof(value); }
+
+    value_type* element()
+    { return std::launder(std::addressof(value)); }
+
+    stored_type* stored_element()
+    { return element(); }
+};
+
+// Same as the map slot of abseil. If std::pair<const K, V> and std::pair<K, V> 
+// are layout compatible, the element is constructed as std::pair<K, V> so the
+// key can be moved when the element is relocated, and it is accessed as 
+// std::pair<const K, V>. Otherwise the key is copied.
+template <typename K, typename V>
+union btree_slot<std::pair<const K, V>>
+{
+    using value_type = std::pair<const K, V>;
+    using mutable_value_type = std::pair<K, V>;
+
+    static constexpr bool mutable_keys = 
+        std::is_standard_layout_v<value_type> && std::is_standard_layout_v<mutable_value_type> &&
+        sizeof(value_type) == sizeof(mutable_value_type) && alignof(value_type) == alignof(mutable_value_type);
+
+    using stored_type = std::conditional_t<mutable_keys, mutable_value_type, value_type>;
+
+    value_type value;
+    mutable_value_type mutable_value;
+
+    btree_slot() { }
+    ~btree_slot() { }
+
+    stored_type* address()
+    {
+        if constexpr (mutable_keys)
+            return std::addressof(mutable_value);
+        else
+            return std::addressof(value);
+    }
+
+    value_type* element()
+    { return std::launder(std::addressof(value)); }
+
+    stored_type* stored_element()
+    {
+        if constexpr (mutable_keys)
+            return std::launder(std::addressof(mutable_value));
+        else
+            return element();
+    }
+};
+
+} // namespace detail
+
+template <typename KeyOfValue, typename LeafNode>
+struct btree_iterator
+{
+    using link_type = LeafNode*;
+    using value_type = typename KeyOfValue::value_type;
+    using key_type = typename KeyOfValue::key_type;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::bidirectional_iterator_tag;
+    using reference = std::conditional_t<std::is_same_v<key_type, value_type>, const value_type&, value_type&>;
+
+    link_type m_leaf = nullptr;
+    std::size_t m_pos = 0;
+
+    constexpr btree_iterator() = default;
+    constexpr btree_iterator(const btree_iterator&) = default;
+    constexpr btree_iterator(link_type leaf, std::size_t pos) : m_leaf(leaf), m_pos(pos) { }
+
+    // The const_iterator and iterator may model same type, so we offer
+    // a base method to avoid if-constexpr.
+    constexpr btree_iterator base() const
+    {
+        return *this;
+    }
+
+    constexpr btree_iterator& operator++()
+    {
+        // The end iterator is the position past the last element of the last leaf.
+        if (++m_pos == m_leaf->m_count && m_leaf->m_next)
+        {
+            m_leaf = m_leaf->m_next;
+            m_pos = 0;
+        }
+        return *this;
+    }
+
+    constexpr btree_iterator& operator--()
+    {
+        if (m_pos == 0)
+        {
+            m_leaf = m_leaf->m_prev;
+            m_pos = m_leaf->m_count;
+        }
+        --m_pos;
+        return *this;
+    }
+
+    constexpr btree_iterator operator++(int)
+    {
+        btree_iterator tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    constexpr btree_iterator operator--(int)
+    {
+        btree_iterator tmp = *this;
+        --*this;
+        return tmp;
+    }
+
+    constexpr auto operator->() const
+    {
+        return std::addressof(operator*());
+    }
+
+    constexpr reference operator*() const
+    {
+        return m_leaf->value(m_pos);
+    }
+
+    friend constexpr bool operator==(btree_iterator, btree_iterator) = default;
+};
+
+/**
+ * @brief B+ tree.
+ *
+ * @param KeyOfValue Extractor extract key from value. identity<T> for set and select1st<K, V> for map
+ * @param Compare Compare Key comparison function object
+ * @param Allocator Allocator Type of the allocator object used to define the storage allocation model
+ * @param UniqueKey True for set/map and False for multiset/multimap
+ * @param Capacity Maximum number of elements in leaf and keys in internal node
+*/
+template <typename KeyOfValue,
+    typename Compare,
+    typename Allocator,
+    bool UniqueKey,
+    std::size_t Capacity = detail::btree_node_capacity<typename KeyOfValue::value_type>>
+class btree : public iterable_interface,
+              public std::conditional_t<UniqueKey, unique_insert_interface, insert_interface>,
+              public erase_interface,
+              public lookup_interface
+{
+    static_assert(Capacity >= 4 && Capacity <= UINT16_MAX, "Capacity should be in [4, 65535].");
+
+    template <typename A, typename B, typename C, bool D, std::size_t E>
+    friend class btree;
+
+    using insert_functions = std::conditional_t<UniqueKey, unique_insert_interface, insert_interface>;
+
+public:
+
+    using value_type = typename KeyOfValue::value_type;
+    using key_type = typename KeyOfValue::key_type;
+    using reference = typename KeyOfValue::reference;
+    using const_reference = typename KeyOfValue::const_reference;
+    using size_type = std::size_t;
+    using allocator_type = Allocator;
+    using difference_type = std::ptrdiff_t;
+    using key_compare = Compare;
+    using value_compare = Compare;
+    using pointer = std::allocator_traits<Allocator>::pointer;
+    using const_pointer = std::allocator_traits<Allocator>::const_pointer;
+
+    static constexpr size_type node_capacity = Capacity;
+
+protected:
+
+    // Minimum number of elements(keys) in each node except root.
+    static constexpr std::size_t MinCount = (Capacity - 1) / 2;
+
+    struct internal_node;
+
+    using slot_type = detail::btree_slot<value_type>;
+
+    struct node_base
+    {
+        internal_node* m_parent;
+        std::uint16_t m_position;   // index in parent's children
+        std::uint16_t m_count;      // number of elements for leaf or keys for internal node
+        bool m_leaf;
+    };
+
+    struct alignas(detail::cache_line_size) leaf_node : node_base
+    {
+        leaf_node* m_prev;
+        leaf_node* m_next;
+        slot_type m_slots[Capacity];
+
+        slot_type* slot_ptr(std::size_t i)
+        { return m_slots + i; }
+
+        value_type* value_ptr(std::size_t i)
+        { return m_slots[i].element(); }
+
+        value_type& value(std::size_t i)
+        { return *value_ptr(i); }
+    };
+
+    struct alignas(detail::cache_line_size) internal_node : node_base
+    {
+        alignas(key_type) unsigned char m_storage[sizeof(key_type) * Capacity];
+        node_base* m_children[Capacity + 1];
+
+        key_type* key_ptr(std::size_t i)
+        { return std::launder(reinterpret_cast<key_type*>(m_storage) + i); }
+
+        key_type& key(std::size_t i)
+        { return *key_ptr(i); }
+    };
+
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+public:
+
+    using iterator = btree_iterator<KeyOfValue, leaf_node>;
+    using const_iterator = std::const_iterator<iterator>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+protected:
+
+    template <typename U>
+    using key_arg_t = detail::key_arg<detail::transparent<Compare>, U, key_type>;
+
+    static constexpr bool IsNothrowMoveConstruct = nothrow_move_constructible<Allocator, Compare>;
+    static constexpr bool IsNothrowMoveAssign = nothrow_move_assignable<Allocator, Compare>;
+    static constexpr bool IsNothrowSwap = nothrow_swappable<Allocator, Compare>;
+
+public:
+
+    btree() : btree(Compare()) { }
+
+    explicit btree(const Compare& comp, const Allocator& alloc = allocator_type())
+        : m_cmp(comp), m_alloc(alloc) { }
+
+    explicit btree(const Allocator& alloc) : btree(Compare(), alloc) { }
+
+    template <typename InputIt>
+    btree(InputIt first, InputIt last, const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+        : btree(comp, alloc)
+    {
+        insert(first, last);
+    }
+
+    btree(std::initializer_list<value_type> ilist, const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+        : btree(ilist.begin(), ilist.end(), comp, alloc) { }
+
+    btree(std::initializer_list<value_type> ilist, const Allocator& alloc)
+        : btree(ilist, Compare(), alloc) { }
+
+    template <container_compatible_range<value_type> R>
+    btree(std::from_range_t, R&& rg, const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+        : btree(std::ranges::begin(rg), std::ranges::end(rg), comp, alloc) { }
+
+    template <container_compatible_range<value_type> R>
+    btree(std::from_range_t, R&& rg, const Allocator& alloc)
+        : btree(std::ranges::begin(rg), std::ranges::end(rg), Compare(), alloc) { }
+
+    btree(const btree& other)
+        : btree(other, alloc_traits::select_on_container_copy_construction(other.m_alloc)) { }
+
+    btree(btree&& other) noexcept(IsNothrowMoveConstruct)
+        : m_cmp(std::move(other.m_cmp)), m_alloc(std::move(other.m_alloc))
+    {
+        steal(other);
+    }
+
+    btree(const btree& other, const Allocator& alloc) : btree(other.m_cmp, alloc)
+    {
+        build_from_sorted(other.begin(), other.size(), [](const auto& x) static -> const auto& { return x; });
+    }
+
+    btree(btree&& other, const Allocator& alloc)
+        : m_cmp(std::move(other.m_cmp)), m_alloc(alloc)
+    {
+        if (alloc == other.m_alloc)
+        {
+            steal(other);
+        }
+        else
+        {
+            build_from_sorted(other.begin(), other.size(), [](auto& x) static -> auto&& { return std::move(x); });
+            other.clear();
+        }
+    }
+
+    ~btree()
+    {
+        clear();
+    }
+
+    btree& operator=(const btree& other)
+    {
+        if (this != std::addressof(other))
+        {
+            clear();
+
+            m_cmp = other.m_cmp;
+
+            if constexpr (alloc_traits::propagate_on_container_copy_assignment::value)
+            {
+                m_alloc = other.m_alloc;
+            }
+
+            build_from_sorted(other.begin(), other.size(), [](const auto& x) static -> const auto& { return x; });
+        }
+
+        return *this;
+    }
+
+    btree& operator=(btree&& other) noexcept(IsNothrowMoveAssign)
+    {
+        if (this != std::addressof(other))
+        {
+            clear();
+
+            if constexpr (alloc_traits::propagate_on_container_move_assignment::value)
+            {
+                m_alloc = std::move(other.m_alloc);
+                m_cmp = std::move(other.m_cmp);
+                steal(other);
+            }
+            else if (m_alloc == other.m_alloc)
+            {
+                m_cmp = std::move(other.m_cmp);
+                steal(other);
+            }
+            else
+            {
+                m_cmp = other.m_cmp;
+                build_from_sorted(other.begin(), other.size(), [](auto& x) static -> auto&& { return std::move(x); });
+                other.clear();
+            }
+        }
+
+        return *this;
+    }
+
+    btree& operator=(std::initializer_list<value_type> ilist)
+    {
+        clear();
+        insert(ilist.begin(), ilist.end());
+        return *this;
+    }
+
+    // Iterators
+    template <typename Self>
+    self_iter_t<Self> begin(this Self&& self)
+    {
+        return iterator(self.m_first, 0);
+    }
+
+    template <typename Self>
+    self_iter_t<Self> end(this Self&& self)
+    {
+        return as_non_const(self).end_iterator();
+    }
+
+    // Member functions
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    allocator_type get_allocator() const
+    {
+        return m_alloc;
+    }
+
+    size_type max_size() const
+    {
+        return std::allocator_traits<Allocator>::max_size(m_alloc);
+    }
+
+    static KeyOfValue key_of_value()
+    {
+        return KeyOfValue();
+    }
+
+    // Observers
+    key_compare key_comp() const
+    {
+        return m_cmp;
+    }
+
+    value_compare value_comp() const
+    {
+        return m_cmp;
+    }
+
+    void clear()
+    {
+        if (m_root)
+        {
+            destroy_subtree(m_root);
+        }
+
+        m_root = nullptr;
+        m_first = m_last = nullptr;
+        m_size = 0;
+    }
+
+    // Lookup
+    template <typename Self, typename K = key_type>
+    self_iter_t<Self> lower_bound(this Self&& self, const key_arg_t<K>& x)
+    {
+        return as_non_const(self).lower_bound_impl(x);
+    }
+
+    template <typename Self, typename K = key_type>
+    self_iter_t<Self> upper_bound(this Self&& self, const key_arg_t<K>& x)
+    {
+        return as_non_const(self).upper_bound_impl(x);
+    }
+
+    // Modifiers
+    template <typename... Args>
+    auto emplace(Args&&... args)
+    {
+        if constexpr (UniqueKey)
+        {
+            if constexpr (detail::emplace_helper<value_type, Args...>::value ||
+                          (sizeof...(Args) == 1 && detail::transparent<Compare>))
+            {
+                return insert_unique((Args&&)args...);
+            }
+            else
+            {
+                // Same as tree, the value is constructed on stack first since the
+                // tree may contain the element with equivalent key.
+                value_handle<value_type, allocator_type> handle(m_alloc, (Args&&)args...);
+                return insert_unique(*handle);
+            }
+        }
+        else
+        {
+            value_handle<value_type, allocator_type> handle(m_alloc, (Args&&)args...);
+            auto pos = find_insert_multi_pos(KeyOfValue()(*handle));
+            return insert_at(pos, *handle);
+        }
+    }
+
+    using erase_interface::erase;
+
+    size_type erase(const key_type& key)
+    {
+        return erase_by_key(key);
+    }
+
+    const_iterator erase(const_iterator pos)
+    {
+        auto it = pos.base();
+        return erase_at(it.m_leaf, it.m_pos);
+    }
+
+    // Erasing invalidates last, so we count the elements first.
+    const_iterator erase(const_iterator first, const_iterator last)
+    {
+        const auto n = std::distance(first, last);
+
+        if (static_cast<size_type>(n) == size())
+        {
+            clear();
+            return end();
+        }
+
+        auto it = first.base();
+
+        for (auto i = n; i > 0; --i)
+        {
+            it = erase_at(it.m_leaf, it.m_pos);
+        }
+
+        return it;
+    }
+
+    template <typename KK> requires (detail::transparent<Compare> &&
+                                    !std::is_convertible_v<KK, iterator> &&
+                                    !std::is_convertible_v<KK, const_iterator>)
+    size_type erase(KK& x)
+    {
+        return erase_by_key(x);
+    }
+
+    using insert_functions::insert;
+
+    bool operator==(const btree& other) const
+    {
+        return size() == other.size() && std::equal(begin(), end(), other.begin());
+    }
+
+    auto operator<=>(const btree& other) const
+    {
+        return std::lexicographical_compare_three_way(
+            begin(), end(), other.begin(), other.end());
+    }
+
+    void swap(btree& other) noexcept(IsNothrowSwap)
+    {
+        using std::swap;
+
+        if constexpr (alloc_traits::propagate_on_container_swap::value)
+        {
+            swap(m_alloc, other.m_alloc);
+        }
+        else
+        {
+            assert(m_alloc == other.m_alloc && "It's undefined behavior if the allocators are unequal here.");
+        }
+
+        swap(m_cmp, other.m_cmp);
+        swap(m_root, other.m_root);
+        swap(m_first, other.m_first);
+        swap(m_last, other.m_last);
+        swap(m_size, other.m_size);
+    }
+
+    friend void swap(btree& lhs, btree& rhs) noexcept(noexcept(lhs.swap(rhs)))
+    {
+        lhs.swap(rhs);
+    }
+
+    /**
+     * @brief: Move the elements of source into this tree.
+     *
+     * Unlike node-based tree, elements are stored in arrays and cannot be
+     * spliced, so each element is moved and erased from source. For unique
+     * tree, the elements with equivalent key already in this tree are left
+     * in source.
+    */
+    template <typename C2, bool U2>
+    void merge(btree<KeyOfValue, C2, Allocator, U2, Capacity>& source)
+    {
+        // We check the address directly to avoid self-merge.
+        if (static_cast<const void*>(this) == static_cast<const void*>(std::addressof(source)))
+        {
+            return;
+        }
+
+        if constexpr (UniqueKey)
+        {
+            for (auto it = source.begin(); it != source.end(); )
+            {
+                auto [pos, exists] = find_insert_unique_pos(KeyOfValue()(*it));
+
+                if (exists)
+                {
+                    ++it;
+                }
+                else
+                {
+                    insert_at(pos, std::move(*it));
+                    it = source.erase(it).base();
+                }
+            }
+        }
+        else
+        {
+            for (auto& x : source)
+            {
+                emplace(std::move(x));
+            }
+
+            source.clear();
+        }
+    }
+
+    template <typename C2, bool U2>
+    void merge(btree<KeyOfValue, C2, Allocator, U2, Capacity>&& source)
+    {
+        merge(source);
+    }
+
+    // Number of levels of the tree, zero for empty tree.
+    size_type height() const
+    {
+        size_type h = 0;
+
+        for (auto x = m_root; x; ++h)
+        {
+            x = x->m_leaf ? nullptr : static_cast<internal_node*>(x)->m_children[0];
+        }
+
+        return h;
+    }
+
+protected:
+
+    iterator end_iterator()
+    {
+        return m_last ? iterator(m_last, m_last->m_count) : iterator();
+    }
+
+    // Move to the first element of next leaf if pos is past the end of leaf.
+    iterator make_iterator(leaf_node* leaf, std::size_t pos)
+    {
+        if (pos == leaf->m_count && leaf->m_next)
+        {
+            return iterator(leaf->m_next, 0);
+        }
+        return iterator(leaf, pos);
+    }
+
+    static const key_type& keys(leaf_node* leaf, std::size_t i)
+    {
+        return KeyOfValue()(leaf->value(i));
+    }
+
+    // Find the first position in [0, n) that pred(i) is false.
+    template <typename Pred>
+    static std::size_t partition_point(std::size_t n, Pred pred)
+    {
+        std::size_t first = 0;
+
+        while (n > 0)
+        {
+            const auto half = n / 2;
+
+            if (pred(first + half))
+            {
+                first += half + 1;
+                n -= half + 1;
+            }
+            else
+            {
+                n = half;
+            }
+        }
+
+        return first;
+    }
+
+    /**
+     * @brief: Find the leaf which may contain k.
+     *
+     * @param Upper If true, the leaf for upper_bound, otherwise lower_bound.
+    */
+    template <bool Upper, typename K>
+    leaf_node* find_leaf(const K& k) const
+    {
+        node_base* x = m_root;
+
+        while (!x->m_leaf)
+        {
+            auto node = static_cast<internal_node*>(x);
+
+            const auto i = partition_point(node->m_count, [&](std::size_t j) {
+                return Upper ? !m_cmp(k, node->key(j)) : m_cmp(node->key(j), k);
+            });
+
+            x = node->m_children[i];
+        }
+
+        return static_cast<leaf_node*>(x);
+    }
+
+    template <typename K>
+    std::size_t lower_bound_in_leaf(leaf_node* leaf, const K& k) const
+    {
+        return partition_point(leaf->m_count, [&](std::size_t j) { return m_cmp(keys(leaf, j), k); });
+    }
+
+    template <typename K>
+    std::size_t upper_bound_in_leaf(leaf_node* leaf, const K& k) const
+    {
+        return partition_point(leaf->m_count, [&](std::size_t j) { return !m_cmp(k, keys(leaf, j)); });
+    }
+
+    // Lookup helper
+    template <typename K>
+    iterator lower_bound_impl(const K& k)
+    {
+        if (!m_root)
+        {
+            return end_iterator();
+        }
+
+        auto leaf = find_leaf<false>(k);
+        return make_iterator(leaf, lower_bound_in_leaf(leaf, k));
+    }
+
+    template <typename K>
+    iterator upper_bound_impl(const K& k)
+    {
+        if (!m_root)
+        {
+            return end_iterator();
+        }
+
+        auto leaf = find_leaf<true>(k);
+        return make_iterator(leaf, upper_bound_in_leaf(leaf, k));
+    }
+
+    /**
+     * @brief: Find the position to insert k for unique tree.
+     * @return: (position, exists), if exists is true, the position points to
+     *  the element with equivalent key.
+    */
+    template <typename K>
+    std::pair<iterator, bool> find_insert_unique_pos(const K& k)
+    {
+        if (!m_root)
+        {
+            return { iterator(), false };
+        }
+
+        auto leaf = find_leaf<false>(k);
+        auto pos = lower_bound_in_leaf(leaf, k);
+
+        // The equivalent element may be the first element of next leaf.
+        auto it = make_iterator(leaf, pos);
+
+        if (it != end_iterator() && !m_cmp(k, KeyOfValue()(*it)))
+        {
+            return { it, true };
+        }
+
+        return { iterator(leaf, pos), false };
+    }
+
+    // Find the position to insert k for multi-key tree, after all equivalent elements.
+    template <typename K>
+    iterator find_insert_multi_pos(const K& k)
+    {
+        if (!m_root)
+        {
+            return iterator();
+        }
+
+        auto leaf = find_leaf<true>(k);
+        return iterator(leaf, upper_bound_in_leaf(leaf, k));
+    }
+
+    template <typename Arg>
+    std::pair<iterator, bool> insert_unique(Arg&& arg)
+    {
+        auto [pos, exists] = find_insert_unique_pos(KeyOfValue()(arg));
+        return exists
+             ? std::make_pair(pos, false)
+             : std::make_pair(insert_at(pos, (Arg&&)arg), true);
+    }
+
+    /**
+     * @brief: Construct element at pos which is returned by find_insert_unique_pos
+     *  or find_insert_multi_pos.
+    */
+    template <typename... Args>
+    iterator insert_at(iterator pos, Args&&... args)
+    {
+        auto [leaf, i] = pos;
+
+        if (!leaf)
+        {
+            leaf = create_leaf();
+
+            try
+            {
+                construct_value(leaf->slot_ptr(0), (Args&&)args...);
+            }
+            catch (...)
+            {
+                deallocate_leaf(leaf);
+                throw;
+            }
+
+            leaf->m_count = 1;
+            m_root = m_first = m_last = leaf;
+            m_size = 1;
+            return iterator(leaf, 0);
+        }
+
+        if (leaf->m_count == Capacity)
+        {
+            std::tie(leaf, i) = split_leaf(leaf, i);
+        }
+
+        open_gap(leaf, i);
+
+        try
+        {
+            construct_value(leaf->slot_ptr(i), (Args&&)args...);
+        }
+        catch (...)
+        {
+            close_gap(leaf, i);
+            throw;
+        }
+
+        ++m_size;
+        return iterator(leaf, i);
+    }
+
+    template <typename K>
+    size_type erase_by_key(const K& x)
+    {
+        if constexpr (UniqueKey)
+        {
+            auto it = this->find(x);
+
+            if (it != end())
+            {
+                erase(it);
+                return 1;
+            }
+
+            return 0;
+        }
+        else
+        {
+            // All iterators are invalidated after erasing, so count first.
+            auto first = lower_bound_impl(x);
+            size_type cnt = 0;
+
+            for (auto it = first; it != end_iterator() && !m_cmp(x, KeyOfValue()(*it)); ++it, ++cnt);
+
+            for (size_type i = 0; i < cnt; ++i)
+            {
+                first = erase_at(first.m_leaf, first.m_pos);
+            }
+
+            return cnt;
+        }
+    }
+
+    // Node helpers
+    leaf_node* create_leaf()
+    {
+        auto leaf = ::new (detail::allocate<leaf_node>(m_alloc, 1)) leaf_node;
+        leaf->m_parent = nullptr;
+        leaf->m_position = 0;
+        leaf->m_count = 0;
+        leaf->m_leaf = true;
+        leaf->m_prev = leaf->m_next = nullptr;
+        return leaf;
+    }
+
+    internal_node* create_internal()
+    {
+        auto node = ::new (detail::allocate<internal_node>(m_alloc, 1)) internal_node;
+        node->m_parent = nullptr;
+        node->m_position = 0;
+        node->m_count = 0;
+        node->m_leaf = false;
+        return node;
+    }
+
+    void deallocate_leaf(leaf_node* leaf)
+    {
+        detail::deallocate(m_alloc, leaf, 1);
+    }
+
+    void deallocate_internal(internal_node* node)
+    {
+        detail::deallocate(m_alloc, node, 1);
+    }
+
+    template <typename... Args>
+    void construct_value(slot_type* p, Args&&... args)
+    {
+        alloc_traits::construct(m_alloc, p->address(), (Args&&)args...);
+    }
+
+    void destroy_value(slot_type* p)
+    {
+        alloc_traits::destroy(m_alloc, p->stored_element());
+    }
+
+    void destroy_subtree(node_base* x)
+    {
+        if (x->m_leaf)
+        {
+            auto leaf = static_cast<leaf_node*>(x);
+
+            for (std::size_t i = 0; i < leaf->m_count; ++i)
+            {
+                destroy_value(leaf->slot_ptr(i));
+            }
+
+            deallocate_leaf(leaf);
+        }
+        else
+        {
+            auto node = static_cast<internal_node*>(x);
+
+            for (std::size_t i = 0; i <= node->m_count; ++i)
+            {
+                destroy_subtree(node->m_children[i]);
+            }
+
+            std::destroy_n(node->key_ptr(0), node->m_count);
+            deallocate_internal(node);
+        }
+    }
+
+    // Relocate helpers, see the comments at the beginning of the file.
+    static_assert(std::is_nothrow_move_constructible_v<typename slot_type::stored_type>,
+        "Elements are relocated when nodes are shifted, split or merged.");
+
+    void relocate_value(slot_type* from, slot_type* to) noexcept
+    {
+        construct_value(to, std::move(*from->stored_element()));
+        destroy_value(from);
+    }
+
+    // Relocate n elements from src to dst, the ranges may overlap.
+    void relocate_values(leaf_node* src, std::size_t from, leaf_node* dst, std::size_t to, std::size_t n) noexcept
+    {
+        if (src == dst && to > from)
+        {
+            for (std::size_t i = n; i-- > 0; )
+                relocate_value(src->slot_ptr(from + i), dst->slot_ptr(to + i));
+        }
+        else
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                relocate_value(src->slot_ptr(from + i), dst->slot_ptr(to + i));
+        }
+    }
+
+    static void relocate_key(key_type* from, key_type* to) noexcept
+    {
+        std::construct_at(to, std::move(*from));
+        std::destroy_at(from);
+    }
+
+    static void relocate_keys(internal_node* src, std::size_t from, internal_node* dst, std::size_t to, std::size_t n) noexcept
+    {
+        if (src == dst && to > from)
+        {
+            for (std::size_t i = n; i-- > 0; )
+                relocate_key(src->key_ptr(from + i), dst->key_ptr(to + i));
+        }
+        else
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                relocate_key(src->key_ptr(from + i), dst->key_ptr(to + i));
+        }
+    }
+
+    static void set_child(internal_node* node, std::size_t i, node_base* child)
+    {
+        node->m_children[i] = child;
+        child->m_parent = node;
+        child->m_position = static_cast<std::uint16_t>(i);
+    }
+
+    // Move children [from, from + n) of src to [to, to + n) of dst, the ranges may overlap.
+    static void move_children(internal_node* src, std::size_t from, internal_node* dst, std::size_t to, std::size_t n)
+    {
+        if (src == dst && to > from)
+        {
+            for (std::size_t i = n; i-- > 0; )
+                set_child(dst, to + i, src->m_children[from + i]);
+        }
+        else
+        {
+            for (std::size_t i = 0; i < n; ++i)
+                set_child(dst, to + i, src->m_children[from + i]);
+        }
+    }
+
+    // Leave an uninitialized slot at position i of leaf.
+    void open_gap(leaf_node* leaf, std::size_t i) noexcept
+    {
+        relocate_values(leaf, i, leaf, i + 1, leaf->m_count - i);
+        leaf->m_count++;
+    }
+
+    // Remove the uninitialized slot at position i of leaf.
+    void close_gap(leaf_node* leaf, std::size_t i) noexcept
+    {
+        relocate_values(leaf, i + 1, leaf, i, leaf->m_count - i - 1);
+        leaf->m_count--;
+    }
+
+    /**
+     * @brief: Nodes allocated before splitting, so that splitting never fails
+     *  after the tree is modified.
+    */
+    struct spare_nodes
+    {
+        btree* m_tree;
+        leaf_node* m_leaf = nullptr;
+        internal_node* m_internals[64] = {};
+        std::size_t m_count = 0;
+
+        spare_nodes(btree* tree, std::size_t internals) : m_tree(tree)
+        {
+            try
+            {
+                m_leaf = m_tree->create_leaf();
+
+                for (; m_count < internals; ++m_count)
+                {
+                    m_internals[m_count] = m_tree->create_internal();
+                }
+            }
+            catch (...)
+            {
+                release();
+                throw;
+            }
+        }
+
+        spare_nodes(const spare_nodes&) = delete;
+
+        internal_node* pop_internal()
+        {
+            assert(m_count > 0);
+            return std::exchange(m_internals[--m_count], nullptr);
+        }
+
+        ~spare_nodes()
+        {
+            release();
+        }
+
+        void release()
+        {
+            if (m_leaf)
+            {
+                m_tree->deallocate_leaf(m_leaf);
+            }
+
+            while (m_count)
+            {
+                m_tree->deallocate_internal(pop_internal());
+            }
+        }
+    };
+
+    /**
+     * @brief: Split the full leaf into two leaves.
+     * @return: The leaf and position where the element of position i should be inserted.
+    */
+    std::pair<leaf_node*, std::size_t> split_leaf(leaf_node* leaf, std::size_t i)
+    {
+        // Each full ancestor will be split, and a new root is needed if all of them are full.
+        std::size_t internals = 0;
+
+        for (auto p = leaf->m_parent; ; p = p->m_parent, ++internals)
+        {
+            if (!p)
+            {
+                ++internals;
+                break;
+            }
+
+            if (p->m_count < Capacity)
+            {
+                break;
+            }
+        }
+
+        spare_nodes spare(this, internals);
+
+        // Keep position mid in left leaf, so the first element of right
+        // leaf is always an existing element and can be used as separator.
+        constexpr std::size_t mid = Capacity / 2;
+        key_type separator = keys(leaf, mid);
+
+        // The tree is modified from here and nothing will throw.
+        auto right = std::exchange(spare.m_leaf, nullptr);
+
+        relocate_values(leaf, mid, right, 0, Capacity - mid);
+        leaf->m_count = mid;
+        right->m_count = Capacity - mid;
+
+        right->m_prev = leaf;
+        right->m_next = leaf->m_next;
+        (leaf->m_next ? leaf->m_next->m_prev : m_last) = right;
+        leaf->m_next = right;
+
+        insert_into_parent(leaf, std::move(separator), right, spare);
+
+        return i <= mid ? std::make_pair(leaf, i) : std::make_pair(right, i - mid);
+    }
+
+    /**
+     * @brief: Insert separator and right after left in the parent of left.
+    */
+    void insert_into_parent(node_base* left, key_type&& separator, node_base* right, spare_nodes& spare) noexcept
+    {
+        auto parent = left->m_parent;
+
+        if (!parent)
+        {
+            auto root = spare.pop_internal();
+            std::construct_at(root->key_ptr(0), std::move(separator));
+            root->m_count = 1;
+            set_child(root, 0, left);
+            set_child(root, 1, right);
+            m_root = root;
+            return;
+        }
+
+        const std::size_t idx = left->m_position;
+
+        if (parent->m_count < Capacity)
+        {
+            relocate_keys(parent, idx, parent, idx + 1, parent->m_count - idx);
+            move_children(parent, idx + 1, parent, idx + 2, parent->m_count - idx);
+            std::construct_at(parent->key_ptr(idx), std::move(separator));
+            set_child(parent, idx + 1, right);
+            parent->m_count++;
+            return;
+        }
+
+        // Split parent, the keys [0, mid) are kept in parent and [mid + 1, Capacity)
+        // are moved to sibling, the key at mid is moved up.
+        constexpr std::size_t mid = Capacity / 2;
+        auto sibling = spare.pop_internal();
+
+        if (idx == mid)
+        {
+            // The new separator is exactly the middle one, move it up.
+            relocate_keys(parent, mid, sibling, 0, Capacity - mid);
+            set_child(sibling, 0, right);
+            move_children(parent, mid + 1, sibling, 1, Capacity - mid);
+            parent->m_count = mid;
+            sibling->m_count = Capacity - mid;
+            insert_into_parent(parent, std::move(separator), sibling, spare);
+            return;
+        }
+
+        key_type promoted = std::move(parent->key(mid));
+        std::destroy_at(parent->key_ptr(mid));
+
+        relocate_keys(parent, mid + 1, sibling, 0, Capacity - mid - 1);
+        move_children(parent, mid + 1, sibling, 0, Capacity - mid);
+        parent->m_count = mid;
+        sibling->m_count = Capacity - mid - 1;
+
+        // Insert separator into the half which contains left.
+        auto [node, j] = idx < mid ? std::make_pair(parent, idx) : std::make_pair(sibling, idx - mid - 1);
+
+        relocate_keys(node, j, node, j + 1, node->m_count - j);
+        move_children(node, j + 1, node, j + 2, node->m_count - j);
+        std::construct_at(node->key_ptr(j), std::move(separator));
+        set_child(node, j + 1, right);
+        node->m_count++;
+
+        insert_into_parent(parent, std::move(promoted), sibling, spare);
+    }
+
+    /**
+     * @brief: Remove the key at idx and the child at idx + 1 of node, the key
+     *  should be relocated or destroyed already.
+    */
+    static void remove_from_internal(internal_node* node, std::size_t idx) noexcept
+    {
+        relocate_keys(node, idx + 1, node, idx, node->m_count - idx - 1);
+        move_children(node, idx + 2, node, idx + 1, node->m_count - idx - 1);
+        node->m_count--;
+    }
+
+    iterator erase_at(leaf_node* leaf, std::size_t pos)
+    {
+        destroy_value(leaf->slot_ptr(pos));
+        close_gap(leaf, pos);
+        --m_size;
+
+        if (leaf == m_root)
+        {
+            if (leaf->m_count == 0)
+            {
+                deallocate_leaf(leaf);
+                m_root = m_first = m_last = nullptr;
+                return iterator();
+            }
+
+            return make_iterator(leaf, pos);
+        }
+
+        if (leaf->m_count >= MinCount)
+        {
+            return make_iterator(leaf, pos);
+        }
+
+        auto parent = leaf->m_parent;
+        const std::size_t idx = leaf->m_position;
+        auto left = idx > 0 ? static_cast<leaf_node*>(parent->m_children[idx - 1]) : nullptr;
+        auto right = idx < parent->m_count ? static_cast<leaf_node*>(parent->m_children[idx + 1]) : nullptr;
+
+        // The new separator is copied before moving elements, so the
+        // tree is still valid if copying throws.
+        if (left && left->m_count > MinCount)
+        {
+            // Move the last element of left to the front of leaf.
+            key_type separator = keys(left, left->m_count - 1);
+            open_gap(leaf, 0);
+            relocate_value(left->slot_ptr(left->m_count - 1), leaf->slot_ptr(0));
+            left->m_count--;
+            parent->key(idx - 1) = std::move(separator);
+            return make_iterator(leaf, pos + 1);
+        }
+
+        if (right && right->m_count > MinCount)
+        {
+            // Move the first element of right to the back of leaf.
+            key_type separator = keys(right, 1);
+            relocate_value(right->slot_ptr(0), leaf->slot_ptr(leaf->m_count));
+            leaf->m_count++;
+            close_gap(right, 0);
+            parent->key(idx) = std::move(separator);
+            return make_iterator(leaf, pos);
+        }
+
+        if (left)
+        {
+            const auto new_pos = left->m_count + pos;
+            merge_leaf(left, leaf);
+            rebalance_internal(parent);
+            return make_iterator(left, new_pos);
+        }
+        else
+        {
+            merge_leaf(leaf, right);
+            rebalance_internal(parent);
+            return make_iterator(leaf, pos);
+        }
+    }
+
+    // Move all elements of right into left and remove right from tree.
+    void merge_leaf(leaf_node* left, leaf_node* right) noexcept
+    {
+        auto parent = left->m_parent;
+        const std::size_t idx = left->m_position;
+
+        relocate_values(right, 0, left, left->m_count, right->m_count);
+        left->m_count += right->m_count;
+
+        left->m_next = right->m_next;
+        (right->m_next ? right->m_next->m_prev : m_last) = left;
+
+        std::destroy_at(parent->key_ptr(idx));
+        remove_from_internal(parent, idx);
+        deallocate_leaf(right);
+    }
+
+    // Move the separator and all keys and children of right into left and remove right from tree.
+    void merge_internal(internal_node* left, internal_node* right) noexcept
+    {
+        auto parent = left->m_parent;
+        const std::size_t idx = left->m_position;
+        const std::size_t n = left->m_count;
+
+        relocate_key(parent->key_ptr(idx), left->key_ptr(n));
+        relocate_keys(right, 0, left, n + 1, right->m_count);
+        move_children(right, 0, left, n + 1, right->m_count + 1);
+        left->m_count += right->m_count + 1;
+
+        remove_from_internal(parent, idx);
+        deallocate_internal(right);
+    }
+
+    void rebalance_internal(internal_node* node) noexcept
+    {
+        while (true)
+        {
+            if (node == m_root)
+            {
+                if (node->m_count == 0)
+                {
+                    // Root has only one child, the tree becomes lower.
+                    auto child = node->m_children[0];
+                    child->m_parent = nullptr;
+                    child->m_position = 0;
+                    m_root = child;
+                    deallocate_internal(node);
+                }
+                return;
+            }
+
+            if (node->m_count >= MinCount)
+            {
+                return;
+            }
+
+            auto parent = node->m_parent;
+            const std::size_t idx = node->m_position;
+            auto left = idx > 0 ? static_cast<internal_node*>(parent->m_children[idx - 1]) : nullptr;
+            auto right = idx < parent->m_count ? static_cast<internal_node*>(parent->m_children[idx + 1]) : nullptr;
+
+            if (left && left->m_count > MinCount)
+            {
+                // Rotate right: separator moves down to node and the last key of left moves up.
+                const std::size_t n = left->m_count;
+                relocate_keys(node, 0, node, 1, node->m_count);
+                move_children(node, 0, node, 1, node->m_count + 1);
+                relocate_key(parent->key_ptr(idx - 1), node->key_ptr(0));
+                relocate_key(left->key_ptr(n - 1), parent->key_ptr(idx - 1));
+                set_child(node, 0, left->m_children[n]);
+                left->m_count--;
+                node->m_count++;
+                return;
+            }
+
+            if (right && right->m_count > MinCount)
+            {
+                // Rotate left: separator moves down to node and the first key of right moves up.
+                const std::size_t n = node->m_count;
+                relocate_key(parent->key_ptr(idx), node->key_ptr(n));
+                set_child(node, n + 1, right->m_children[0]);
+                relocate_key(right->key_ptr(0), parent->key_ptr(idx));
+                relocate_keys(right, 1, right, 0, right->m_count - 1);
+                move_children(right, 1, right, 0, right->m_count);
+                right->m_count--;
+                node->m_count++;
+                return;
+            }
+
+            left ? merge_internal(left, node) : merge_internal(node, right);
+            node = parent;
+        }
+    }
+
+    /**
+     * @brief: Build the tree from n sorted elements starting from first.
+     *
+     * Leaves are filled as full as possible and then the internal levels are built
+     * bottom-up, so it takes O(n) time. The tree should be empty. If an exception is
+     * thrown, the tree is still empty.
+    */
+    template <typename I, typename Fn>
+    void build_from_sorted(I first, std::size_t n, Fn fn)
+    {
+        assert(empty());
+
+        if (n == 0)
+        {
+            return;
+        }
+
+        using node_vector = std::vector<node_base*, typename alloc_traits::template rebind_alloc<node_base*>>;
+
+        // Subtrees which are built but not linked to parents.
+        node_vector level(m_alloc), next(m_alloc);
+
+        struct guard
+        {
+            btree* m_tree;
+            node_vector* m_level;
+            node_vector* m_next;
+            std::size_t m_consumed = 0;
+
+            ~guard()
+            {
+                if (m_tree)
+                {
+                    for (std::size_t i = m_consumed; i < m_level->size(); ++i)
+                        m_tree->destroy_subtree((*m_level)[i]);
+
+                    for (auto x : *m_next)
+                        m_tree->destroy_subtree(x);
+                }
+            }
+        } g { this, &level, &next };
+
+        // Build leaves, the sizes of leaves differ by at most one.
+        const auto leaves = (n + Capacity - 1) / Capacity;
+        level.reserve(leaves);
+
+        leaf_node* head = nullptr;
+        leaf_node* prev = nullptr;
+
+        for (std::size_t i = 0; i < leaves; ++i)
+        {
+            const auto count = n / leaves + (i < n % leaves);
+            auto leaf = create_leaf();
+            level.push_back(leaf);
+
+            leaf->m_prev = prev;
+            (prev ? prev->m_next : head) = leaf;
+            prev = leaf;
+
+            for (; leaf->m_count < count; ++first)
+            {
+                construct_value(leaf->slot_ptr(leaf->m_count), fn(*first));
+                leaf->m_count++;
+            }
+        }
+
+        // Build internal levels until there is only one node.
+        while (level.size() > 1)
+        {
+            const auto nodes = (level.size() + Capacity) / (Capacity + 1);
+            next.reserve(nodes);
+
+            for (std::size_t i = 0; i < nodes; ++i)
+            {
+                const auto children = level.size() / nodes + (i < level.size() % nodes);
+                auto node = create_internal();
+
+                // The separator of each child is the minimum key of its subtree.
+                try
+                {
+                    for (std::size_t j = 1; j < children; ++j)
+                    {
+                        std::construct_at(node->key_ptr(j - 1), minimum_key(level[g.m_consumed + j]));
+                        node->m_count++;
+                    }
+                }
+                catch (...)
+                {
+                    std::destroy_n(node->key_ptr(0), node->m_count);
+                    deallocate_internal(node);
+                    throw;
+                }
+
+                for (std::size_t j = 0; j < children; ++j)
+                {
+                    set_child(node, j, level[g.m_consumed + j]);
+                }
+
+                g.m_consumed += children;
+                next.push_back(node);
+            }
+
+            level.swap(next);
+            next.clear();
+            g.m_consumed = 0;
+        }
+
+        m_root = level.front();
+        m_root->m_parent = nullptr;
+        m_first = head;
+        m_last = prev;
+        m_size = n;
+        g.m_tree = nullptr;
+    }
+
+    static const key_type& minimum_key(node_base* x)
+    {
+        while (!x->m_leaf)
+        {
+            x = static_cast<internal_node*>(x)->m_children[0];
+        }
+        return keys(static_cast<leaf_node*>(x), 0);
+    }
+
+    void steal(btree& other)
+    {
+        m_root = std::exchange(other.m_root, nullptr);
+        m_first = std::exchange(other.m_first, nullptr);
+        m_last = std::exchange(other.m_last, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+    }
+
+    [[no_unique_address]] Compare m_cmp;
+    [[no_unique_address]] Allocator m_alloc;
+    node_base* m_root = nullptr;
+    leaf_node* m_first = nullptr;   // leftmost leaf
+    leaf_node* m_last = nullptr;    // rightmost leaf
+    size_type m_size = 0;
+};
+
+/**
+ * @brief B+ tree-based map, see associative_tree.
+*/
+template <typename KeyOfValue, typename Compare, typename Allocator, bool UniqueKey,
+    std::size_t Capacity = detail::btree_node_capacity<typename KeyOfValue::value_type>>
+class associative_btree : public btree<KeyOfValue, Compare, Allocator, UniqueKey, Capacity>
+{
+    using base = btree<KeyOfValue, Compare, Allocator, UniqueKey, Capacity>;
+
+    template <typename U>
+    using key_arg_t = base::template key_arg_t<U>;
+
+public:
+
+    using base::base;
+    using base::operator=;
+    using typename base::value_type;
+    using typename base::key_type;
+    using typename base::iterator;
+    using typename base::const_iterator;
+    using mapped_type = typename KeyOfValue::mapped_type;
+
+    struct value_compare : ordered_map_container_value_compare<value_type, Compare>
+    {
+    protected:
+        friend class associative_btree;
+
+        value_compare(Compare compare) : ordered_map_container_value_compare<value_type, Compare>(compare) { }
+    };
+
+    value_compare value_comp() const
+    {
+        return value_compare(this->m_cmp);
+    }
+
+    using base::insert;
+
+    template <std::convertible_to<value_type> PairLike>
+    auto insert(PairLike&& value)
+    {
+        return this->emplace((PairLike&&) value);
+    }
+
+    template <std::convertible_to<value_type> PairLike>
+    iterator insert(const_iterator pos, PairLike&& value)
+    {
+        return this->emplace_hint(pos, (PairLike&&) value);
+    }
+
+    // map::operator[]
+    mapped_type& operator[](const key_type& key) requires (UniqueKey)
+    {
+        return try_emplace_impl(key).first->second;
+    }
+
+    mapped_type& operator[](key_type&& key) requires (UniqueKey)
+    {
+        return try_emplace_impl(std::move(key)).first->second;
+    }
+
+    template <typename KK>
+        requires (detail::transparent<Compare> && UniqueKey)
+    mapped_type& operator[](KK&& x)
+    {
+        return try_emplace_impl((KK&&)x).first->second;
+    }
+
+    // map::at
+    template <typename Key = key_type>
+        requires (UniqueKey)
+    mapped_type& at(const key_arg_t<Key>& x)
+    {
+        auto it = this->find(x);
+        return it != this->end() ?
+               it->second : throw std::out_of_range("The container does not have an element with the specified key.");
+    }
+
+    template <typename Key = key_type>
+        requires (UniqueKey)
+    const mapped_type& at(const key_arg_t<Key>& x) const
+    {
+        return const_cast<associative_btree*>(this)->at(x);
+    }
+
+    // map::try_emplace
+    template <typename... Args>
+        requires (UniqueKey)
+    std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args)
+    {
+        return try_emplace_impl(key, (Args&&)args...);
+    }
+
+    template <typename... Args>
+        requires (UniqueKey)
+    std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args)
+    {
+        return try_emplace_impl(std::move(key), (Args&&)args...);
+    }
+
+    template <typename... Args>
+        requires (UniqueKey)
+    iterator try_emplace(const_iterator hint, const key_type& key, Args&&... args)
+    {
+        return try_emplace(key, (Args&&)args...).first;
+    }
+
+    template <typename... Args>
+        requires (UniqueKey)
+    iterator try_emplace(const_iterator hint, key_type&& key, Args&&... args)
+    {
+        return try_emplace(std::move(key), (Args&&)args...).first;
+    }
+
+    template <typename KK, typename... Args>
+        requires (detail::transparent<Compare> &&
+                 !std::is_convertible_v<KK, iterator> &&
+                 !std::is_convertible_v<KK, const_iterator> &&
+                  UniqueKey)
+    std::pair<iterator, bool> try_emplace(KK&& key, Args&&... args)
+    {
+        return try_emplace_impl((KK&&)key, (Args&&)args...);
+    }
+
+    // map::insert_or_assign
+    template <typename M>
+        requires (UniqueKey)
+    std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj)
+    {
+        return insert_or_assign_impl(key, (M&&)obj);
+    }
+
+    template <typename M>
+        requires (UniqueKey)
+    std::pair<iterator, bool> insert_or_assign(key_type&& key, M&& obj)
+    {
+        return insert_or_assign_impl(std::move(key), (M&&)obj);
+    }
+
+    template <typename M>
+        requires (UniqueKey)
+    iterator insert_or_assign(const_iterator hint, const key_type& key, M&& obj)
+    {
+        return insert_or_assign(key, (M&&)obj).first;
+    }
+
+    template <typename M>
+        requires (UniqueKey)
+    iterator insert_or_assign(const_iterator hint, key_type&& key, M&& obj)
+    {
+        return insert_or_assign(std::move(key), (M&&)obj).first;
+    }
+
+    template <typename KK, typename M>
+        requires (detail::transparent<Compare> &&
+                 !std::is_convertible_v<KK, iterator> &&
+                 !std::is_convertible_v<KK, const_iterator> &&
+                  UniqueKey)
+    std::pair<iterator, bool> insert_or_assign(KK&& key, M&& obj)
+    {
+        return insert_or_assign_impl((KK&&)key, (M&&)obj);
+    }
+
+protected:
+
+    template <typename KK, typename M>
+    std::pair<iterator, bool> insert_or_assign_impl(KK&& k, M&& obj)
+    {
+        auto [pos, exists] = this->find_insert_unique_pos(k);
+
+        if (exists)
+        {
+            pos->second = (M&&)obj;
+            return { pos, false };
+        }
+
+        return { this->insert_at(pos, (KK&&)k, (M&&)obj), true };
+    }
+
+    template <typename KK, typename... Args>
+    std::pair<iterator, bool> try_emplace_impl(KK&& k, Args&&... args)
+    {
+        auto [pos, exists] = this->find_insert_unique_pos(k);
+
+        if (exists)
+        {
+            return { pos, false };
+        }
+
+        auto it = this->insert_at(pos,
+            std::piecewise_construct,
+            std::forward_as_tuple((KK&&)k),
+            std::forward_as_tuple((Args&&)args...));
+        return { it, true };
+    }
+};
+
+template <typename T, typename Compare = std::less<>, typename Allocator = std::allocator<T>>
+using btree_set = btree<identity<T>, Compare, Allocator, true>;
+
+template <typename T, typename Compare = std::less<>, typename Allocator = std::allocator<T>>
+using btree_multiset = btree<identity<T>, Compare, Allocator, false>;
+
+template <typename K, typename V, typename Compare = std::less<>, typename Allocator = std::allocator<std::pair<const K, V>>>
+using btree_map = associative_btree<select1st<K, V>, Compare, Allocator, true>;
+
+template <typename K, typename V, typename Compare = std::less<>, typename Allocator = std::allocator<std::pair<const K, V>>>
+using btree_multimap = associative_btree<select1st<K, V>, Compare, Allocator, false>;
+
+} // namespace cpp::collections
+
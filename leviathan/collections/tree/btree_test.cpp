@@ -0,0 +1,324 @@
+#include <catch2/catch_all.hpp>
+
+#include "btree.hpp"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <ranges>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace cpp::collections;
+
+// Small nodes make the tree deep enough to test splitting and merging.
+template <typename T, bool Unique>
+using SmallBTree = btree<::identity<T>, std::less<>, std::allocator<T>, Unique, 4>;
+
+template <typename BTree, typename StdSet>
+void check_same(const BTree& bt, const StdSet& s)
+{
+    REQUIRE(bt.size() == s.size());
+    REQUIRE(std::ranges::equal(bt, s));
+    REQUIRE(std::ranges::equal(bt | std::views::reverse, s | std::views::reverse));
+}
+
+template <typename BTree, typename StdSet>
+void random_test(int n, int range)
+{
+    BTree bt;
+    StdSet s;
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, range);
+
+    for (int i = 0; i < n; ++i)
+    {
+        auto x = dist(gen);
+        bt.insert(x);
+        s.insert(x);
+    }
+
+    check_same(bt, s);
+
+    for (int i = 0; i < n; ++i)
+    {
+        auto x = dist(gen);
+        REQUIRE(bt.contains(x) == s.contains(x));
+        REQUIRE(bt.count(x) == s.count(x));
+        REQUIRE(bt.lower_bound(x) == bt.end() ? s.lower_bound(x) == s.end() : *bt.lower_bound(x) == *s.lower_bound(x));
+        REQUIRE(bt.upper_bound(x) == bt.end() ? s.upper_bound(x) == s.end() : *bt.upper_bound(x) == *s.upper_bound(x));
+    }
+
+    for (int i = 0; i < n; ++i)
+    {
+        auto x = dist(gen);
+        REQUIRE(bt.erase(x) == s.erase(x));
+    }
+
+    check_same(bt, s);
+
+    // Erase by iterator and check the returned iterator.
+    while (!s.empty())
+    {
+        auto x = dist(gen);
+        auto it1 = bt.lower_bound(x);
+        auto it2 = s.lower_bound(x);
+
+        if (it2 == s.end())
+        {
+            it1 = bt.begin();
+            it2 = s.begin();
+        }
+
+        it1 = bt.erase(it1);
+        it2 = s.erase(it2);
+
+        REQUIRE((it1 == bt.end()) == (it2 == s.end()));
+
+        if (it2 != s.end())
+        {
+            REQUIRE(*it1 == *it2);
+        }
+    }
+
+    REQUIRE(bt.empty());
+    REQUIRE(bt.begin() == bt.end());
+    REQUIRE(bt.height() == 0);
+}
+
+TEST_CASE("btree random insert and erase")
+{
+    random_test<SmallBTree<int, true>, std::set<int>>(10000, 5000);
+    random_test<SmallBTree<int, false>, std::multiset<int>>(10000, 1000);
+    random_test<btree_set<int>, std::set<int>>(100000, 50000);
+    random_test<btree_multiset<int>, std::multiset<int>>(100000, 1000);
+}
+
+TEST_CASE("btree height")
+{
+    btree_set<int> bt;
+
+    for (int i = 0; i < 100000; ++i)
+    {
+        bt.insert(i);
+    }
+
+    REQUIRE(bt.height() <= 5);
+
+    SmallBTree<int, true> small;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        small.insert(i);
+    }
+
+    REQUIRE(small.height() > 1);
+}
+
+TEST_CASE("btree string")
+{
+    btree_set<std::string> bt;
+    std::set<std::string> s;
+
+    for (int i = 0; i < 5000; ++i)
+    {
+        auto str = std::to_string(i * 7919 % 5000);
+        bt.emplace(str);
+        s.emplace(str);
+    }
+
+    check_same(bt, s);
+
+    // Transparent lookup.
+    REQUIRE(bt.contains("42"));
+    REQUIRE(bt.find(std::string_view("4999")) != bt.end());
+
+    for (int i = 0; i < 5000; i += 3)
+    {
+        auto str = std::to_string(i);
+        bt.erase(str);
+        s.erase(str);
+    }
+
+    check_same(bt, s);
+}
+
+TEST_CASE("btree range erase")
+{
+    SmallBTree<int, false> bt;
+    std::multiset<int> s;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        bt.insert(i % 100);
+        s.insert(i % 100);
+    }
+
+    auto it = bt.erase(bt.lower_bound(10), bt.upper_bound(50));
+    s.erase(s.lower_bound(10), s.upper_bound(50));
+
+    REQUIRE(*it == 51);
+    check_same(bt, s);
+
+    bt.erase(bt.begin(), bt.end());
+    REQUIRE(bt.empty());
+}
+
+TEST_CASE("btree copy move and swap")
+{
+    SmallBTree<std::string, true> bt;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        bt.insert(std::to_string(i));
+    }
+
+    auto copy = bt;
+    REQUIRE(copy == bt);
+    REQUIRE(copy.size() == 1000);
+
+    // The copied tree can be modified independently.
+    copy.erase("10");
+    copy.insert("abc");
+    REQUIRE(!copy.contains("10"));
+    REQUIRE(bt.contains("10"));
+    REQUIRE(bt.size() == 1000);
+
+    auto moved = std::move(copy);
+    REQUIRE(copy.empty());
+    REQUIRE(moved.size() == 1000);
+    REQUIRE(moved.contains("abc"));
+
+    swap(moved, bt);
+    REQUIRE(bt.contains("abc"));
+    REQUIRE(moved.contains("10"));
+
+    bt = moved;
+    REQUIRE(bt == moved);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        REQUIRE(bt.erase(std::to_string(i)) == 1);
+    }
+
+    REQUIRE(bt.empty());
+}
+
+TEST_CASE("btree merge")
+{
+    btree_set<int> s1 = { 1, 3, 5, 7 };
+    btree_set<int> s2 = { 1, 2, 3, 4 };
+
+    s1.merge(s2);
+
+    REQUIRE(std::ranges::equal(s1, std::vector{ 1, 2, 3, 4, 5, 7 }));
+    REQUIRE(std::ranges::equal(s2, std::vector{ 1, 3 }));
+
+    btree_multiset<int> s3 = { 1, 1, 2 };
+    btree_multiset<int> s4 = { 1, 2, 3 };
+
+    s3.merge(s4);
+
+    REQUIRE(std::ranges::equal(s3, std::vector{ 1, 1, 1, 2, 2, 3 }));
+    REQUIRE(s4.empty());
+}
+
+TEST_CASE("btree map")
+{
+    btree_map<int, std::string> bt;
+    std::map<int, std::string> m;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto k = i * 37 % 1000;
+        bt[k] = std::to_string(i);
+        m[k] = std::to_string(i);
+    }
+
+    REQUIRE(std::ranges::equal(bt, m));
+
+    REQUIRE(bt.at(37) == m.at(37));
+    CHECK_THROWS_AS(bt.at(1000), std::out_of_range);
+
+    auto [it1, ok1] = bt.try_emplace(1, "x");
+    REQUIRE(!ok1);
+    REQUIRE(it1->second == m[1]);
+
+    auto [it2, ok2] = bt.try_emplace(1000, "x");
+    REQUIRE(ok2);
+    REQUIRE(it2->second == "x");
+
+    auto [it3, ok3] = bt.insert_or_assign(1, "y");
+    REQUIRE(!ok3);
+    REQUIRE(bt[1] == "y");
+
+    auto [it4, ok4] = bt.insert(std::make_pair(1001, "z"));
+    REQUIRE(ok4);
+    REQUIRE(it4->first == 1001);
+    REQUIRE(bt.size() == 1002);
+
+    btree_multimap<int, int> mm;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        mm.emplace(i % 10, i);
+    }
+
+    REQUIRE(mm.count(3) == 10);
+
+    // Equivalent elements are kept in insertion order.
+    auto [first, last] = mm.equal_range(3);
+    REQUIRE(std::ranges::equal(std::ranges::subrange(first, last) | std::views::values, std::vector{ 3, 13, 23, 33, 43, 53, 63, 73, 83, 93 }));
+
+    REQUIRE(mm.erase(3) == 10);
+    REQUIRE(mm.size() == 90);
+}
+
+struct copy_counted_key
+{
+    inline static int copies = 0;
+
+    int m_value;
+
+    copy_counted_key(int value) : m_value(value) { }
+
+    copy_counted_key(const copy_counted_key& other) : m_value(other.m_value) { ++copies; }
+
+    copy_counted_key(copy_counted_key&&) noexcept = default;
+
+    copy_counted_key& operator=(const copy_counted_key&) = default;
+
+    copy_counted_key& operator=(copy_counted_key&&) noexcept = default;
+
+    auto operator<=>(const copy_counted_key&) const = default;
+};
+
+static_assert(detail::btree_slot<std::pair<const copy_counted_key, std::string>>::mutable_keys);
+
+TEST_CASE("btree map moves keys when relocating")
+{
+    constexpr int N = 10000;
+
+    btree_map<copy_counted_key, std::string> bt;
+
+    for (int i = 0; i < N; ++i)
+    {
+        bt.emplace(copy_counted_key(i * 7919 % N), std::to_string(i));
+    }
+
+    // Each key is copied out of the emplaced value once and separators of
+    // internal nodes are copies. Before the keys were moved, every shifted slot
+    // copied its key as well.
+    CHECK(copy_counted_key::copies < 2 * N);
+
+    for (int i = 0; i < N; i += 2)
+    {
+        bt.erase(copy_counted_key(i));
+    }
+
+    REQUIRE(bt.size() == N / 2);
+    REQUIRE(std::ranges::is_sorted(bt, {}, [](const auto& kv) { return kv.first; }));
+    REQUIRE(bt.begin()->first.m_value == 1);
+}
@@ -0,0 +1,748 @@
+/**
+ * A persistent(immutable) AVL tree.
+ *
+ * Each persistent_tree is a version of the tree. The nodes are shared between
+ * versions and reference counted, so copying a tree is O(1) and never copies
+ * any element. insert/erase copy the O(log(n)) nodes on the path from the root
+ * to the modified node(path copying) and all the other versions are unchanged.
+ *
+ * - A node whose reference count is one is only reachable from the version we are
+ *   modifying, so it is modified in place instead of copied. Modifying a tree
+ *   which shares nothing with other versions allocates nothing but the new node.
+ * - The nodes have no parent pointer since a shared node has more than one parent,
+ *   so the rebalancing is done recursively on the path and the iterator keeps
+ *   the path from the root.
+ * - The elements are immutable, iterator and const_iterator are the same type.
+ * - The shared nodes which will be modified are copied before the tree is changed,
+ *   so if copying an element throws, the tree keeps its elements and only some
+ *   of its nodes are no longer shared with other versions.
+ *
+ * Thread safety:
+ * - The reference counts are atomic, different versions can be read, modified
+ *   and destroyed by different threads at the same time without synchronization.
+ * - A version itself is not synchronized. A writer can publish a snapshot by
+ *   copying its tree and readers can traverse the snapshot while the writer keeps
+ *   modifying its own version.
+ *
+ * The copies of allocator should be able to deallocate the nodes allocated by each other.
+*/
+#pragma once
+
+#include <leviathan/collections/common.hpp>
+#include <leviathan/collections/container_interface.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace cpp::collections
+{
+
+struct persistent_avl_node
+{
+    // The versions and nodes which link to this node.
+    std::atomic<std::size_t> m_refcount;
+
+    // Left child and right child.
+    persistent_avl_node* m_link[2];
+
+    // 1 for leaf and 0 for nullptr.
+    int m_height;
+
+    void init()
+    {
+        m_refcount.store(1, std::memory_order_relaxed);
+        m_link[0] = m_link[1] = nullptr;
+        m_height = 1;
+    }
+
+    static int height(const persistent_avl_node* node)
+    {
+        return node ? node->m_height : 0;
+    }
+
+    int balance_factor() const
+    {
+        return height(m_link[0]) - height(m_link[1]);
+    }
+
+    void update_height()
+    {
+        m_height = std::max(height(m_link[0]), height(m_link[1])) + 1;
+    }
+};
+
+template <typename KeyOfValue, typename Node>
+struct persistent_tree_iterator
+{
+    // The height of an AVL tree with n nodes is less than 1.45 * log2(n + 2),
+    // a tree of height 64 needs more than 10^13 nodes.
+    static constexpr int max_height = 64;
+
+    using link_type = const persistent_avl_node*;
+    using value_type = typename KeyOfValue::value_type;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::bidirectional_iterator_tag;
+    using reference = const value_type&;
+
+    // The nodes from root to current node, the end iterator has an empty path.
+    link_type m_root = nullptr;
+    std::array<link_type, max_height> m_path;
+    int m_depth = 0;
+
+    constexpr persistent_tree_iterator() = default;
+    constexpr persistent_tree_iterator(const persistent_tree_iterator&) = default;
+    constexpr persistent_tree_iterator(link_type root) : m_root(root) { }
+
+    constexpr persistent_tree_iterator base() const
+    {
+        return *this;
+    }
+
+    constexpr persistent_tree_iterator& operator++()
+    {
+        if (auto x = m_path[m_depth - 1]->m_link[1])
+        {
+            push(x);
+            descend(0);
+        }
+        else
+        {
+            ascend(1);
+        }
+        return *this;
+    }
+
+    constexpr persistent_tree_iterator& operator--()
+    {
+        if (m_depth == 0)
+        {
+            push(m_root);
+            descend(1);
+        }
+        else if (auto x = m_path[m_depth - 1]->m_link[0])
+        {
+            push(x);
+            descend(1);
+        }
+        else
+        {
+            ascend(0);
+        }
+        return *this;
+    }
+
+    constexpr persistent_tree_iterator operator++(int)
+    {
+        persistent_tree_iterator tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    constexpr persistent_tree_iterator operator--(int)
+    {
+        persistent_tree_iterator tmp = *this;
+        --*this;
+        return tmp;
+    }
+
+    constexpr auto operator->() const
+    {
+        return std::addressof(operator*());
+    }
+
+    constexpr reference operator*() const
+    {
+        return *static_cast<const Node*>(m_path[m_depth - 1])->value_ptr();
+    }
+
+    friend constexpr bool operator==(const persistent_tree_iterator& lhs, const persistent_tree_iterator& rhs)
+    {
+        return lhs.m_depth == rhs.m_depth
+            && (lhs.m_depth == 0 || lhs.m_path[lhs.m_depth - 1] == rhs.m_path[rhs.m_depth - 1]);
+    }
+
+    constexpr void push(link_type x)
+    {
+        m_path[m_depth++] = x;
+    }
+
+private:
+
+    // Go to the leftmost(dir = 0) or rightmost(dir = 1) node of current subtree.
+    constexpr void descend(int dir)
+    {
+        for (auto x = m_path[m_depth - 1]->m_link[dir]; x; x = x->m_link[dir])
+        {
+            push(x);
+        }
+    }
+
+    // Pop the nodes until we leave a left(dir = 0) or right(dir = 1) subtree.
+    constexpr void ascend(int dir)
+    {
+        do
+        {
+            --m_depth;
+        } while (m_depth > 0 && m_path[m_depth - 1]->m_link[dir] == m_path[m_depth]);
+    }
+};
+
+/**
+ * @brief Persistent AVL tree with unique keys.
+ *
+ * @param KeyOfValue Extractor extract key from value. identity<T> for set and select1st<K, V> for map.
+ * @param Compare
+ * @param Allocator
+*/
+template <typename KeyOfValue, typename Compare, typename Allocator>
+class persistent_tree : public iterable_interface,
+                        public unique_insert_interface,
+                        public lookup_interface
+{
+public:
+
+    using value_type = typename KeyOfValue::value_type;
+    using key_type = typename KeyOfValue::key_type;
+    using reference = typename KeyOfValue::reference;
+    using const_reference = typename KeyOfValue::const_reference;
+    using size_type = std::size_t;
+    using allocator_type = Allocator;
+    using difference_type = std::ptrdiff_t;
+    using key_compare = Compare;
+    using value_compare = Compare;
+    using pointer = std::allocator_traits<Allocator>::pointer;
+    using const_pointer = std::allocator_traits<Allocator>::const_pointer;
+    using tree_node = value_field<persistent_avl_node, value_type>;
+
+private:
+
+    using node_base = persistent_avl_node;
+    using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<tree_node>;
+
+    template <typename U>
+    using key_arg_t = detail::key_arg<detail::transparent<Compare>, U, key_type>;
+
+public:
+
+    using iterator = persistent_tree_iterator<KeyOfValue, tree_node>;
+    using const_iterator = iterator;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = reverse_iterator;
+
+    persistent_tree(const Compare& compare, const Allocator& allocator)
+        : m_cmp(compare), m_alloc(allocator), m_root(nullptr), m_size(0) { }
+
+    persistent_tree() : persistent_tree(Compare(), Allocator()) { }
+
+    // Share all nodes with other.
+    persistent_tree(const persistent_tree& other)
+        : m_cmp(other.m_cmp), m_alloc(other.m_alloc), m_root(acquire(other.m_root)), m_size(other.m_size) { }
+
+    persistent_tree(persistent_tree&& other) noexcept
+        : m_cmp(other.m_cmp), m_alloc(other.m_alloc),
+          m_root(std::exchange(other.m_root, nullptr)), m_size(std::exchange(other.m_size, 0)) { }
+
+    persistent_tree& operator=(persistent_tree other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+
+    ~persistent_tree()
+    {
+        release(m_root);
+    }
+
+    void swap(persistent_tree& other) noexcept
+    {
+        using std::swap;
+        swap(m_cmp, other.m_cmp);
+        swap(m_alloc, other.m_alloc);
+        swap(m_root, other.m_root);
+        swap(m_size, other.m_size);
+    }
+
+    friend void swap(persistent_tree& lhs, persistent_tree& rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+
+    /**
+     * @brief: Get a snapshot of current version in O(1).
+     *
+     * The snapshot is not affected by the later modification of this tree.
+    */
+    persistent_tree snapshot() const
+    {
+        return *this;
+    }
+
+    // Iterators
+    iterator begin() const
+    {
+        iterator it(m_root);
+
+        for (auto x = m_root; x; x = x->m_link[0])
+        {
+            it.push(x);
+        }
+
+        return it;
+    }
+
+    iterator end() const
+    {
+        return iterator(m_root);
+    }
+
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    allocator_type get_allocator() const
+    {
+        return allocator_type(m_alloc);
+    }
+
+    size_type max_size() const
+    {
+        return std::allocator_traits<node_allocator>::max_size(m_alloc);
+    }
+
+    static KeyOfValue key_of_value()
+    {
+        return KeyOfValue();
+    }
+
+    key_compare key_comp() const
+    {
+        return m_cmp;
+    }
+
+    value_compare value_comp() const
+    {
+        return m_cmp;
+    }
+
+    // Only the nodes which are not shared with other versions are destroyed.
+    void clear()
+    {
+        release(std::exchange(m_root, nullptr));
+        m_size = 0;
+    }
+
+    // Lookup
+    template <typename K = key_type>
+    iterator lower_bound(const key_arg_t<K>& x) const
+    {
+        return find_first([&](const key_type& k) { return m_cmp(k, x); });
+    }
+
+    template <typename K = key_type>
+    iterator upper_bound(const key_arg_t<K>& x) const
+    {
+        return find_first([&](const key_type& k) { return !m_cmp(x, k); });
+    }
+
+    template <typename K = key_type>
+    size_type count(const key_arg_t<K>& x) const
+    {
+        return find_node(x) ? 1 : 0;
+    }
+
+    template <typename K = key_type>
+    bool contains(const key_arg_t<K>& x) const
+    {
+        return find_node(x) != nullptr;
+    }
+
+    // Modifiers
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args)
+    {
+        if constexpr (detail::emplace_helper<value_type, Args...>::value ||
+                      (sizeof...(Args) == 1 && detail::transparent<Compare>))
+        {
+            return insert_unique((Args&&)args...);
+        }
+        else
+        {
+            value_handle<value_type, allocator_type> handle(get_allocator(), (Args&&)args...);
+            return insert_unique(*handle);
+        }
+    }
+
+    using unique_insert_interface::insert;
+
+    size_type erase(const key_type& x)
+    {
+        if (!find_node(x))
+        {
+            return 0;
+        }
+
+        unshare_erase_path(x);
+        m_root = erase_node(m_root, x);
+        --m_size;
+        return 1;
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        const key_type key = key_of(*pos);
+        erase(key);
+        return lower_bound(key);
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        if (first == begin() && last == end())
+        {
+            clear();
+            return end();
+        }
+
+        // Erasing invalidates iterators, so the keys are collected first.
+        std::vector<key_type> keys;
+
+        for (; first != last; ++first)
+        {
+            keys.emplace_back(key_of(*first));
+        }
+
+        if (keys.empty())
+        {
+            return last;
+        }
+
+        for (const auto& key : keys)
+        {
+            erase(key);
+        }
+
+        return upper_bound(keys.back());
+    }
+
+private:
+
+    static const key_type& key_of(const value_type& value)
+    {
+        return KeyOfValue()(value);
+    }
+
+    static const key_type& key_of(const node_base* node)
+    {
+        return key_of(*static_cast<const tree_node*>(node)->value_ptr());
+    }
+
+    template <typename K>
+    const node_base* find_node(const K& x) const
+    {
+        for (auto cur = m_root; cur; )
+        {
+            if (m_cmp(x, key_of(cur)))
+            {
+                cur = cur->m_link[0];
+            }
+            else if (m_cmp(key_of(cur), x))
+            {
+                cur = cur->m_link[1];
+            }
+            else
+            {
+                return cur;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Return the first element whose key does not satisfy pred.
+    template <typename Pred>
+    iterator find_first(Pred pred) const
+    {
+        iterator it(m_root);
+        int depth = 0;
+
+        for (auto cur = m_root; cur; )
+        {
+            it.push(cur);
+
+            if (pred(key_of(cur)))
+            {
+                cur = cur->m_link[1];
+            }
+            else
+            {
+                depth = it.m_depth;
+                cur = cur->m_link[0];
+            }
+        }
+
+        it.m_depth = depth;
+        return it;
+    }
+
+    template <typename U>
+    std::pair<iterator, bool> insert_unique(U&& value)
+    {
+        // value may be a key of other type for transparent comparator.
+        const auto& key = KeyOfValue()(value);
+
+        if (auto node = find_node(key))
+        {
+            return { find_first([&, node](const key_type& k) { return m_cmp(k, key_of(node)); }), false };
+        }
+
+        unshare_insert_path(key);
+        auto node = create_node((U&&)value);
+        m_root = insert_node(m_root, node);
+        ++m_size;
+        return { find_first([&](const key_type& k) { return m_cmp(k, key_of(node)); }), true };
+    }
+
+    // The functions below take over a reference of x and return a reference
+    // of the new subtree. The nodes they modify are uniquely owned, so they
+    // never throw.
+
+    // Insert node into subtree x, the key of node is not in x.
+    node_base* insert_node(node_base* x, node_base* node)
+    {
+        if (!x)
+        {
+            return node;
+        }
+
+        const int dir = m_cmp(key_of(x), key_of(node));
+        x->m_link[dir] = insert_node(x->m_link[dir], node);
+        return rebalance(x);
+    }
+
+    // Erase the node with key in subtree x, the key should be in x.
+    template <typename K>
+    node_base* erase_node(node_base* x, const K& key)
+    {
+        if (m_cmp(key, key_of(x)))
+        {
+            x->m_link[0] = erase_node(x->m_link[0], key);
+            return rebalance(x);
+        }
+
+        if (m_cmp(key_of(x), key))
+        {
+            x->m_link[1] = erase_node(x->m_link[1], key);
+            return rebalance(x);
+        }
+
+        auto left = std::exchange(x->m_link[0], nullptr);
+        auto right = std::exchange(x->m_link[1], nullptr);
+        release(x);
+
+        if (!left || !right)
+        {
+            return left ? left : right;
+        }
+
+        // Replace x with its successor.
+        node_base* successor;
+        right = extract_minimum(right, successor);
+        successor->m_link[0] = left;
+        successor->m_link[1] = right;
+        return rebalance(successor);
+    }
+
+    // Detach the minimum node of subtree x, the node is uniquely owned by caller.
+    node_base* extract_minimum(node_base* x, node_base*& minimum)
+    {
+        if (!x->m_link[0])
+        {
+            minimum = x;
+            return std::exchange(x->m_link[1], nullptr);
+        }
+
+        x->m_link[0] = extract_minimum(x->m_link[0], minimum);
+        return rebalance(x);
+    }
+
+    // x is uniquely owned.
+    node_base* rebalance(node_base* x)
+    {
+        const int factor = x->balance_factor();
+
+        if (factor > 1)
+        {
+            if (x->m_link[0]->balance_factor() < 0)
+            {
+                x->m_link[0] = rotate(x->m_link[0], 0);
+            }
+            return rotate(x, 1);
+        }
+
+        if (factor < -1)
+        {
+            if (x->m_link[1]->balance_factor() > 0)
+            {
+                x->m_link[1] = rotate(x->m_link[1], 1);
+            }
+            return rotate(x, 0);
+        }
+
+        x->update_height();
+        return x;
+    }
+
+    // Rotate left(dir = 0) or right(dir = 1), x and its child are uniquely owned.
+    node_base* rotate(node_base* x, int dir)
+    {
+        auto y = x->m_link[!dir];
+        x->m_link[!dir] = y->m_link[dir];
+        y->m_link[dir] = x;
+        x->update_height();
+        y->update_height();
+        return y;
+    }
+
+    // Copy the shared nodes on the path to key. The insertion only rotates the 
+    // nodes on the path.
+    template <typename K>
+    void unshare_insert_path(const K& key)
+    {
+        for (auto slot = &m_root; *slot; )
+        {
+            auto x = unshare(*slot);
+            slot = &x->m_link[m_cmp(key_of(x), key)];
+        }
+    }
+
+    // Copy the shared nodes on the path to key and its successor, and the nodes
+    // which may be rotated when the subtrees on the path become lower.
+    template <typename K>
+    void unshare_erase_path(const K& key)
+    {
+        auto x = unshare(m_root);
+
+        while (m_cmp(key, key_of(x)) || m_cmp(key_of(x), key))
+        {
+            const int dir = m_cmp(key_of(x), key);
+            unshare_sibling(x, dir);
+            x = unshare(x->m_link[dir]);
+        }
+
+        if (!x->m_link[0] || !x->m_link[1])
+        {
+            return;
+        }
+
+        // x is replaced with the minimum node of its right subtree.
+        unshare_sibling(x, 1);
+
+        for (x = unshare(x->m_link[1]); x->m_link[0]; x = unshare(x->m_link[0]))
+        {
+            unshare_sibling(x, 0);
+        }
+    }
+
+    // A rotation happens at x only if x->m_link[dir] becomes lower and x leans to 
+    // the other side, the sibling and its inner child are rotated.
+    void unshare_sibling(node_base* x, int dir)
+    {
+        if (node_base::height(x->m_link[!dir]) > node_base::height(x->m_link[dir]))
+        {
+            auto sibling = unshare(x->m_link[!dir]);
+
+            if (node_base::height(sibling->m_link[dir]) > node_base::height(sibling->m_link[!dir]))
+            {
+                unshare(sibling->m_link[dir]);
+            }
+        }
+    }
+
+    // Replace the shared node in slot with a copy which shares the children with it.
+    // slot is m_root or a link of a uniquely owned node, the tree is unchanged if
+    // the copy throws.
+    node_base* unshare(node_base*& slot)
+    {
+        auto x = slot;
+
+        if (x->m_refcount.load(std::memory_order_acquire) != 1)
+        {
+            auto copy = create_node(*static_cast<const tree_node*>(x)->value_ptr());
+            copy->m_link[0] = acquire(x->m_link[0]);
+            copy->m_link[1] = acquire(x->m_link[1]);
+            copy->m_height = x->m_height;
+            slot = copy;
+            release(x);
+        }
+
+        return slot;
+    }
+
+    static node_base* acquire(node_base* x)
+    {
+        if (x)
+        {
+            x->m_refcount.fetch_add(1, std::memory_order_relaxed);
+        }
+        return x;
+    }
+
+    // Drop a reference of x, the nodes are destroyed when no one links to them.
+    void release(node_base* x)
+    {
+        if (x && x->m_refcount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            release(x->m_link[0]);
+            release(x->m_link[1]);
+            drop_node(static_cast<tree_node*>(x));
+        }
+    }
+
+    template <typename... Args>
+    tree_node* create_node(Args&&... args)
+    {
+        auto node = allocator_adaptor<node_allocator>::allocate(m_alloc, 1);
+
+        try
+        {
+            node->init();
+            allocator_adaptor<node_allocator>::construct(m_alloc, node->value_ptr(), (Args&&)args...);
+        }
+        catch (...)
+        {
+            allocator_adaptor<node_allocator>::deallocate(m_alloc, node, 1);
+            throw;
+        }
+
+        return node;
+    }
+
+    void drop_node(tree_node* node)
+    {
+        allocator_adaptor<node_allocator>::destroy(m_alloc, node->value_ptr());
+        allocator_adaptor<node_allocator>::deallocate(m_alloc, node, 1);
+    }
+
+    [[no_unique_address]] Compare m_cmp;
+    [[no_unique_address]] node_allocator m_alloc;
+    node_base* m_root;
+    size_type m_size;
+};
+
+template <typename T, typename Compare = std::less<>, typename Allocator = std::allocator<T>>
+using persistent_set = persistent_tree<identity<T>, Compare, Allocator>;
+
+template <typename K, typename V, typename Compare = std::less<>, typename Allocator = std::allocator<std::pair<const K, V>>>
+using persistent_map = persistent_tree<select1st<K, V>, Compare, Allocator>;
+
+} // namespace cpp::collections
+
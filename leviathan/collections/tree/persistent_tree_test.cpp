@@ -0,0 +1,286 @@
+#include <catch2/catch_all.hpp>
+
+#include "persistent_tree.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <random>
+#include <ranges>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cpp::collections;
+
+template <typename Tree, typename StdSet>
+void check_same(const Tree& t, const StdSet& s)
+{
+    REQUIRE(t.size() == s.size());
+    REQUIRE(std::ranges::equal(t, s));
+    REQUIRE(std::ranges::equal(t | std::views::reverse, s | std::views::reverse));
+}
+
+TEST_CASE("persistent tree insert and erase")
+{
+    persistent_set<int> t;
+    std::set<int> s;
+    std::mt19937 random(0);
+
+    for (int i = 0; i < 20000; ++i)
+    {
+        const int x = random() % 2000;
+
+        if (random() % 3)
+        {
+            auto [it, ok] = t.insert(x);
+            CHECK(ok == s.insert(x).second);
+            CHECK(*it == x);
+        }
+        else
+        {
+            CHECK(t.erase(x) == s.erase(x));
+        }
+    }
+
+    check_same(t, s);
+
+    CHECK(*t.lower_bound(-1) == *s.begin());
+    CHECK(t.upper_bound(*s.rbegin()) == t.end());
+    CHECK(t.find(-1) == t.end());
+    CHECK(t.contains(*s.begin()));
+
+    auto it = t.erase(t.find(*s.begin()));
+    s.erase(s.begin());
+    CHECK(*it == *s.begin());
+
+    auto first = t.lower_bound(500);
+    auto last = t.lower_bound(1500);
+    it = t.erase(first, last);
+    s.erase(s.lower_bound(500), s.lower_bound(1500));
+    CHECK(*it == *s.lower_bound(1500));
+    check_same(t, s);
+
+    t.clear();
+    CHECK(t.empty());
+    CHECK(t.begin() == t.end());
+}
+
+TEST_CASE("persistent tree versions")
+{
+    persistent_set<int> t;
+    std::vector<persistent_set<int>> versions;
+    std::vector<std::set<int>> expected;
+    std::set<int> s;
+    std::mt19937 random(1);
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        const int x = random() % 500;
+
+        if (random() % 4)
+        {
+            t.insert(x);
+            s.insert(x);
+        }
+        else
+        {
+            t.erase(x);
+            s.erase(x);
+        }
+
+        if (i % 50 == 0)
+        {
+            versions.emplace_back(t.snapshot());
+            expected.emplace_back(s);
+        }
+    }
+
+    // The modification of a version never changes other versions.
+    for (std::size_t i = 0; i < versions.size(); ++i)
+    {
+        check_same(versions[i], expected[i]);
+    }
+
+    // Modify an old version.
+    auto old = versions.front();
+    auto old_expected = expected.front();
+
+    for (int x = 0; x < 500; x += 7)
+    {
+        old.insert(x);
+        old_expected.insert(x);
+    }
+
+    check_same(old, old_expected);
+    check_same(versions.front(), expected.front());
+    check_same(t, s);
+}
+
+TEST_CASE("persistent map")
+{
+    persistent_map<int, std::string> m;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        CHECK(m.emplace(i, std::to_string(i)).second);
+    }
+
+    auto copy = m;
+    CHECK(!m.emplace(1, "x").second);
+    CHECK(m.erase(1) == 1);
+    CHECK(m.emplace(1, "x").second);
+
+    CHECK(m.find(1)->second == "x");
+    CHECK(copy.find(1)->second == "1");
+    CHECK(m.size() == 100);
+    CHECK(copy.size() == 100);
+}
+
+// The copy constructor throws when copies_left reaches zero, a negative
+// copies_left never throws.
+struct throwing_copy
+{
+    inline static int copies_left = -1;
+    inline static int alive = 0;
+
+    int value;
+
+    throwing_copy(int value) : value(value) 
+    {
+        ++alive;
+    }
+
+    throwing_copy(const throwing_copy& other) : value(other.value)
+    {
+        if (copies_left >= 0 && copies_left-- == 0)
+        {
+            throw std::runtime_error("copy");
+        }
+        ++alive;
+    }
+
+    ~throwing_copy()
+    {
+        --alive;
+    }
+
+    auto operator<=>(const throwing_copy&) const = default;
+};
+
+TEST_CASE("persistent tree copy throws")
+{
+    {
+        persistent_set<throwing_copy> t;
+        std::set<throwing_copy> s;
+
+        for (int i = 0; i < 200; ++i)
+        {
+            t.emplace(i);
+            s.emplace(i);
+        }
+
+        int failures = 0;
+
+        // Each modification copies the shared nodes, let the copies throw at different points.
+        for (int limit = 0; limit < 60; ++limit)
+        {
+            const auto snapshot = t.snapshot();
+            const auto expected = s;
+            const throwing_copy x = limit % 2 ? limit * 3 : 1000 + limit;
+            bool thrown = false;
+
+            throwing_copy::copies_left = limit / 2;
+
+            try
+            {
+                if (limit % 2)
+                {
+                    t.erase(x);
+                }
+                else
+                {
+                    t.insert(x);
+                }
+            }
+            catch (const std::runtime_error&)
+            {
+                thrown = true;
+            }
+
+            throwing_copy::copies_left = -1;
+
+            if (thrown)
+            {
+                ++failures;
+            }
+            else if (limit % 2)
+            {
+                s.erase(x);
+            }
+            else
+            {
+                s.insert(x);
+            }
+
+            check_same(t, s);
+            check_same(snapshot, expected);
+        }
+
+        CHECK(failures > 0);
+        CHECK(failures < 60);
+    }
+
+    CHECK(throwing_copy::alive == 0);
+}
+
+TEST_CASE("persistent tree snapshots with threads")
+{
+    persistent_set<int> writer;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        writer.insert(i * 2);
+    }
+
+    std::vector<persistent_set<int>> snapshots;
+    std::atomic<bool> failed = false;
+
+    {
+        std::vector<std::jthread> readers;
+
+        // Each reader gets its own snapshot, the writer keeps modifying its version.
+        for (int t = 0; t < 4; ++t)
+        {
+            readers.emplace_back([&failed, snapshot = writer.snapshot()] {
+                for (int round = 0; round < 20; ++round)
+                {
+                    if (snapshot.size() != 1000 || !std::ranges::is_sorted(snapshot))
+                    {
+                        failed = true;
+                    }
+
+                    for (int i = 0; i < 1000; ++i)
+                    {
+                        if (!snapshot.contains(i * 2) || snapshot.contains(i * 2 + 1))
+                        {
+                            failed = true;
+                        }
+                    }
+                }
+            });
+        }
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            writer.insert(i * 2 + 1);
+            writer.erase(i * 2);
+        }
+    }
+
+    CHECK(!failed);
+    CHECK(writer.size() == 1000);
+    CHECK(*writer.begin() == 1);
+}
@@ -7,7 +7,13 @@
 namespace cpp::collections
 {
 
-struct red_black_node : binary_node_operation
+/**
+ * @brief Red black tree node.
+ * 
+ * @param Augmentation Data maintained for each subtree, see tree_node_operation.hpp
+*/
+template <typename Augmentation = empty_augmentation>
+struct basic_red_black_node : binary_node_operation, Augmentation
 {
     // Different from standard red black tree, we add another color sentinel, 
     // for each node except header, the color is red or black. And in this way, 
@@ -15,7 +21,7 @@ struct red_black_node : binary_node_operation
     // struct, it will always occupy sizeof(red_black_node*) bytes. 
     enum class color { red, black, sentinel };
 
-    red_black_node* m_link[3];
+    basic_red_black_node* m_link[3];
 
     color m_color;
 
@@ -40,9 +46,10 @@ struct red_black_node : binary_node_operation
         m_color = color::sentinel;
     }
 
-    void clone(const red_black_node* x)
+    void clone(const basic_red_black_node* x)
     {
         m_color = x->m_color;
+        static_cast<Augmentation&>(*this) = static_cast<const Augmentation&>(*x);
     }
 
     bool is_header() const
@@ -51,7 +58,7 @@ struct red_black_node : binary_node_operation
     }
 
     // Write insert_and_rebalance with red black tree fixup
-    void insert_and_rebalance(bool insert_left, red_black_node* p, red_black_node& header)
+    void insert_and_rebalance(bool insert_left, basic_red_black_node* p, basic_red_black_node& header)
     {
         this->insert_node_and_update_header(insert_left, p, header);
 
@@ -120,7 +127,7 @@ struct red_black_node : binary_node_operation
     }
 
     // Write rebalance_for_erase with red black tree fixup
-    red_black_node* rebalance_for_erase(red_black_node& header)
+    basic_red_black_node* rebalance_for_erase(basic_red_black_node& header)
     {
         auto [successor, child, child_parent] = this->replace_node_with_successor(header);
 
@@ -218,8 +225,131 @@ struct red_black_node : binary_node_operation
         return successor;
     }
 
+    // Join-based algorithms, see https://en.wikipedia.org/wiki/Join-based_tree_algorithms
+
+    /**
+     * @brief: Join left, mid and right into one tree. The keys in left are not 
+     *  greater than key of mid and the keys in right are not less than key of mid.
+     * 
+     * The black heights of left and right are passed by the caller, computing 
+     * them here needs to walk down the trees which makes split and join O(log(n)^2).
+     * 
+     * @param mid Detached node, the fields will be reset.
+     * @return: The new tree whose root is always black, the parent of root is unspecified.
+    */
+    static ranked_subtree<basic_red_black_node> join(const ranked_subtree<basic_red_black_node>& left, basic_red_black_node* mid, const ranked_subtree<basic_red_black_node>& right)
+    {
+        const int lh = left.rank;
+        const int rh = right.rank;
+
+        basic_red_black_node* root;
+
+        if (lh > rh)
+        {
+            root = join_right(left.root, mid, right.root, lh, rh);
+        }
+        else if (lh < rh)
+        {
+            root = join_left(left.root, mid, right.root, lh, rh);
+        }
+        else
+        {
+            mid->m_color = color::red;
+            mid->link_children(left.root, right.root);
+            root = mid;
+        }
+
+        // The black height of the new tree is max(lh, rh) before painting
+        // the root, and a red root can always be painted black.
+        const int h = std::max(lh, rh) + is_red(root);
+        root->m_color = color::black;
+        return { root, h };
+    }
+
+    static ranked_subtree<basic_red_black_node> make_ranked(basic_red_black_node* x)
+    {
+        return { x, black_height(x) };
+    }
+
+    // Return the children of t.root, call it before t.root is detached.
+    static std::pair<ranked_subtree<basic_red_black_node>, ranked_subtree<basic_red_black_node>> ranked_children(const ranked_subtree<basic_red_black_node>& t)
+    {
+        const int h = t.rank - !is_red(t.root);
+        return { { t.root->lchild(), h }, { t.root->rchild(), h } };
+    }
+
+private:
+
+    static bool is_red(const basic_red_black_node* x)
+    {
+        return x && x->m_color == color::red;
+    }
+
+    // The number of black nodes from x to leaf, the nullptr is not counted. O(log(n)).
+    static int black_height(const basic_red_black_node* x)
+    {
+        int h = 0;
+
+        for (; x; x = x->lchild())
+        {
+            h += x->m_color == color::black;
+        }
+
+        return h;
+    }
+
+    // Join along the right spine of left, lh and rh are black heights and lh >= rh.
+    static basic_red_black_node* join_right(basic_red_black_node* left, basic_red_black_node* mid, basic_red_black_node* right, int lh, int rh)
+    {
+        if (!is_red(left) && lh == rh)
+        {
+            mid->m_color = color::red;
+            mid->link_children(left, right);
+            return mid;
+        }
+
+        const bool black = !is_red(left);
+        auto t = join_right(left->rchild(), mid, right, lh - black, rh);
+        left->link_children(left->lchild(), t);
+
+        if (black && is_red(t) && is_red(t->rchild()))
+        {
+            t->rchild()->m_color = color::black;
+            return left->rotate_left_subtree();
+        }
+
+        return left;
+    }
+
+    // Join along the left spine of right, lh and rh are black heights and lh <= rh.
+    static basic_red_black_node* join_left(basic_red_black_node* left, basic_red_black_node* mid, basic_red_black_node* right, int lh, int rh)
+    {
+        if (!is_red(right) && lh == rh)
+        {
+            mid->m_color = color::red;
+            mid->link_children(left, right);
+            return mid;
+        }
+
+        const bool black = !is_red(right);
+        auto t = join_left(left, mid, right->lchild(), lh, rh - black);
+        right->link_children(t, right->rchild());
+
+        if (black && is_red(t) && is_red(t->lchild()))
+        {
+            t->lchild()->m_color = color::black;
+            return right->rotate_right_subtree();
+        }
+
+        return right;
+    }
 };
 
+using red_black_node = basic_red_black_node<>;
+
+// Red black tree node which supports order statistic.
+using indexed_red_black_node = basic_red_black_node<subtree_size_augmentation>;
+
 }  // namespace cpp::collections 
 
 
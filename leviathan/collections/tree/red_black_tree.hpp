@@ -19,5 +19,18 @@ using red_black_treemap = tree_map<red_black_node, K, V, Compare, Allocator>;
 template <typename K, typename V, typename Compare = std::less<K>, typename Allocator = std::allocator<std::pair<const K, V>>>
 using red_black_tree_multimap = tree_multimap<red_black_node, K, V, Compare, Allocator>;
 
+// Red black trees with nth_element and order_of_key.
+template <typename T, typename Compare = std::less<T>, typename Allocator = std::allocator<T>>
+using indexed_red_black_treeset = tree_set<indexed_red_black_node, T, Compare, Allocator>;
+
+template <typename T, typename Compare = std::less<T>, typename Allocator = std::allocator<T>>
+using indexed_red_black_tree_multiset = tree_multiset<indexed_red_black_node, T, Compare, Allocator>;
+
+template <typename K, typename V, typename Compare = std::less<K>, typename Allocator = std::allocator<std::pair<const K, V>>>
+using indexed_red_black_treemap = tree_map<indexed_red_black_node, K, V, Compare, Allocator>;
+
+template <typename K, typename V, typename Compare = std::less<K>, typename Allocator = std::allocator<std::pair<const K, V>>>
+using indexed_red_black_tree_multimap = tree_multimap<indexed_red_black_node, K, V, Compare, Allocator>;
+
 } // namespace cpp::collections
 
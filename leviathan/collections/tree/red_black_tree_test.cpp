@@ -21,49 +21,48 @@ using TreeWithAlloc = tree<::identity<T>, std::ranges::less, Alloc, true, red_bl
 
 #include "tree_test.inc"
 
-TEST_CASE("red_black_tree_color_test")
+struct ColorChecker
 {
-    Tree<int> avl;
-
-    struct ColorChecker
+    void operator()(red_black_node* node, int level = 0)
     {
-        void operator()(red_black_node* node, int level = 0)
+        if (node == nullptr)
         {
-            if (node == nullptr)
+            if (MaxBlackColorHeight == 0)
             {
-                if (MaxBlackColorHeight == 0)
-                {
-                    MaxBlackColorHeight = level;
-                }
-                else
-                {
-                    // The number of black nodes on the path from the root to the leaf should be the equal.
-                    CHECK(level == MaxBlackColorHeight);
-                }
-
-                return;
-            }
-
-            // Check red color node
-            if (node->m_color == red_black_node::color::red)
-            {
-                if (node->lchild() && node->lchild()->m_color == red_black_node::color::red)
-                    FAIL("red node has red left child");
-                if (node->rchild() && node->rchild()->m_color == red_black_node::color::red)
-                    FAIL("red node has red right child");
+                MaxBlackColorHeight = level;
             }
             else
             {
-                level++;
+                // The number of black nodes on the path from the root to the leaf should be the equal.
+                CHECK(level == MaxBlackColorHeight);
             }
 
-            (*this)(node->lchild(), level);
-            (*this)(node->rchild(), level);
+            return;
         }
 
-        int MaxBlackColorHeight = 0;  
-    };
+        // Check red color node
+        if (node->m_color == red_black_node::color::red)
+        {
+            if (node->lchild() && node->lchild()->m_color == red_black_node::color::red)
+                FAIL("red node has red left child");
+            if (node->rchild() && node->rchild()->m_color == red_black_node::color::red)
+                FAIL("red node has red right child");
+        }
+        else
+        {
+            level++;
+        }
+
+        (*this)(node->lchild(), level);
+        (*this)(node->rchild(), level);
+    }
 
+    int MaxBlackColorHeight = 0;  
+};
+
+TEST_CASE("red_black_tree_color_test")
+{
+    Tree<int> avl;
     Tree<int> random_tree;
     static std::random_device rd;
     for (auto i = 0; i < 1024; ++i) 
@@ -73,3 +72,45 @@ TEST_CASE("red_black_tree_color_test")
     // Logger::WriteMessage(avl.draw().c_str());
 }
 
+TEST_CASE("red_black_tree_order_statistic_test")
+{
+    CheckOrderStatistic<tree_set<indexed_red_black_node, int>, std::set<int>>();
+    CheckOrderStatistic<tree_multiset<indexed_red_black_node, int>, std::multiset<int>>();
+}
+
+TEST_CASE("red_black_tree_join_test")
+{
+    CheckJoinBasedAlgorithms<Tree<int>, TreeWithMultiKey<int>>();
+    CheckJoinBasedAlgorithms<tree_set<indexed_red_black_node, int>, tree_multiset<indexed_red_black_node, int>>();
+}
+
+TEST_CASE("red_black_tree_join_color_test")
+{
+    // The black heights are passed down through split and join instead of being
+    // recomputed, check the colors after each operation.
+    std::mt19937 gen(42);
+    std::vector<int> values(4096);
+    std::ranges::generate(values, [&]() { return static_cast<int>(gen() % 16384); });
+
+    Tree<int> tree(values.begin(), values.end());
+
+    for (int i = 0; i < 64; ++i)
+    {
+        auto right = tree.split(static_cast<int>(gen() % 16384));
+        ColorChecker()(tree.header()->parent());
+        ColorChecker()(right.header()->parent());
+
+        if (i % 2 == 0)
+        {
+            tree.join(std::move(right));
+        }
+        else
+        {
+            tree.set_union(std::move(right));
+        }
+
+        ColorChecker()(tree.header()->parent());
+    }
+
+    REQUIRE(std::ranges::equal(tree, std::set<int>(values.begin(), values.end())));
+}
@@ -2,10 +2,15 @@
 
 #include <leviathan/collections/common.hpp>
 #include <leviathan/collections/tree/tree_iterator.hpp>
+#include <leviathan/collections/tree/tree_node_operation.hpp>
 #include <leviathan/collections/tree/tree_drawer.hpp>
 #include <leviathan/collections/node_handle.hpp>
 #include <leviathan/collections/container_interface.hpp>
 
+#include <bit>
+#include <future>
+#include <thread>
+
 namespace cpp::collections
 { 
 
@@ -32,10 +37,38 @@ concept node = requires (Node* n, const Node* cn, bool insert_left, Node& header
 
     // Call after removing node.  
     n->rebalance_for_erase(header); 
+
+    // Optional, recompute the augmented data of the subtree rooted at n, it
+    // is called by the node operations after the children of n are changed, 
+    // see detail::augmented_node in tree_node_operation.hpp.
+    // n->augment();
+};
+
+// Node maintains the number of nodes of each subtree.
+template <typename Node>
+concept order_statistic_node = std::derived_from<Node, subtree_size_augmentation>;
+
+// Node supports join(left, mid, right) which is the base of join-based 
+// algorithms, see avl_node and red_black_node. The left and right subtrees
+// are passed with their ranks, see ranked_subtree in tree_node_operation.hpp.
+template <typename Node>
+concept joinable_node = requires (Node* n, const ranked_subtree<Node>& t)
+{
+    { Node::make_ranked(n) } -> std::same_as<ranked_subtree<Node>>;
+    { Node::ranked_children(t) } -> std::same_as<std::pair<ranked_subtree<Node>, ranked_subtree<Node>>>;
+    { Node::join(t, n, t) } -> std::same_as<ranked_subtree<Node>>;
 };
 
 } // namespace detail
 
+// Tag for constructing tree from a sorted range in linear time.
+struct from_sorted_range_t { explicit from_sorted_range_t() = default; };
+
+inline constexpr from_sorted_range_t from_sorted_range{};
+
+// Trees with at least this number of elements are copied by several threads.
+inline constexpr std::size_t parallel_copy_threshold = 1 << 16;
+
 /**
  * @brief Template for extended forms of binary search tree.
  * 
@@ -151,6 +184,27 @@ public:
     tree(std::from_range_t, R&& rg, const Allocator& alloc)
         : tree(std::ranges::begin(rg), std::ranges::end(rg), Compare(), alloc) { }
 
+    /**
+     * @brief: Build a balanced tree from rg in O(n).
+     * 
+     * The elements of rg should be sorted by comp, and there should be no
+     * equivalent elements for set/map.
+    */
+    template <container_compatible_range<value_type> R> 
+        requires (detail::joinable_node<Node> && (std::ranges::forward_range<R> || std::ranges::sized_range<R>))
+    tree(from_sorted_range_t, R&& rg, const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+        : tree(comp, alloc)
+    {
+        const auto n = static_cast<size_type>(std::ranges::distance(rg));
+        auto first = std::ranges::begin(rg);
+        assign_root(build_from_sorted(first, n), n);
+    }
+
+    template <container_compatible_range<value_type> R> 
+        requires (detail::joinable_node<Node> && (std::ranges::forward_range<R> || std::ranges::sized_range<R>))
+    tree(from_sorted_range_t, R&& rg, const Allocator& alloc)
+        : tree(from_sorted_range, (R&&)rg, Compare(), alloc) { }
+
     tree(const tree& other) 
         : tree(other, alloc_traits::select_on_container_copy_construction(other.m_alloc)) { }
 
@@ -310,6 +364,206 @@ public:
         return as_non_const(self).upper_bound_impl(x);
     }
 
+    // Order statistic, only available if Node maintains the size of subtrees.
+
+    /**
+     * @brief: Find the k-th(start from 0) smallest element in O(log(n)).
+     * @return: Iterator to the element or end() if k >= size().
+    */
+    template <typename Self>
+        requires detail::order_statistic_node<Node>
+    self_iter_t<Self> nth_element(this Self&& self, size_type k)
+    {
+        auto& t = as_non_const(self);
+
+        if (k >= t.size())
+        {
+            return t.end();
+        }
+
+        auto x = t.header()->parent();
+
+        while (true)
+        {
+            const auto left_size = subtree_size_augmentation::subtree_size(x->lchild());
+
+            if (k < left_size)
+            {
+                x = x->lchild();
+            }
+            else if (k == left_size)
+            {
+                return iterator(x);
+            }
+            else
+            {
+                k -= left_size + 1;
+                x = x->rchild();
+            }
+        }
+    }
+
+    /**
+     * @brief: Count the elements whose key is less than x in O(log(n)).
+     * @return: The index of lower_bound(x).
+    */
+    template <typename K = key_type>
+        requires detail::order_statistic_node<Node>
+    size_type order_of_key(const key_arg_t<K>& x) const
+    {
+        size_type rank = 0;
+
+        for (auto y = header()->parent(); y; )
+        {
+            if (m_cmp(keys(y), x))
+            {
+                rank += subtree_size_augmentation::subtree_size(y->lchild()) + 1;
+                y = y->rchild();
+            }
+            else
+            {
+                y = y->lchild();
+            }
+        }
+
+        return rank;
+    }
+
+    // Join-based algorithms, only available if Node supports join, see detail::joinable_node.
+    // No element is copied or moved, only the nodes are relinked. The allocators of 
+    // the trees should be equal. 
+
+    /**
+     * @brief: Move the elements whose key is not less than x into a new tree.
+     * 
+     * The time complexity is O(log(n)) if Node maintains the size of subtrees, 
+     * otherwise O(log(n) + k) where k is the size of the smaller part.
+     * 
+     * @return: The tree contains all elements in [lower_bound(x), end()).
+    */
+    template <typename Self, typename K = key_type>
+        requires detail::joinable_node<Node>
+    std::remove_cvref_t<Self> split(this Self& self, const key_arg_t<K>& x)
+    {
+        tree& left = self;
+        std::remove_cvref_t<Self> result(left.m_cmp, left.m_alloc);
+        tree& right = result;
+
+        if (left.empty())
+        {
+            return result;
+        }
+
+        const auto n = left.m_size;
+        auto [l, r] = left.split_nodes(left.release_root(), x);
+
+        left.assign_root(l, 0);
+        right.assign_root(r, 0);
+
+        if constexpr (detail::order_statistic_node<Node>)
+        {
+            left.m_size = subtree_size_augmentation::subtree_size(l.root);
+        }
+        else
+        {
+            // Count the smaller part.
+            size_type k = 0;
+            auto i = left.begin(), j = right.begin();
+
+            for (; i != left.end() && j != right.end(); ++i, ++j, ++k);
+
+            left.m_size = i == left.end() ? k : n - k;
+        }
+
+        right.m_size = n - left.m_size;
+        return result;
+    }
+
+    /**
+     * @brief: Move all elements of other into this tree in O(log(n)). The keys 
+     *  of other should be greater than(or equal to for multiset/multimap) the keys
+     *  of this tree.
+    */
+    void join(tree&& other)
+        requires detail::joinable_node<Node>
+    {
+        assert(get_allocator() == other.get_allocator() && "The allocators should be equal.");
+
+        if (this == std::addressof(other) || other.empty())
+        {
+            return;
+        }
+
+        assert(empty() || !m_cmp(keys(other.header()->lchild()), keys(header()->rchild())));
+
+        const auto n = m_size + other.m_size;
+        auto [mid, right] = other.split_first(other.release_root());
+        assign_root(node_base::join(release_root(), mid, right), n);
+    }
+
+    /**
+     * @brief: Merge all elements of other into this tree in O(m*log(n/m + 1)) where
+     *  m and n are the sizes of the smaller and larger tree. The elements in other 
+     *  whose key is equivalent to some key of this tree are destroyed.
+    */
+    void set_union(tree&& other)
+        requires (detail::joinable_node<Node> && UniqueKey)
+    {
+        assert(get_allocator() == other.get_allocator() && "The allocators should be equal.");
+
+        if (this == std::addressof(other))
+        {
+            return;
+        }
+
+        auto n = m_size + other.m_size;
+        auto drop = [&](node_base* x) {
+            drop_node(static_cast<tree_node*>(x));
+            --n;
+        };
+        auto root = union_nodes(release_root(), other.release_root(), drop);
+        assign_root(root, n);
+    }
+
+    /**
+     * @brief: Keep the elements whose key is equivalent to some key of other in 
+     *  O(m*log(n/m + 1)). All elements of other are destroyed.
+    */
+    void set_intersection(tree&& other)
+        requires (detail::joinable_node<Node> && UniqueKey)
+    {
+        assert(get_allocator() == other.get_allocator() && "The allocators should be equal.");
+
+        if (this == std::addressof(other))
+        {
+            return;
+        }
+
+        size_type n = 0;
+        auto root = intersection_nodes(release_root(), other.release_root(), n);
+        assign_root(root, n);
+    }
+
+    /**
+     * @brief: Erase the elements whose key is equivalent to some key of other in 
+     *  O(m*log(n/m + 1)). All elements of other are destroyed.
+    */
+    void set_difference(tree&& other)
+        requires (detail::joinable_node<Node> && UniqueKey)
+    {
+        assert(get_allocator() == other.get_allocator() && "The allocators should be equal.");
+
+        if (this == std::addressof(other))
+        {
+            clear();
+            return;
+        }
+
+        auto n = m_size;
+        auto root = difference_nodes(release_root(), other.release_root(), n);
+        assign_root(root, n);
+    }
+
     // Modifiers
     template <typename... Args>
     auto emplace(Args&&... args)
@@ -348,6 +602,45 @@ public:
         }
     }
 
+    /**
+     * @brief: Insert a new element as close as possible to the position just 
+     *  before hint. If the element should be placed next to hint, the insertion
+     *  is amortized O(1), otherwise the position is searched from root.
+     * 
+     * @return: Iterator to the inserted element or the element with equivalent key for set/map.
+    */
+    template <typename... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args)
+    {
+        auto node = create_node((Args&&)args...);
+
+        try
+        {
+            if constexpr (UniqueKey)
+            {
+                auto [x, p] = get_insert_hint_unique_pos(hint.base().link(), keys(node));
+    
+                if (p)
+                {
+                    return insert_node(x, p, node);
+                }
+    
+                drop_node(node);
+                return iterator(x);
+            }
+            else
+            {
+                auto [p, insert_left] = get_insert_hint_pos(hint.base().link(), keys(node));
+                return insert_node(insert_left, p, node);
+            }
+        }
+        catch (...)
+        {
+            drop_node(node);
+            throw;
+        }
+    }
+
     using erase_interface::erase;
 
     size_type erase(const key_type& key)
@@ -475,7 +768,46 @@ protected:
             return;
         }
 
-        if constexpr (UniqueKey)
+        if constexpr (detail::joinable_node<Node> && std::is_same_v<C2, Compare> && U2 == UniqueKey)
+        {
+            // Both trees are sorted by the same order, merge them by join-based 
+            // union in O(m*log(n/m + 1)) instead of inserting nodes one by one.
+            auto n = m_size + source.m_size;
+
+            if constexpr (UniqueKey)
+            {
+                // The duplicated nodes are visited in order, chain them by the right
+                // child and rebuild the source tree.
+                node_base* first = nullptr;
+                node_base* last = nullptr;
+                size_type cnt = 0;
+
+                auto keep = [&](node_base* x) {
+                    if (last)
+                    {
+                        last->rchild(x);
+                    }
+                    else
+                    {
+                        first = x;
+                    }
+
+                    last = x;
+                    ++cnt;
+                };
+
+                auto root = union_nodes(release_root(), source.release_root(), keep);
+                assign_root(root, n - cnt);
+                source.assign_root(source.build_from_list(first, cnt), cnt);
+            }
+            else
+            {
+                auto root = union_multi_nodes(release_root(), source.release_root());
+                assign_root(root, n);
+                source.m_size = 0;
+            }
+        }
+        else if constexpr (UniqueKey)
         {
             node_base* cur = source.header()->lchild();;
 
@@ -535,6 +867,280 @@ protected:
         }
     }
 
+    // Join-based algorithm helpers, the subtrees are represented by their roots 
+    // and ranks, and the parent of a root is unspecified. The rank of the whole 
+    // tree is computed once when the root is released, the ranks of subtrees are
+    // derived from their parents and returned by join.
+    using subtree = ranked_subtree<node_base>;
+
+    // Take all nodes away and reset the tree. 
+    subtree release_root()
+    {
+        auto root = header()->parent();
+        make_header_sentinel();
+        m_size = 0;
+        return node_base::make_ranked(root);
+    }
+
+    // Make root as the root of the tree which is empty.
+    void assign_root(subtree t, size_type n)
+    {
+        make_header_sentinel();
+        m_size = n;
+
+        if (auto root = t.root)
+        {
+            root->parent(header());
+            header()->parent(root);
+            header()->lchild(root->minimum());
+            header()->rchild(root->maximum());
+        }
+    }
+
+    // Join two subtrees, the keys of left are not greater than the keys of right.
+    subtree join_nodes(subtree left, subtree right)
+    {
+        if (!left.root)
+        {
+            return right;
+        }
+
+        auto [mid, rest] = split_first(right);
+        return mid ? node_base::join(left, mid, rest) : left;
+    }
+
+    // Detach the leftmost node of x. Return the leftmost node and the rest subtree.
+    std::pair<node_base*, subtree> split_first(subtree x)
+    {
+        if (!x.root)
+        {
+            return { nullptr, subtree() };
+        }
+
+        auto [l, r] = node_base::ranked_children(x);
+        reset_node(x.root);
+
+        if (!l.root)
+        {
+            return { x.root, r };
+        }
+
+        auto [first, rest] = split_first(l);
+        return { first, node_base::join(rest, x.root, r) };
+    }
+
+    // Split x into keys less than k and keys not less than k.
+    template <typename K>
+    std::pair<subtree, subtree> split_nodes(subtree x, const K& k)
+    {
+        if (!x.root)
+        {
+            return { subtree(), subtree() };
+        }
+
+        auto [l, r] = node_base::ranked_children(x);
+
+        if (m_cmp(keys(x.root), k))
+        {
+            auto [rl, rr] = split_nodes(r, k);
+            reset_node(x.root);
+            return { node_base::join(l, x.root, rl), rr };
+        }
+        else
+        {
+            auto [ll, lr] = split_nodes(l, k);
+            reset_node(x.root);
+            return { ll, node_base::join(lr, x.root, r) };
+        }
+    }
+
+    // Split x into keys less than k, the node equivalent to k and keys greater 
+    // than k. The keys of x should be unique. 
+    template <typename K>
+    std::tuple<subtree, node_base*, subtree> split_nodes_unique(subtree x, const K& k)
+    {
+        if (!x.root)
+        {
+            return { subtree(), nullptr, subtree() };
+        }
+
+        auto [l, r] = node_base::ranked_children(x);
+
+        if (m_cmp(k, keys(x.root)))
+        {
+            auto [ll, eq, lr] = split_nodes_unique(l, k);
+            reset_node(x.root);
+            return { ll, eq, node_base::join(lr, x.root, r) };
+        }
+        else if (m_cmp(keys(x.root), k))
+        {
+            auto [rl, eq, rr] = split_nodes_unique(r, k);
+            reset_node(x.root);
+            return { node_base::join(l, x.root, rl), eq, rr };
+        }
+        else
+        {
+            reset_node(x.root);
+            return { l, x.root, r };
+        }
+    }
+
+    // Union of x and y whose keys are unique, the nodes of y whose key is equivalent 
+    // to some key of x are passed to fn in order.
+    template <typename Fn>
+    subtree union_nodes(subtree x, subtree y, Fn& fn)
+    {
+        if (!x.root)
+        {
+            return y;
+        }
+
+        if (!y.root)
+        {
+            return x;
+        }
+
+        auto [l, r] = node_base::ranked_children(x);
+        auto [yl, eq, yr] = split_nodes_unique(y, keys(x.root));
+        reset_node(x.root);
+
+        auto left = union_nodes(l, yl, fn);
+
+        if (eq)
+        {
+            fn(eq);
+        }
+
+        auto right = union_nodes(r, yr, fn);
+        return node_base::join(left, x.root, right);
+    }
+
+    // Union of x and y, the nodes of y are placed after the equivalent nodes of x.
+    subtree union_multi_nodes(subtree x, subtree y)
+    {
+        if (!x.root)
+        {
+            return y;
+        }
+
+        if (!y.root)
+        {
+            return x;
+        }
+
+        auto [l, r] = node_base::ranked_children(x);
+        auto [yl, yr] = split_nodes(y, keys(x.root));
+        reset_node(x.root);
+
+        auto left = union_multi_nodes(l, yl);
+        auto right = union_multi_nodes(r, yr);
+        return node_base::join(left, x.root, right);
+    }
+
+    // Intersection of x and y whose keys are unique, n is the number of remaining nodes.
+    subtree intersection_nodes(subtree x, subtree y, size_type& n)
+    {
+        if (!x.root || !y.root)
+        {
+            dfs_destroy(x.root);
+            dfs_destroy(y.root);
+            return subtree();
+        }
+
+        auto [l, r] = node_base::ranked_children(x);
+        auto [yl, eq, yr] = split_nodes_unique(y, keys(x.root));
+        reset_node(x.root);
+
+        auto left = intersection_nodes(l, yl, n);
+        auto right = intersection_nodes(r, yr, n);
+
+        if (eq)
+        {
+            drop_node(static_cast<tree_node*>(eq));
+            ++n;
+            return node_base::join(left, x.root, right);
+        }
+
+        drop_node(static_cast<tree_node*>(x.root));
+        return join_nodes(left, right);
+    }
+
+    // Difference of x and y whose keys are unique, n is the number of remaining nodes.
+    subtree difference_nodes(subtree x, subtree y, size_type& n)
+    {
+        if (!x.root || !y.root)
+        {
+            dfs_destroy(y.root);
+            return x;
+        }
+
+        auto [l, r] = node_base::ranked_children(x);
+        auto [yl, eq, yr] = split_nodes_unique(y, keys(x.root));
+        reset_node(x.root);
+
+        auto left = difference_nodes(l, yl, n);
+        auto right = difference_nodes(r, yr, n);
+
+        if (eq)
+        {
+            drop_node(static_cast<tree_node*>(eq));
+            drop_node(static_cast<tree_node*>(x.root));
+            --n;
+            return join_nodes(left, right);
+        }
+
+        return node_base::join(left, x.root, right);
+    }
+
+    // Build a balanced tree with the next n elements from first.
+    template <typename I>
+    subtree build_from_sorted(I& first, size_type n)
+    {
+        if (n == 0)
+        {
+            return subtree();
+        }
+
+        auto left = build_from_sorted(first, (n - 1) / 2);
+        node_base* mid = nullptr;
+        subtree right;
+
+        try
+        {
+            mid = create_node(*first);
+            ++first;
+            right = build_from_sorted(first, n / 2);
+        }
+        catch (...)
+        {
+            dfs_destroy(left.root);
+
+            if (mid)
+            {
+                drop_node(static_cast<tree_node*>(mid));
+            }
+
+            throw;
+        }
+
+        return node_base::join(left, mid, right);
+    }
+
+    // Build a balanced tree with the next n nodes from the list linked by right child.
+    subtree build_from_list(node_base*& first, size_type n)
+    {
+        if (n == 0)
+        {
+            return subtree();
+        }
+
+        auto left = build_from_list(first, (n - 1) / 2);
+        auto mid = std::exchange(first, first->rchild());
+        reset_node(mid);
+        auto right = build_from_list(first, n / 2);
+        return node_base::join(left, mid, right);
+    }
+
     // Some helper functions for copy/move/swap elements from another tree
     template <typename Tree, typename Fn>
     void copy_or_move_from_another_tree(Tree&& other, Fn fn) 
@@ -550,11 +1156,9 @@ protected:
         else
         {
             // dfs_copy_or_move may throw exception!
-            auto root = dfs_copy_or_move(
-                header()->parent(), 
-                header(), 
-                other.header()->parent(), 
-                fn);
+            auto root = other.size() >= parallel_copy_threshold
+                ? dfs_parallel_copy_or_move(header()->parent(), header(), other.header()->parent(), fn, parallel_copy_depth())
+                : dfs_copy_or_move(header()->parent(), header(), other.header()->parent(), fn);
     
             header()->parent(root);
             header()->lchild(header()->parent()->minimum());
@@ -624,6 +1228,79 @@ protected:
         return x;
     }
 
+    // The nodes are allocated from several threads, so the allocator should be
+    // stateless. All workers share m_alloc, there is no per-thread allocator.
+    static int parallel_copy_depth()
+    {
+        if constexpr (std::is_empty_v<node_allocator> && node_alloc_traits::is_always_equal::value)
+        {
+            // The subtrees whose depth is less than the result are forked, so 
+            // there are at most 2^depth threads working at the same time.
+            return std::bit_width(std::thread::hardware_concurrency()) - 1;
+        }
+        else
+        {
+            return 0;
+        }
+    }
+
+    // Copy the left subtree by a worker thread and the right subtree by current 
+    // thread until depth is 0. Since the tree is balanced, the work is split evenly.
+    template <typename Fn>
+    node_base* dfs_parallel_copy_or_move(node_base*& x, node_base* p, node_base* y, Fn fn, int depth)
+    {
+        if (depth <= 0 || !y)
+        {
+            return dfs_copy_or_move(x, p, y, fn);
+        }
+
+        x = create_node(fn(static_cast<tree_node*>(y)->value()));
+        x->clone(y);
+        x->parent(p);
+
+        auto worker = [this, x, y, fn, depth]() {
+            node_base* root = nullptr;
+            
+            try
+            {
+                dfs_parallel_copy_or_move(root, x, y->lchild(), fn, depth - 1);
+            }
+            catch (...)
+            {
+                dfs_destroy(root);
+                throw;
+            }
+
+            return root;
+        };
+
+        auto left = std::async(std::launch::async, worker);
+
+        // The left subtree is linked after the worker finished. Before that, the 
+        // nodes created by current thread are still reachable from header and will 
+        // be destroyed if an exception is thrown.
+        try
+        {
+            x->rchild(dfs_parallel_copy_or_move(x->rchild(), x, y->rchild(), fn, depth - 1));
+        }
+        catch (...)
+        {
+            try
+            {
+                dfs_destroy(left.get());
+            }
+            catch (...)
+            {
+                // The worker has destroyed its nodes.
+            }
+
+            throw;
+        }
+
+        x->lchild(left.get());
+        return x;
+    }
+
     // Lookup helper
     template <typename K>
     iterator lower_bound_impl(const K& k) 
@@ -741,6 +1418,12 @@ protected:
     template <typename K>
     std::pair<node_base*, bool> get_insert_pos(const K& k)
     {
+        // Appending at the right edge is the most common case for sequential workloads.
+        if (m_size > 0 && !m_cmp(k, keys(header()->rchild())))
+        {
+            return { header()->rchild(), false };
+        }
+
         auto y = &m_header, x = header()->parent();
         bool comp = true;
 
@@ -754,10 +1437,33 @@ protected:
         return { y, comp };
     }
 
+    // Find the position before all equivalent keys.
+    template <typename K>
+    std::pair<node_base*, bool> get_insert_lower_pos(const K& k)
+    {
+        auto y = &m_header, x = header()->parent();
+        bool comp = true;
+
+        while (x)
+        {
+            y = x;
+            comp = !m_cmp(keys(x), k);
+            x = comp ? x->lchild() : x->rchild();
+        }
+
+        return { y, comp };
+    }
+
     // Find the position that the x will be inserted
     template <typename K>
     std::pair<node_base*, node_base*> get_insert_unique_pos(const K& k)
     {
+        // Appending at the right edge is the most common case for sequential workloads.
+        if (m_size > 0 && m_cmp(keys(header()->rchild()), k))
+        {
+            return { nullptr, header()->rchild() };
+        }
+
         auto y = &m_header, x = header()->parent();
         bool comp = true;
 
@@ -790,6 +1496,119 @@ protected:
         return { j.link(), nullptr };
     }
 
+    // Check the neighbours of pos, the result has the same meaning as get_insert_unique_pos.
+    template <typename K>
+    std::pair<node_base*, node_base*> get_insert_hint_unique_pos(node_base* pos, const K& k)
+    {
+        if (pos == header())
+        {
+            return get_insert_unique_pos(k);
+        }
+
+        if (m_cmp(k, keys(pos)))
+        {
+            // before < k < pos
+            if (pos == header()->lchild())
+            {
+                return { pos, pos };
+            }
+
+            auto before = pos->decrement();
+
+            if (!m_cmp(keys(before), k))
+            {
+                return get_insert_unique_pos(k);
+            }
+
+            if (before->rchild())
+            {
+                return { pos, pos };
+            }
+
+            return { nullptr, before };
+        }
+
+        if (m_cmp(keys(pos), k))
+        {
+            // pos < k < after
+            if (pos == header()->rchild())
+            {
+                return { nullptr, pos };
+            }
+
+            auto after = pos->increment();
+
+            if (!m_cmp(k, keys(after)))
+            {
+                return get_insert_unique_pos(k);
+            }
+
+            if (pos->rchild())
+            {
+                return { after, after };
+            }
+
+            return { nullptr, pos };
+        }
+
+        // Equivalent key
+        return { pos, nullptr };
+    }
+
+    // Check the neighbours of pos, the result has the same meaning as get_insert_pos.
+    template <typename K>
+    std::pair<node_base*, bool> get_insert_hint_pos(node_base* pos, const K& k)
+    {
+        if (pos == header())
+        {
+            return get_insert_pos(k);
+        }
+
+        if (!m_cmp(keys(pos), k))
+        {
+            // before <= k <= pos
+            if (pos == header()->lchild())
+            {
+                return { pos, true };
+            }
+
+            auto before = pos->decrement();
+
+            if (m_cmp(k, keys(before)))
+            {
+                return get_insert_pos(k);
+            }
+
+            if (before->rchild())
+            {
+                return { pos, true };
+            }
+
+            return { before, false };
+        }
+
+        // pos < k <= after
+        if (pos == header()->rchild())
+        {
+            return { pos, false };
+        }
+
+        auto after = pos->increment();
+
+        if (m_cmp(keys(after), k))
+        {
+            // The hint is before the equivalent keys.
+            return get_insert_lower_pos(k);
+        }
+
+        if (pos->rchild())
+        {
+            return { after, true };
+        }
+
+        return { pos, false };
+    }
+
     // Remove helpers
     void erase_by_node(node_base* x)
     {      
@@ -1194,4 +2013,4 @@ using tree_map = associative_tree<select1st<K, V>, Compare, Allocator, true, Nod
 template <typename Node, typename K, typename V, typename Compare = std::less<K>, typename Allocator = std::allocator<std::pair<const K, V>>>
 using tree_multimap = associative_tree<select1st<K, V>, Compare, Allocator, false, Node>;
 
-}  // namespace cpp::collections
\ No newline at end of file
+}  // namespace cpp::collections
\ No newline at end of file
@@ -12,6 +12,61 @@
 namespace cpp::collections
 {
 
+namespace detail
+{
+
+// Node maintains some data of its subtree, such as the number of nodes.
+template <typename Node>
+concept augmented_node = requires (Node* n) { n->augment(); };
+
+} // namespace detail
+
+/**
+ * @brief Augmentation which maintains nothing.
+ * 
+ * The augmentation is a base class of tree node which maintains some data 
+ * of the subtree rooted at the node. It should offer a method augment to 
+ * recompute the data from the children, and the method will be called by
+ * the node operations whenever the children of a node are changed.
+*/
+struct empty_augmentation { };
+
+/**
+ * @brief Maintain the number of nodes of each subtree.
+ * 
+ * The tree can find the k-th element and the rank of an element in O(log(n)).
+*/
+struct subtree_size_augmentation
+{
+    std::size_t m_subtree_size;
+
+    template <typename Node>
+    void augment(this Node& self)
+    {
+        self.m_subtree_size = subtree_size(self.lchild()) + subtree_size(self.rchild()) + 1;
+    }
+
+    static std::size_t subtree_size(const subtree_size_augmentation* node)
+    {
+        return node ? node->m_subtree_size : 0;
+    }
+};
+
+/**
+ * @brief Root of a detached subtree and its rank, used by join-based algorithms.
+ * 
+ * The rank is the height for AVL tree and the black height for red black tree.
+ * The black height is not stored in the node, so it is computed once for the
+ * whole tree and passed down through split and join instead of walking down
+ * the subtree for each join.
+*/
+template <typename Node>
+struct ranked_subtree
+{
+    Node* root = nullptr;
+    int rank = 0;
+};
+
 // The operation is based on tree.hpp
 struct basic_tree_node_operation
 {
@@ -169,6 +224,12 @@ struct binary_node_operation : basic_tree_node_operation
         
         y->lchild(x);
         x->parent(y);
+
+        if constexpr (detail::augmented_node<Node>)
+        {
+            x->augment();
+            y->augment();
+        }
     }
 
     /*
@@ -206,6 +267,68 @@ struct binary_node_operation : basic_tree_node_operation
         
         y->rchild(x);
         x->parent(y);
+
+        if constexpr (detail::augmented_node<Node>)
+        {
+            x->augment();
+            y->augment();
+        }
+    }
+
+    // Link l and r as the children of current node, used by join-based algorithms.
+    template <typename Node>
+    void link_children(this Node& self, std::type_identity_t<Node>* l, std::type_identity_t<Node>* r)
+    {
+        auto x = std::addressof(self);
+
+        x->lchild(l);
+        x->rchild(r);
+
+        if (l)
+        {
+            l->parent(x);
+        }
+
+        if (r)
+        {
+            r->parent(x);
+        }
+
+        if constexpr (detail::augmented_node<Node>)
+        {
+            x->augment();
+        }
+    }
+
+    // Rotate the subtree rooted at current node and return the new root, the 
+    // child link of the parent of current node is not updated.
+    template <typename Node>
+    Node* rotate_left_subtree(this Node& self)
+    {
+        auto root = std::addressof(self);
+        root->rotate_left(root);
+        return root;
+    }
+
+    template <typename Node>
+    Node* rotate_right_subtree(this Node& self)
+    {
+        auto root = std::addressof(self);
+        root->rotate_right(root);
+        return root;
+    }
+
+    // Recompute the augmented data from current node to root.
+    template <typename Node>
+    void augment_to_root(this Node& self, Node& header)
+    {
+        if constexpr (detail::augmented_node<Node>)
+        {
+            for (auto x = std::addressof(self); x != &header; x = x->parent())
+            {
+                x->augment();
+            }
+        }
     }
 
     // Insert node to binary tree and update header.
@@ -240,6 +363,8 @@ struct binary_node_operation : basic_tree_node_operation
                 rightmost = x;
             }
         }
+
+        x->augment_to_root(header);
     }
 
     // Replace node with successor and return successor.
@@ -354,6 +479,9 @@ struct binary_node_operation : basic_tree_node_operation
             }
         }
 
+        // The nodes from child_parent to root lost one descendant.
+        child_parent->augment_to_root(header);
+
         return { successor, child, child_parent };
     }
 };
@@ -14,6 +14,7 @@
 #include "meta.hpp"
 #include "random_generator.hpp"
 #include "ranges.hpp"
+#include "seeded_hash.hpp"
 #include "string.hpp"
 #include "time.hpp"
 #include "tuple.hpp"
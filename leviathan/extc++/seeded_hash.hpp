@@ -0,0 +1,237 @@
+/**
+ * A fast seeded hash function for byte sequences, in the style of wyhash/rapidhash.
+ *
+ * std::hash<std::string_view> is unseeded, so an attacker who controls the
+ * keys(e.g. the keys of a JSON object from network) can craft many keys with
+ * the same hash code and turn each hashtable operation into a linear scan.
+ * The functions here mix a seed into every step, the default seed is chosen
+ * randomly once per process.
+ *
+ * Each step multiplies two 64-bit words into 128 bits and folds the halves(mum).
+ * Long inputs are split into several independent lanes so that the multiplications
+ * of different lanes can be executed in parallel.
+ *
+ * The hash code depends on the seed, so it should never be persisted unless an
+ * explicit seed is used.
+*/
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string_view>
+#include <type_traits>
+
+namespace cpp
+{
+
+namespace detail
+{
+
+inline constexpr std::uint64_t hash_secret[8] = {
+    0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull,
+    0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x90ed1765281c388cull, 0xaaaaaaaaaaaaaaaaull
+};
+
+// Multiply a and b into 128 bits, store the low half in a and the high half in b.
+constexpr void hash_mum(std::uint64_t& a, std::uint64_t& b)
+{
+#if defined(__SIZEOF_INT128__)
+    const auto r = static_cast<unsigned __int128>(a) * b;
+    a = static_cast<std::uint64_t>(r);
+    b = static_cast<std::uint64_t>(r >> 64);
+#else
+    const std::uint64_t ha = a >> 32, hb = b >> 32, la = static_cast<std::uint32_t>(a), lb = static_cast<std::uint32_t>(b);
+    const std::uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    const std::uint64_t t = rl + (rm0 << 32);
+    std::uint64_t lo = t + (rm1 << 32);
+    std::uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + (t < rl) + (lo < t);
+    a = lo;
+    b = hi;
+#endif
+}
+
+constexpr std::uint64_t hash_mix(std::uint64_t a, std::uint64_t b)
+{
+    hash_mum(a, b);
+    return a ^ b;
+}
+
+// The hash code is only used in current machine, so native byte order is fine.
+inline std::uint64_t hash_read64(const unsigned char* p)
+{
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline std::uint64_t hash_read32(const unsigned char* p)
+{
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+} // namespace detail
+
+/**
+ * @brief: Hash len bytes from data with seed.
+*/
+inline std::uint64_t hash_bytes(const void* data, std::size_t len, std::uint64_t seed)
+{
+    using detail::hash_secret;
+    using detail::hash_mix;
+    using detail::hash_read64;
+    using detail::hash_read32;
+
+    auto p = static_cast<const unsigned char*>(data);
+    std::uint64_t a, b;
+
+    seed ^= hash_mix(seed ^ hash_secret[0], hash_secret[1]);
+
+    if (len <= 16)
+    {
+        if (len >= 4)
+        {
+            // Two overlapped reads cover all bytes for 4 <= len <= 16.
+            const auto delta = (len >> 3) << 2;
+            a = (hash_read32(p) << 32) | hash_read32(p + delta);
+            b = (hash_read32(p + len - 4) << 32) | hash_read32(p + len - 4 - delta);
+        }
+        else if (len > 0)
+        {
+            a = (std::uint64_t(p[0]) << 56) | (std::uint64_t(p[len >> 1]) << 32) | p[len - 1];
+            b = 0;
+        }
+        else
+        {
+            a = b = 0;
+        }
+    }
+    else
+    {
+        auto i = len;
+
+        if (i > 48)
+        {
+            auto see1 = seed, see2 = seed;
+
+            // Long path, six independent lanes consume 96 bytes per step.
+            if (i > 96)
+            {
+                auto see3 = seed, see4 = seed, see5 = seed;
+
+                do
+                {
+                    seed = hash_mix(hash_read64(p) ^ hash_secret[0], hash_read64(p + 8) ^ seed);
+                    see1 = hash_mix(hash_read64(p + 16) ^ hash_secret[1], hash_read64(p + 24) ^ see1);
+                    see2 = hash_mix(hash_read64(p + 32) ^ hash_secret[2], hash_read64(p + 40) ^ see2);
+                    see3 = hash_mix(hash_read64(p + 48) ^ hash_secret[3], hash_read64(p + 56) ^ see3);
+                    see4 = hash_mix(hash_read64(p + 64) ^ hash_secret[4], hash_read64(p + 72) ^ see4);
+                    see5 = hash_mix(hash_read64(p + 80) ^ hash_secret[5], hash_read64(p + 88) ^ see5);
+                    p += 96;
+                    i -= 96;
+                } while (i > 96);
+
+                seed ^= see3;
+                see1 ^= see4;
+                see2 ^= see5;
+            }
+
+            while (i > 48)
+            {
+                seed = hash_mix(hash_read64(p) ^ hash_secret[0], hash_read64(p + 8) ^ seed);
+                see1 = hash_mix(hash_read64(p + 16) ^ hash_secret[1], hash_read64(p + 24) ^ see1);
+                see2 = hash_mix(hash_read64(p + 32) ^ hash_secret[2], hash_read64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            }
+
+            seed ^= see1 ^ see2;
+        }
+
+        while (i > 16)
+        {
+            seed = hash_mix(hash_read64(p) ^ hash_secret[1], hash_read64(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+
+        // The last 16 bytes, may overlap with the bytes already consumed.
+        a = hash_read64(p + i - 16);
+        b = hash_read64(p + i - 8);
+    }
+
+    a ^= hash_secret[1];
+    b ^= seed;
+    detail::hash_mum(a, b);
+    return hash_mix(a ^ hash_secret[7] ^ len, b ^ hash_secret[1]);
+}
+
+/**
+ * @brief: The random seed of current process, it is generated at the first call.
+*/
+inline std::uint64_t process_hash_seed()
+{
+    static const std::uint64_t seed = [] {
+        std::random_device rd;
+        std::uint64_t s = (std::uint64_t(rd()) << 32) ^ rd();
+
+        // std::random_device may be deterministic on some platforms,
+        // the address(ASLR) and the clock are mixed in as well.
+        s ^= reinterpret_cast<std::uintptr_t>(&rd);
+        s ^= static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+        return detail::hash_mix(s ^ detail::hash_secret[2], detail::hash_secret[3]);
+    }();
+
+    return seed;
+}
+
+/**
+ * @brief: Seeded hasher for strings and objects whose bytes are their values.
+ *
+ * The default constructed hasher uses process_hash_seed(), use an explicit
+ * seed if the hash codes need to be the same across processes.
+ *
+ * It is transparent, so a table with std::string keys can be searched with
+ * std::string_view or const char* directly.
+*/
+class seeded_hash
+{
+public:
+
+    using is_transparent = void;
+
+    seeded_hash() : m_seed(process_hash_seed()) { }
+
+    explicit seeded_hash(std::uint64_t seed) : m_seed(seed) { }
+
+    template <typename Str>
+        requires std::is_convertible_v<const Str&, std::string_view>
+    std::size_t operator()(const Str& s) const
+    {
+        const std::string_view sv = s;
+        return static_cast<std::size_t>(hash_bytes(sv.data(), sv.size(), m_seed));
+    }
+
+    template <typename T>
+        requires (!std::is_convertible_v<const T&, std::string_view> && std::has_unique_object_representations_v<T>)
+    std::size_t operator()(const T& x) const
+    {
+        return static_cast<std::size_t>(hash_bytes(std::addressof(x), sizeof(T), m_seed));
+    }
+
+    std::uint64_t seed() const
+    {
+        return m_seed;
+    }
+
+private:
+
+    std::uint64_t m_seed;
+};
+
+} // namespace cpp
+
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "seeded_hash.hpp"
+
 #include <format>
 #include <string>
 #include <string_view>
@@ -18,6 +20,9 @@ concept string_view_like = string_viewable<T> && !std::is_convertible_v<const T&
 // This overload participates in overload resolution only if 
 // Hash::is_transparent and KeyEqual::is_transparent are valid and each denotes a type
 // https://en.cppreference.com/w/cpp/container/unordered_map/find
+//
+// The hash code is seeded with cpp::process_hash_seed(), so the keys from untrusted
+// input cannot be crafted to collide. Do not persist the hash code.
 struct string_hash_key_equal
 {
     using is_transparent = void;
@@ -31,7 +36,7 @@ struct string_hash_key_equal
     }
 
     template <string_viewable Str>
-    static constexpr bool operator()(const Str& s) 
+    static size_t operator()(const Str& s) 
     {
         std::string_view sv = static_cast<std::string_view>(s);
         return hash_impl(sv);
@@ -44,9 +49,9 @@ private:
         return lhs == rhs;
     }
 
-    static constexpr size_t hash_impl(std::string_view sv)
+    static size_t hash_impl(std::string_view sv)
     {
-        return std::hash<std::string_view>()(sv);
+        return static_cast<size_t>(cpp::hash_bytes(sv.data(), sv.size(), cpp::process_hash_seed()));
     }
 };
 